@@ -0,0 +1,328 @@
+/****************************************************************************
+**	INCLUDE
+****************************************************************************/
+
+//type definition using the bit width and signedness
+#include <stdint.h>
+//define the ISR routune, ISR vector, and the sei() cli() function
+#include <avr/interrupt.h>
+//name all the register and bit
+#include <avr/io.h>
+//General purpose macros
+#include "at_utils.h"
+//AT4809 PORT macros definitions
+#include "at4809_port.h"
+//Program wide definitions
+#include "global.h"
+
+/****************************************************************************
+**	GLOBAL VARS
+****************************************************************************/
+
+//Motors of the calibration. Written by main before CONTROL_CALIB, read by the control system
+volatile uint8_t g_calib_mask = 0;
+//Step of the ramp and control ticks spent in it. Control system only
+uint8_t g_calib_step = 0;
+uint16_t g_calib_tick = 0;
+//Encoder speed summed over the measure of the step. Control system only
+int32_t g_calib_sum[NUM_VNH7040];
+//Summed speed of each step of the ramp [counts per CALIB_MEASURE_TICKS]
+uint16_t g_calib_spd[NUM_VNH7040][CALIB_NUM_STEPS];
+//Ramp completed. Raised by the control system, cleared by main once the tables are built
+volatile bool g_f_calib_done = false;
+
+/****************************************************************************
+**	FUNCTION
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief function
+//!	calib_pwm | uint8_t
+/***************************************************************************/
+//! @param step | uint8_t | step of the ramp
+//! @return int16_t | PWM of the step
+/***************************************************************************/
+
+static int16_t calib_pwm( uint8_t step )
+{
+	return (int16_t)(((uint16_t)step *VNH7040_PWM_LIMIT) /(CALIB_NUM_STEPS -1));
+}	//End function: calib_pwm | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	calib_start | uint8_t
+/***************************************************************************/
+//! @param mask | uint8_t | motors to calibrate. Bit mask
+//! @return bool | false = OK | true = bad mask or a calibration is running
+//! @details
+//!	Called by main. Resets the ramp and asks the control system for CONTROL_CALIB
+//!	The motors of the mask need an encoder. The others are held at zero PWM
+/***************************************************************************/
+
+bool calib_start( uint8_t mask )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Save interrupt state
+	uint8_t sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: no motor, or a motor not installed or without encoder
+	if ((mask == 0) || ((mask & ~(MASK(NUM_VNH7040) -1)) != 0) || ((mask & ~(MASK(NUM_ENC) -1)) != 0))
+	{
+		return true;	//FAIL
+	}
+	//If: a calibration is running or its tables are not built yet
+	if ((g_control_mode == CONTROL_CALIB) || (g_control_mode_target == CONTROL_CALIB) || (g_f_calib_done == true))
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//The control system runs the ramp from inside an ISR. Start it atomically
+	sreg_tmp = SREG;
+	cli();
+	g_calib_mask = mask;
+	g_calib_step = 0;
+	g_calib_tick = 0;
+	for (t = 0;t < NUM_VNH7040;t++)
+	{
+		g_calib_sum[t] = 0;
+	}
+	g_control_mode_target = CONTROL_CALIB;
+	//Restore interrupt state
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: calib_start | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	calib_update | void
+/***************************************************************************/
+//! @return int16_t | PWM of the motors of g_calib_mask in this tick. -1 = ramp completed
+//! @details
+//!	Control system only, once per tick in CONTROL_CALIB. After process_enc
+//!	Sums the encoder speed over the second part of each step
+/***************************************************************************/
+
+int16_t calib_update( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Summed speed of a step
+	int32_t spd;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: ramp already completed
+	if (g_calib_step >= CALIB_NUM_STEPS)
+	{
+		return -1;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: the motors settled on the PWM of the step
+	if (g_calib_tick >= CALIB_SETTLE_TICKS)
+	{
+		//For: every motor of the calibration
+		for (t = 0;t < NUM_VNH7040;t++)
+		{
+			if (IS_BIT_ONE( g_calib_mask, t ))
+			{
+				g_calib_sum[t] += g_enc_spd[t];
+			}
+		}
+	}
+	g_calib_tick++;
+	//If: step completed
+	if (g_calib_tick >= (CALIB_SETTLE_TICKS +CALIB_MEASURE_TICKS))
+	{
+		//For: every motor
+		for (t = 0;t < NUM_VNH7040;t++)
+		{
+			//Encoder sign depends on the layout. Only the magnitude is used
+			spd = (g_calib_sum[t] < 0) ? (-g_calib_sum[t]) : (g_calib_sum[t]);
+			g_calib_spd[t][g_calib_step] = (spd > UINT16_MAX) ? (UINT16_MAX) : ((uint16_t)spd);
+			g_calib_sum[t] = 0;
+		}
+		g_calib_tick = 0;
+		g_calib_step++;
+		//If: last step
+		if (g_calib_step >= CALIB_NUM_STEPS)
+		{
+			//Main builds the tables
+			g_f_calib_done = true;
+			return -1;
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return calib_pwm( g_calib_step );
+}	//End function: calib_update | void
+
+/***************************************************************************/
+//!	@brief function
+//!	calib_build_lut | uint8_t | uint8_t *
+/***************************************************************************/
+//! @param index | uint8_t | motor
+//! @param lut | uint8_t * | LIN_NUM_POINTS linearization table
+//! @return bool | false = OK | true = the motor did not move
+//! @details
+//!	The speed of each point of the table is proportional to its effort. Full effort is the top speed of the ramp
+//!	The first point is the PWM where the motor starts to move. The static friction offset
+//!	The PWM of each speed is interpolated between the steps of the ramp
+/***************************************************************************/
+
+static bool calib_build_lut( uint8_t index, uint8_t *lut )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counters
+	uint8_t t, k;
+	//Speed of each step, made non decreasing
+	uint16_t spd[CALIB_NUM_STEPS];
+	//Speed of a point of the table
+	uint32_t target;
+	//Effort of a point of the table
+	uint16_t effort;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Zero PWM does not move. Later steps never go slower than the ones before
+	spd[0] = 0;
+	for (k = 1;k < CALIB_NUM_STEPS;k++)
+	{
+		spd[k] = (g_calib_spd[index][k] > spd[k -1]) ? (g_calib_spd[index][k]) : (spd[k -1]);
+	}
+	//If: the motor never moved
+	if (spd[CALIB_NUM_STEPS -1] <= CALIB_MOVE_SPD)
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: every point of the table
+	for (t = 0;t < LIN_NUM_POINTS;t++)
+	{
+		//The last point is past full effort
+		effort = ((t *LIN_EFFORT_STEP) < VNH7040_PWM_LIMIT) ? (t *LIN_EFFORT_STEP) : (VNH7040_PWM_LIMIT);
+		target = ((uint32_t)spd[CALIB_NUM_STEPS -1] *effort) /VNH7040_PWM_LIMIT;
+		//The lowest speed of the table is the start of motion
+		if (target < CALIB_MOVE_SPD)
+		{
+			target = CALIB_MOVE_SPD;
+		}
+		//Find the first step at or above the speed. The step before is below it
+		k = 1;
+		while (spd[k] < target)
+		{
+			k++;
+		}
+		//Interpolate between the two steps
+		lut[t] = (uint8_t)(calib_pwm( k -1 ) +((uint32_t)(calib_pwm( k ) -calib_pwm( k -1 )) *(target -spd[k -1])) /(spd[k] -spd[k -1]));
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: calib_build_lut | uint8_t | uint8_t *
+
+/***************************************************************************/
+//!	@brief function
+//!	calib_process | void
+/***************************************************************************/
+//! @return bool | true = the tables were just updated
+//! @details
+//!	Called by the main loop. Does nothing until the control system completes a ramp
+//!	Each motor of the calibration gets a LOG_CALIB. A motor that did not move keeps its table
+//!	The tables are in use at once and kept in EEPROM by CFG_SAVE
+/***************************************************************************/
+
+bool calib_process( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Table of a motor
+	uint8_t lut[LIN_NUM_POINTS];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: no ramp completed
+	if (g_f_calib_done == false)
+	{
+		return false;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: every motor of the calibration
+	for (t = 0;t < NUM_VNH7040;t++)
+	{
+		if (IS_BIT_ONE( g_calib_mask, t ))
+		{
+			//If: table measured and accepted
+			if ((calib_build_lut( t, lut ) == false) && (config_set_lut( t, lut ) == false))
+			{
+				send_log( LOG_CALIB, t, lut[0] );
+			}
+			//If: the motor did not move
+			else
+			{
+				send_log( LOG_CALIB, t, -1 );
+			}
+		}
+	}
+	g_calib_mask = 0;
+	//A new calibration can start
+	g_f_calib_done = false;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return true;
+}	//End function: calib_process | void
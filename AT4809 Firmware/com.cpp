@@ -41,6 +41,10 @@
 
 //type definition using the bit width and signedness
 #include <stdint.h>
+//define the ISR routune, ISR vector, and the sei() cli() function
+#include <avr/interrupt.h>
+//name all the register and bit
+#include <avr/io.h>
 //General purpose macros
 #include "at_utils.h"
 //AT4809 PORT macros definitions
@@ -58,6 +62,21 @@
 **	GLOBAL VARIABILE
 ****************************************************************************/
 
+//Errors raised by the control system and waiting to be sent by the main loop. One bit per Error_code
+volatile uint16_t g_err_pending = 0;
+//Control system switched mode and the main loop has to send the CTRL message
+volatile bool g_f_ctrl_mode_pending = false;
+//Sequence number of the next telemetry message. Lets the RPI count lost messages
+uint8_t g_telemetry_seq = 0;
+//Log messages waiting for headroom in the TX buffer. Id and two arguments
+uint8_t g_log_id[ LOG_QUEUE_SIZE ];
+int16_t g_log_arg[ LOG_QUEUE_SIZE ][ 2 ];
+//Log messages queued and sent. Index is modulo LOG_QUEUE_SIZE
+volatile uint8_t g_log_top = 0;
+volatile uint8_t g_log_bot = 0;
+//Log messages lost because the queue was full
+volatile uint16_t g_log_dropped = 0;
+
 /****************************************************************************
 **	FUNCTION
 ****************************************************************************/
@@ -118,6 +137,51 @@ void report_error( Error_code err_code )
 	return;
 }	//End Function: error | Error_code
 
+/***************************************************************************/
+//!	@brief function
+//!	report_error_deferred | Error_code
+/***************************************************************************/
+//! @param err_code | (Error_code) caller report the error code experienced by the system
+//! @return void |
+//! @details
+//!	The control system can execute inside an ISR and is not allowed to touch the TX buffer
+//!	It raises the bit of the error instead and the main loop sends the message with send_deferred_msg
+//!	The same error raised multiple times before the flush is sent once
+/***************************************************************************/
+
+void report_error_deferred( Error_code err_code )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp = SREG;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Can be called from both main and ISR. Read modify write has to be atomic
+	cli();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Raise the bit of the error code
+	g_err_pending |= (uint16_t)MASK( (uint8_t)err_code );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Restore interrupt state
+	SREG = sreg_tmp;
+
+	return;
+}	//End Function: report_error_deferred | Error_code
+
 /***************************************************************************/
 //!	function
 //!	send_msg_ctrl_mode
@@ -198,6 +262,81 @@ void send_msg_ctrl_mode( void )
 	return;
 }	//End function: send_msg_ctrl_mode | void
 
+/***************************************************************************/
+//!	function
+//!	send_deferred_msg
+/***************************************************************************/
+//! @return void |
+//! @brief Send messages deferred by the real time control system
+//! @details
+//!	Meant to be called by the main loop. Fetch and clear pending messages atomically
+//!	then format them into the TX buffer outside of the critical section
+/***************************************************************************/
+
+void send_deferred_msg( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Local copy of the pending errors
+	uint16_t err_tmp;
+	//Local copy of the pending control mode message
+	bool f_ctrl_mode_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: nothing to send
+	if ((g_err_pending == 0) && (g_f_ctrl_mode_pending == false))
+	{
+		return;	//OK
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//! Fetch and clear pending messages
+	sreg_tmp = SREG;
+	cli();
+	err_tmp = g_err_pending;
+	g_err_pending = 0;
+	f_ctrl_mode_tmp = g_f_ctrl_mode_pending;
+	g_f_ctrl_mode_pending = false;
+	SREG = sreg_tmp;
+
+	//! Send messages
+	//If: control system switched mode
+	if (f_ctrl_mode_tmp == true)
+	{
+		//Send the current control mode
+		send_msg_ctrl_mode();
+	}
+	//For: each error code bit
+	for (t = 0;err_tmp != 0;t++)
+	{
+		//If: error is pending
+		if ((err_tmp & 0x0001) != 0)
+		{
+			report_error( (Error_code)t );
+		}
+		//Next error code
+		err_tmp >>= 1;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: send_deferred_msg | void
+
 /***************************************************************************/
 //!	function
 //!	send_pwm
@@ -268,4 +407,234 @@ void send_data( uint8_t data_len, int16_t *data )
 	//----------------------------------------------------------------
 	
 	return;
-}	//End function: send_pwm
\ No newline at end of file
+}	//End function: send_pwm
+
+/***************************************************************************/
+//!	function
+//!	send_timestamp | uint32_t
+/***************************************************************************/
+//! @param timestamp | RTC timestamp of the data in the telemetry message that follows
+//! @return void |
+//! @brief Send the timestamp and sequence number of the next telemetry message
+//! @details
+//!	TIME<timestamp>:<sequence>
+//!	The RPI stamps the next telemetry message with it and counts gaps in the sequence
+/***************************************************************************/
+
+void send_timestamp( uint32_t timestamp )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint32_t
+	uint8_t str[MAX_STRING32];
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	AT_BUF_PUSH( rpi_tx_buf, 'M' );
+	AT_BUF_PUSH( rpi_tx_buf, 'E' );
+	//Construct timestamp string
+	ret = u32_to_str( timestamp, str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send argument separator
+	AT_BUF_PUSH( rpi_tx_buf, ':' );
+	//Construct sequence string
+	ret = u8_to_str( g_telemetry_seq, str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+	//Next telemetry message
+	g_telemetry_seq++;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: send_timestamp | uint32_t
+
+/***************************************************************************/
+//!	function
+//!	send_log | uint8_t, int16_t, int16_t
+/***************************************************************************/
+//! @param id | LOG_* id in orangebot_config.h
+//! @param arg0 | first argument of the log text
+//! @param arg1 | second argument of the log text
+//! @return void |
+//! @brief Queue a log message
+//! @details
+//!	Safe from ISR and main. Nothing is formatted here, the message is sent later by send_log_msg
+//!	If the queue is full the message is counted and dropped. The RPI is told with LOG_DROPPED
+/***************************************************************************/
+
+void send_log( uint8_t id, int16_t arg0, int16_t arg1 )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp = SREG;
+	//Slot of the message
+	uint8_t slot;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Can be called from both main and ISR. Queue update has to be atomic
+	cli();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: queue is full
+	if ((uint8_t)(g_log_top -g_log_bot) >= LOG_QUEUE_SIZE)
+	{
+		//Saturate the count
+		if (g_log_dropped < INT16_MAX)
+		{
+			g_log_dropped++;
+		}
+	}
+	else
+	{
+		slot = g_log_top & (LOG_QUEUE_SIZE -1);
+		g_log_id[ slot ] = id;
+		g_log_arg[ slot ][ 0 ] = arg0;
+		g_log_arg[ slot ][ 1 ] = arg1;
+		g_log_top++;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Restore interrupt state
+	SREG = sreg_tmp;
+
+	return;
+}	//End function: send_log | uint8_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	function
+//!	send_log_msg | void
+/***************************************************************************/
+//! @return void |
+//! @brief Send one queued log message
+//! @details
+//!	Meant to be called by the main loop after the control replies
+//!	LOG<id>:<arg0>:<arg1>
+//!	Lower priority than control replies: a message is sent only if it leaves LOG_TX_HEADROOM free bytes in the TX buffer
+//!	Lost messages are reported first as LOG_DROPPED
+/***************************************************************************/
+
+void send_log_msg( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return
+	uint8_t ret;
+	//Temp string sized for an int16_t
+	uint8_t str[MAX_STRING16];
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Message to send
+	uint8_t id;
+	int16_t arg[2];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: nothing to send
+	if ((g_log_top == g_log_bot) && (g_log_dropped == 0))
+	{
+		return;	//OK
+	}
+	//If: the message would eat into the room of the control replies
+	if ((RPI_TX_BUF_SIZE -1 -AT_BUF_NUMELEM( rpi_tx_buf )) < (LOG_MSG_MAX_LENGTH +LOG_TX_HEADROOM))
+	{
+		return;	//Try again on the next main loop
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//! Fetch the message
+	sreg_tmp = SREG;
+	cli();
+	//If: messages were lost. Tell first
+	if (g_log_dropped != 0)
+	{
+		id = LOG_DROPPED;
+		arg[0] = (int16_t)g_log_dropped;
+		arg[1] = 0;
+		g_log_dropped = 0;
+	}
+	else
+	{
+		t = g_log_bot & (LOG_QUEUE_SIZE -1);
+		id = g_log_id[ t ];
+		arg[0] = g_log_arg[ t ][ 0 ];
+		arg[1] = g_log_arg[ t ][ 1 ];
+		g_log_bot++;
+	}
+	SREG = sreg_tmp;
+
+	//! Send the message
+	AT_BUF_PUSH( rpi_tx_buf, 'L' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	//Construct id string
+	ret = u8_to_str( id, str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send arguments
+	for (uint8_t ti = 0;ti < 2;ti++)
+	{
+		//Send argument separator
+		AT_BUF_PUSH( rpi_tx_buf, ':' );
+		//Construct argument string
+		ret = s16_to_str( arg[ti], str );
+		//For each string character
+		for (t = 0;t < ret;t++)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, str[t] );
+		}
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: send_log_msg | void
@@ -0,0 +1,646 @@
+/****************************************************************************
+**	INCLUDE
+****************************************************************************/
+
+//type definition using the bit width and signedness
+#include <stdint.h>
+//define the ISR routune, ISR vector, and the sei() cli() function
+#include <avr/interrupt.h>
+//name all the register and bit
+#include <avr/io.h>
+//CRC16 CCITT
+#include <util/crc16.h>
+//General purpose macros
+#include "at_utils.h"
+//AT4809 PORT macros definitions
+#include "at4809_port.h"
+//Program wide definitions
+#include "global.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//g_config_save_index when no save is running
+#define CONFIG_SAVE_IDLE		0xff
+
+/****************************************************************************
+**	GLOBAL VARS
+****************************************************************************/
+
+//Parameters in use. Written only by main through config_set, read by the ISRs
+Config g_config;
+//Outcome of the load at boot
+Config_status g_config_status = CONFIG_BLANK;
+//Version of the block found in EEPROM at boot
+uint8_t g_config_version_found = 0xff;
+//Image being written in EEPROM. A CFG_SET during the save can't tear it
+Config g_config_save;
+//Next byte of the image to write. CONFIG_SAVE_IDLE = no save
+uint8_t g_config_save_index = CONFIG_SAVE_IDLE;
+
+/****************************************************************************
+**	FUNCTION
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief function
+//!	config_crc | const uint8_t * | uint8_t
+/***************************************************************************/
+//! @param data | const uint8_t * | block
+//! @param size | uint8_t | bytes before the crc field
+//! @return uint16_t | CRC16 CCITT of the block up to the crc field
+//! @details
+//!	Takes the size so it can check a block of an older version
+/***************************************************************************/
+
+static uint16_t config_crc( const uint8_t *data, uint8_t size )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//CRC
+	uint16_t crc = 0xffff;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: every byte before the crc field
+	for (t = 0;t < size;t++)
+	{
+		crc = _crc_ccitt_update( crc, data[t] );
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return crc;
+}	//End function: config_crc | const uint8_t * | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	config_check_lut | const uint8_t *
+/***************************************************************************/
+//! @param lut | const uint8_t * | LIN_NUM_POINTS linearization table
+//! @return bool | false = OK | true = above the hardware limit or decreasing
+//! @details
+//!	A decreasing table would make the closed loop push the wrong way
+/***************************************************************************/
+
+static bool config_check_lut( const uint8_t *lut )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: last point is the highest
+	if (lut[LIN_NUM_POINTS -1] > VNH7040_PWM_LIMIT)
+	{
+		return true;	//FAIL
+	}
+	//For: every segment
+	for (t = 1;t < LIN_NUM_POINTS;t++)
+	{
+		//If: decreasing
+		if (lut[t] < lut[t -1])
+		{
+			return true;	//FAIL
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: config_check_lut | const uint8_t *
+
+/***************************************************************************/
+//!	@brief function
+//!	config_default_lut | Config & | uint8_t
+/***************************************************************************/
+//! @param config | Config & | parameters
+//! @param index | uint8_t | VNH7040 channel
+//! @return void
+//! @details
+//!	Line from the static friction offset pwm_min at the first point to VNH7040_PWM_LIMIT at full effort
+//!	Same output as a dead zone of pwm_min, without the jump from zero
+/***************************************************************************/
+
+static void config_default_lut( Config &config, uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Effort of a point
+	int16_t effort;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: every point
+	for (t = 0;t < LIN_NUM_POINTS;t++)
+	{
+		//The last point is past full effort
+		effort = ((t *LIN_EFFORT_STEP) < VNH7040_PWM_LIMIT) ? (t *LIN_EFFORT_STEP) : (VNH7040_PWM_LIMIT);
+		config.lin_lut[index][t] = (uint8_t)(config.pwm_min +((VNH7040_PWM_LIMIT -config.pwm_min) *effort) /VNH7040_PWM_LIMIT);
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: config_default_lut | Config & | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	config_check | const Config &
+/***************************************************************************/
+//! @param config | const Config & | parameters
+//! @return bool | false = OK | true = a parameter is out of range
+//! @details
+//!	Same checks for a block loaded from EEPROM and for a CFG_SET
+/***************************************************************************/
+
+static bool config_check( const Config &config )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: PWM limits
+	if ((config.pwm_min < 0) || (config.pwm_min >= config.pwm_max) || (config.pwm_max > VNH7040_PWM_LIMIT))
+	{
+		return true;	//FAIL
+	}
+	//If: PWM slopes. Zero would freeze the channels
+	if ((config.pwm_accel <= 0) || (config.pwm_accel > VNH7040_PWM_LIMIT) || (config.pwm_decel <= 0) || (config.pwm_decel > VNH7040_PWM_LIMIT))
+	{
+		return true;	//FAIL
+	}
+	//If: reverse mask names a driver not installed
+	if ((config.layout_reverse & ~(MASK(NUM_VNH7040) -1)) != 0)
+	{
+		return true;	//FAIL
+	}
+	//If: encoder threshold
+	if ((config.enc_update_th <= 0) || (config.enc_update_th > MAX_ENC_UPDATE_TH))
+	{
+		return true;	//FAIL
+	}
+	//If: timeouts
+	if ((config.link_timeout < MIN_RPI_COM_TIMEOUT) || (config.motion_timeout_ms < MIN_MOTION_TIMEOUT_MS) || (config.motion_timeout_ms > MAX_MOTION_TIMEOUT_MS))
+	{
+		return true;	//FAIL
+	}
+	//For: every linearization table
+	for (uint8_t t = 0;t < NUM_VNH7040;t++)
+	{
+		//If: above the hardware limit or decreasing
+		if (config_check_lut( config.lin_lut[t] ) == true)
+		{
+			return true;	//FAIL
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: config_check | const Config &
+
+/***************************************************************************/
+//!	@brief function
+//!	config_default | void
+/***************************************************************************/
+//! @return void
+//! @details
+//!	Compile time defaults of global.h
+/***************************************************************************/
+
+static void config_default( void )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	g_config.version			= CONFIG_VERSION;
+	g_config.size				= sizeof(Config);
+	g_config.pwm_min			= MIN_VNH7040_PWM;
+	g_config.pwm_max			= MAX_VNH7040_PWM;
+	g_config.pwm_accel			= MAX_VNH7040_PWM_SLOPE;
+	g_config.pwm_decel			= MAX_VNH7040_PWM_DECEL;
+	g_config.layout_reverse		= LAYOUT_VNH7040_REVERSE;
+	g_config.enc_update_th		= ENC_UPDATE_TH;
+	g_config.link_timeout		= RPI_COM_TIMEOUT;
+	g_config.motion_timeout_ms	= MOTION_TIMEOUT_MS;
+	//For: every channel
+	for (uint8_t t = 0;t < NUM_VNH7040;t++)
+	{
+		config_default_lut( g_config, t );
+	}
+	g_config.crc				= config_crc( (const uint8_t *)&g_config, sizeof(Config) -sizeof(uint16_t) );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: config_default | void
+
+/***************************************************************************/
+//!	@brief function
+//!	config_load | void
+/***************************************************************************/
+//! @return bool | false = loaded from EEPROM | true = defaults in use
+//! @details
+//!	Called by init() before anything uses a parameter. Interrupts are still off
+//!	EEPROM is mapped in the data space. Reads need no NVMCTRL command
+//!	Outcome in g_config_status. Main sends it in LOG_CONFIG
+/***************************************************************************/
+
+bool config_load( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Block in EEPROM
+	const volatile uint8_t *eeprom = (const volatile uint8_t *)(MAPPED_EEPROM_START +CONFIG_EEPROM_ADDR);
+	//Bytes of the configuration
+	uint8_t *data = (uint8_t *)&g_config;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//For: every byte of the block
+	for (t = 0;t < sizeof(Config);t++)
+	{
+		data[t] = eeprom[t];
+	}
+	g_config_version_found = g_config.version;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: EEPROM never written
+	if (g_config.version == 0xff)
+	{
+		g_config_status = CONFIG_BLANK;
+	}
+	//If: another layout
+	else if ((g_config.version != CONFIG_VERSION) || (g_config.size != sizeof(Config)))
+	{
+		g_config_status = CONFIG_BAD_VERSION;
+	}
+	//If: corrupted
+	else if (g_config.crc != config_crc( data, sizeof(Config) -sizeof(uint16_t) ))
+	{
+		g_config_status = CONFIG_BAD_CRC;
+	}
+	//If: valid
+	else
+	{
+		g_config_status = CONFIG_LOADED;
+	}
+	//If: parameters can be used
+	if (g_config_status == CONFIG_LOADED)
+	{
+		//If: written by a firmware with wider limits
+		if (config_check( g_config ) == true)
+		{
+			g_config_status = CONFIG_BAD_VALUE;
+		}
+		//If: valid
+		else
+		{
+			return false;	//OK
+		}
+	}
+	//Block not usable
+	config_default();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return true;	//FAIL
+}	//End function: config_load | void
+
+/***************************************************************************/
+//!	@brief function
+//!	config_field | const Config & | uint8_t
+/***************************************************************************/
+//! @param config | const Config & | parameters
+//! @param id | uint8_t | CFG_* id of orangebot_config.h
+//! @return int16_t | value of the parameter. 0 for a bad id
+/***************************************************************************/
+
+static int16_t config_field( const Config &config, uint8_t id )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	switch (id)
+	{
+		case CFG_PWM_MIN:			return config.pwm_min;
+		case CFG_PWM_MAX:			return config.pwm_max;
+		case CFG_PWM_ACCEL:			return config.pwm_accel;
+		case CFG_PWM_DECEL:			return config.pwm_decel;
+		case CFG_LAYOUT_REVERSE:	return config.layout_reverse;
+		case CFG_ENC_UPDATE_TH:		return config.enc_update_th;
+		case CFG_LINK_TIMEOUT:		return config.link_timeout;
+		case CFG_MOTION_TIMEOUT:	return (int16_t)config.motion_timeout_ms;
+		default:					break;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return 0;	//FAIL
+}	//End function: config_field | const Config & | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	config_get | uint8_t
+/***************************************************************************/
+//! @param id | uint8_t | CFG_* id of orangebot_config.h
+//! @return int16_t | value in use. 0 for a bad id
+/***************************************************************************/
+
+int16_t config_get( uint8_t id )
+{
+	return config_field( g_config, id );
+}	//End function: config_get | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	config_set | uint8_t | int16_t
+/***************************************************************************/
+//! @param id | uint8_t | CFG_* id of orangebot_config.h
+//! @param value | int16_t | new value
+//! @return bool | false = OK | true = bad id or value out of range
+//! @details
+//!	Checked on a copy, then copied atomically. The control and encoder ISRs read the parameters
+//!	Applied right away. PWM limit and slopes overwrite the PWM_PARAM of every channel
+//!	PWM min rebuilds the default linearization tables
+//!	Only in RAM until config_save
+/***************************************************************************/
+
+bool config_set( uint8_t id, int16_t value )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Candidate parameters
+	Config config_tmp = g_config;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	switch (id)
+	{
+		case CFG_PWM_MIN:			config_tmp.pwm_min = value;						break;
+		case CFG_PWM_MAX:			config_tmp.pwm_max = value;						break;
+		case CFG_PWM_ACCEL:			config_tmp.pwm_accel = value;					break;
+		case CFG_PWM_DECEL:			config_tmp.pwm_decel = value;					break;
+		case CFG_LAYOUT_REVERSE:	config_tmp.layout_reverse = (uint8_t)value;		break;
+		case CFG_ENC_UPDATE_TH:		config_tmp.enc_update_th = (int8_t)value;		break;
+		case CFG_LINK_TIMEOUT:		config_tmp.link_timeout = (uint8_t)value;		break;
+		case CFG_MOTION_TIMEOUT:	config_tmp.motion_timeout_ms = (uint16_t)value;	break;
+		default:					return true;	//FAIL
+	}
+	//If: new static friction offset. Tables go back to the default line from it. Calibration is lost
+	if (id == CFG_PWM_MIN)
+	{
+		//For: every channel
+		for (t = 0;t < NUM_VNH7040;t++)
+		{
+			config_default_lut( config_tmp, t );
+		}
+	}
+	//If: value does not fit the field or is out of range
+	if ((config_field( config_tmp, id ) != value) || (config_check( config_tmp ) == true))
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Write atomically
+	sreg_tmp = SREG;
+	cli();
+	g_config = config_tmp;
+	SREG = sreg_tmp;
+	//If: defaults of the slew rate limiter
+	if ((id == CFG_PWM_MAX) || (id == CFG_PWM_ACCEL) || (id == CFG_PWM_DECEL))
+	{
+		//For: every channel
+		for (t = 0;t < NUM_VNH7040;t++)
+		{
+			set_vnh7040_pwm_param( t, g_config.pwm_max, g_config.pwm_accel, g_config.pwm_decel );
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: config_set | uint8_t | int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	config_save | void
+/***************************************************************************/
+//! @return bool | false = OK | true = a save is already running
+//! @details
+//!	Snapshot the parameters in use with a fresh CRC. config_process writes it
+/***************************************************************************/
+
+bool config_save( void )
+{
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: a save is running
+	if (g_config_save_index != CONFIG_SAVE_IDLE)
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Only main writes g_config. No need to block interrupts
+	g_config_save = g_config;
+	g_config_save.version = CONFIG_VERSION;
+	g_config_save.size = sizeof(Config);
+	g_config_save.crc = config_crc( (const uint8_t *)&g_config_save, sizeof(Config) -sizeof(uint16_t) );
+	//Start from the first byte
+	g_config_save_index = 0;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: config_save | void
+
+/***************************************************************************/
+//!	@brief function
+//!	config_process | void
+/***************************************************************************/
+//! @return bool | true = the save just completed
+//! @details
+//!	Called by the main loop. Returns at once while the EEPROM is busy
+//!	Loads the bytes of the next EEPROM page in the page buffer and starts an erase and write of them
+//!	A page takes about 4ms. The main loop, the WDT and the control system never wait for it
+/***************************************************************************/
+
+bool config_process( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Block in EEPROM
+	volatile uint8_t *eeprom = (volatile uint8_t *)(MAPPED_EEPROM_START +CONFIG_EEPROM_ADDR);
+	//Bytes of the image
+	const uint8_t *data = (const uint8_t *)&g_config_save;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: no save is running or the EEPROM is writing the previous page
+	if ((g_config_save_index == CONFIG_SAVE_IDLE) || (IS_BIT_ONE( NVMCTRL.STATUS, NVMCTRL_EEBUSY_bp )))
+	{
+		return false;
+	}
+	//If: last page written
+	if (g_config_save_index >= sizeof(Config))
+	{
+		g_config_save_index = CONFIG_SAVE_IDLE;
+		return true;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Do: fill the page buffer up to the end of the block or of the EEPROM page
+	do
+	{
+		eeprom[ g_config_save_index ] = data[ g_config_save_index ];
+		g_config_save_index++;
+	}
+	while ((g_config_save_index < sizeof(Config)) && (((CONFIG_EEPROM_ADDR +g_config_save_index) % EEPROM_PAGE_SIZE) != 0));
+	//Erase and write the bytes of the page buffer
+	_PROTECTED_WRITE_SPM( NVMCTRL.CTRLA, NVMCTRL_CMD_PAGEERASEWRITE_gc );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;
+}	//End function: config_process | void
+
+/***************************************************************************/
+//!	@brief function
+//!	get_config_crc | void
+/***************************************************************************/
+//! @return uint16_t | CRC16 of the last block saved
+/***************************************************************************/
+
+uint16_t get_config_crc( void )
+{
+	return g_config_save.crc;
+}	//End function: get_config_crc | void
+
+/***************************************************************************/
+//!	@brief function
+//!	config_set_lut | uint8_t | const uint8_t *
+/***************************************************************************/
+//! @param index | uint8_t | VNH7040 channel
+//! @param lut | const uint8_t * | LIN_NUM_POINTS linearization table
+//! @return bool | false = OK | true = bad index or bad table
+//! @details
+//!	Copied atomically. The control system reads the table every tick
+//!	Only in RAM until config_save
+/***************************************************************************/
+
+bool config_set_lut( uint8_t index, const uint8_t *lut )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Save interrupt state
+	uint8_t sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad index or bad table
+	if ((index >= NUM_VNH7040) || (config_check_lut( lut ) == true))
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Write atomically
+	sreg_tmp = SREG;
+	cli();
+	for (t = 0;t < LIN_NUM_POINTS;t++)
+	{
+		g_config.lin_lut[index][t] = lut[t];
+	}
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: config_set_lut | uint8_t | const uint8_t *
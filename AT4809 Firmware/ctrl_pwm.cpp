@@ -22,6 +22,9 @@
 *****************************************************************************
 **		2020-01-03
 **
+**	Per channel limit. Separate acceleration and deceleration slopes
+**	Active channel mask. Branch free update
+**	Update visits only the set bits of the mask. Vectorizable kernel on the host
 ****************************************************************************/
 
 /****************************************************************************
@@ -60,6 +63,81 @@ namespace Orangebot
 **	GLOBAL VARIABILES
 ****************************************************************************/
 
+/****************************************************************************
+**	LOCAL FUNCTIONS
+*****************************************************************************
+**	Branch free 16b arithmetic used by the slew rate limiter
+**	A mask is 0x0000 (false) or 0xffff (true) and replaces a conditional jump
+****************************************************************************/
+
+//Sign mask of a 16b value. 0xffff if negative, 0x0000 if positive or zero
+static inline int16_t s16_sign_mask( int16_t x )
+{
+	return (int16_t)(x >> 15);
+}
+
+//Non zero mask of a 16b value. 0xffff if different from zero, 0x0000 if zero
+static inline int16_t s16_nonzero_mask( int16_t x )
+{
+	//Either x or -x is negative unless x is zero
+	return s16_sign_mask( x | (int16_t)(0 -(uint16_t)x) );
+}
+
+//Select a where mask is 0xffff and b where mask is 0x0000
+static inline int16_t s16_select( int16_t mask, int16_t a, int16_t b )
+{
+	return (int16_t)((a & mask) | (b & ~mask));
+}
+
+//Saturated 16b sum x+y
+static inline int16_t s16_sat_add( int16_t x, int16_t y )
+{
+	//Wrap around sum
+	int16_t res = (int16_t)((uint16_t)x + (uint16_t)y);
+	//Overflow if x and y have the same sign and the result has a different sign
+	int16_t ovf = s16_sign_mask( ~(x ^ y) & (x ^ res) );
+	//Saturate in the direction of x. INT16_MAX or INT16_MIN
+	return s16_select( ovf, (int16_t)(s16_sign_mask( x ) ^ INT16_MAX), res );
+}
+
+//Saturated 16b difference x-y
+static inline int16_t s16_sat_sub( int16_t x, int16_t y )
+{
+	//Wrap around difference
+	int16_t res = (int16_t)((uint16_t)x - (uint16_t)y);
+	//Overflow if x and y have different sign and the result has a different sign from x
+	int16_t ovf = s16_sign_mask( (x ^ y) & (x ^ res) );
+	//Saturate in the direction of x. INT16_MAX or INT16_MIN
+	return s16_select( ovf, (int16_t)(s16_sign_mask( x ) ^ INT16_MAX), res );
+}
+
+//Clip x inside -bound +bound. bound must be positive
+static inline int16_t s16_clip( int16_t x, int16_t bound )
+{
+	//x > bound if bound -x is negative
+	x = s16_select( s16_sign_mask( s16_sat_sub( bound, x ) ), bound, x );
+	//x < -bound if x +bound is negative
+	x = s16_select( s16_sign_mask( s16_sat_add( x, bound ) ), (int16_t)-bound, x );
+
+	return x;
+}
+
+//One tick of the slew rate limiter of a channel. Returns the new PWM
+static inline int16_t s16_slew_step( int16_t actual, int16_t target, int16_t max, int16_t accel, int16_t decel )
+{
+	//Compute difference
+	int16_t diff = s16_sat_sub( target, actual );
+	//Moving toward zero is a deceleration. Difference and actual have opposite sign and actual is not zero
+	int16_t f_decel = s16_sign_mask( diff ^ actual ) & s16_nonzero_mask( actual );
+	//Clip difference to the selected slope
+	diff = s16_clip( diff, s16_select( f_decel, decel, accel ) );
+	//Apply difference
+	target = s16_clip( s16_sat_add( actual, diff ), max );
+	//If new reading and old reading are different in sign, force a zero
+	int16_t f_cross = s16_sign_mask( target ^ actual ) & s16_nonzero_mask( target ) & s16_nonzero_mask( actual );
+	return (int16_t)(target & ~f_cross);
+}
+
 /****************************************************************************
 *****************************************************************************
 **	CONSTRUCTORS
@@ -130,8 +208,48 @@ Ctrl_pwm::Ctrl_pwm( uint16_t max, uint16_t slope )
 	///	BODY
 	///--------------------------------------------------------------------------
 
+	//Initialize class variables. Same slope to accelerate and decelerate
+	this -> init_vars( max, slope, slope );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/***************************************************************************/
+//!	@brief Initialized Constructor
+//!	Ctrl_pwm | uint16_t max, uint16_t accel, uint16_t decel
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Initialized constructor. Separate slopes when moving away or toward zero
+/***************************************************************************/
+
+Ctrl_pwm::Ctrl_pwm( uint16_t max, uint16_t accel, uint16_t decel )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
 	//Initialize class variables
-	this -> init_vars( max, slope );
+	this -> init_vars( max, accel, decel );
 
 	///--------------------------------------------------------------------------
 	///	RETURN
@@ -198,12 +316,245 @@ Ctrl_pwm::~Ctrl_pwm( void )
 *****************************************************************************
 ****************************************************************************/
 
+/***************************************************************************/
+//!	@brief Public Setter
+//!	set_max | uint8_t | uint16_t
+/***************************************************************************/
+//! @param index | uint8_t | PWM channel
+//! @param max | uint16_t | PWM limit of the channel
+//! @return bool | false = OK | true = bad channel index
+//!	@details
+//! Set the PWM limit of one channel
+/***************************************************************************/
+
+bool Ctrl_pwm::set_max( uint8_t index, uint16_t max )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad channel index
+	if (index >= NUM_CTRL_PWM)
+	{
+		return true;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Save limit
+	this -> g_pwm_max[ index ] = max;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end setter: set_max | uint8_t | uint16_t
+
+/***************************************************************************/
+//!	@brief Public Setter
+//!	set_slope | uint8_t | uint16_t | uint16_t
+/***************************************************************************/
+//! @param index | uint8_t | PWM channel
+//! @param accel | uint16_t | maximum PWM change per tick when moving away from zero
+//! @param decel | uint16_t | maximum PWM change per tick when moving toward zero
+//! @return bool | false = OK | true = bad channel index
+//!	@details
+//! Set the acceleration and deceleration slopes of one channel
+//!	A steeper deceleration lets the platform brake harder than it accelerates
+/***************************************************************************/
+
+bool Ctrl_pwm::set_slope( uint8_t index, uint16_t accel, uint16_t decel )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad channel index
+	if (index >= NUM_CTRL_PWM)
+	{
+		return true;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Save slopes
+	this -> g_pwm_accel[ index ] = accel;
+	this -> g_pwm_decel[ index ] = decel;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end setter: set_slope | uint8_t | uint16_t | uint16_t
+
+/***************************************************************************/
+//!	@brief Public Setter
+//!	set_active | uint8_t
+/***************************************************************************/
+//! @param mask | uint8_t | one bit per channel. true = channel is processed by update
+//! @return bool | false = OK | true = mask addresses channels that do not exist
+//!	@details
+//! Set which channels are processed by update
+//!	Inactive channels are forced to zero PWM and keep it
+/***************************************************************************/
+
+bool Ctrl_pwm::set_active( uint8_t mask )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: channels that do not exist
+	if ((mask & ~CTRL_PWM_ALL_ACTIVE) != 0)
+	{
+		return true;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Save mask
+	this -> g_active_mask = mask;
+	//For: every PWM channel
+	for (t = 0;t < NUM_CTRL_PWM;t++)
+	{
+#ifndef __AVR__
+		//Unpack the mask for the vectorized kernel
+		this -> g_active_sel[t] = (int16_t)(0 -((mask >> t) & 0x01));
+#endif
+		//If: channel is not active
+		if ((mask & (0x01 << t)) == 0)
+		{
+			//Stop the channel
+			this -> g_pwm[t] = 0;
+			this -> g_pwm_target[t] = 0;
+		}
+	} //End for: every PWM channel
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end setter: set_active | uint8_t
+
 /****************************************************************************
 *****************************************************************************
 **	GETTERS
 *****************************************************************************
 ****************************************************************************/
 
+/***************************************************************************/
+//!	@brief Public Getter
+//!	get_max | uint8_t
+/***************************************************************************/
+//! @param index | uint8_t | PWM channel
+//! @return uint16_t | PWM limit of the channel. 0 if bad channel index
+/***************************************************************************/
+
+uint16_t Ctrl_pwm::get_max( uint8_t index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad channel index
+	if (index >= NUM_CTRL_PWM)
+	{
+		return 0;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pwm_max[ index ];	//OK
+}	//end getter: get_max | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Getter
+//!	get_accel | uint8_t
+/***************************************************************************/
+//! @param index | uint8_t | PWM channel
+//! @return uint16_t | acceleration slope of the channel. 0 if bad channel index
+/***************************************************************************/
+
+uint16_t Ctrl_pwm::get_accel( uint8_t index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad channel index
+	if (index >= NUM_CTRL_PWM)
+	{
+		return 0;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pwm_accel[ index ];	//OK
+}	//end getter: get_accel | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Getter
+//!	get_decel | uint8_t
+/***************************************************************************/
+//! @param index | uint8_t | PWM channel
+//! @return uint16_t | deceleration slope of the channel. 0 if bad channel index
+/***************************************************************************/
+
+uint16_t Ctrl_pwm::get_decel( uint8_t index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad channel index
+	if (index >= NUM_CTRL_PWM)
+	{
+		return 0;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pwm_decel[ index ];	//OK
+}	//end getter: get_decel | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Getter
+//!	get_active | void
+/***************************************************************************/
+//! @return uint8_t | mask of the channels processed by update. One bit per channel
+/***************************************************************************/
+
+uint8_t Ctrl_pwm::get_active( void )
+{
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_active_mask;	//OK
+}	//end getter: get_active | void
+
 /****************************************************************************
 *****************************************************************************
 **	REFERENCES
@@ -311,9 +662,15 @@ inline bool Ctrl_pwm::reset( void )
 /***************************************************************************/
 //! @return bool | false = OK
 //!	@details
-//! Update all PWM channels
+//! Update the active PWM channels
 //! pwm tries to reach the target while complying with slope and max
+//!	Moving away from zero uses the acceleration slope, moving toward zero the deceleration slope
 //! PWM must pass from zero in the event of a change in direction. Change of direction is stressful for a driver
+//!	Saturation, slope selection and zero crossing are computed with sign masks instead of branches
+//!	so the execution time of a channel does not depend on its state
+//!	AVR: only the set bits of the active mask are visited, lowest first
+//!	Host: every channel runs the same straight line code and the mask selects which results are kept.
+//!	No branch depends on the data, so the compiler can pack the channels in vector registers. See tools/ctrl_pwm_bench.cpp
 /***************************************************************************/
 
 bool Ctrl_pwm::update( void )
@@ -324,8 +681,10 @@ bool Ctrl_pwm::update( void )
 
 	//Counter
 	uint8_t t;
-	//Difference
-	int16_t diff, actual, target, slope, max;
+#ifdef __AVR__
+	//Active channels left to process
+	uint8_t mask;
+#endif
 
 	///--------------------------------------------------------------------------
 	///	INIT
@@ -338,27 +697,26 @@ bool Ctrl_pwm::update( void )
 	///	BODY
 	///--------------------------------------------------------------------------
 
-	//For: every PWM channel
+#ifdef __AVR__
+	//While: active channels are left
+	mask = this -> g_active_mask;
+	while (mask != 0)
+	{
+		//Lowest active channel
+		t = (uint8_t)__builtin_ctz( mask );
+		//Clear it from the channels left
+		mask &= (uint8_t)(mask -1);
+		//Execute a tick of the channel
+		this -> g_pwm[t] = s16_slew_step( this -> g_pwm[t], this -> g_pwm_target[t], this -> g_pwm_max[t], this -> g_pwm_accel[t], this -> g_pwm_decel[t] );
+	} //End while: active channels are left
+#else
+	//For: every PWM channel. Vectorized kernel
 	for (t = 0;t < NUM_CTRL_PWM;t++)
 	{
-		//Fetch
-		actual = this -> g_pwm[t];
-		target = this -> g_pwm_target[t];
-		slope = this -> g_pwm_slope[t];
-		max = this -> g_pwm_max[t];
-		//DPRINT("actual: %5d | target: %5d | slope: %5d | max: %5d | ", actual, target, slope, max);
-		//Compute difference
-		diff = AT_SAT_SUM( target, -actual, INT16_MAX, INT16_MIN );
-		//Clip difference
-		diff = AT_SAT( diff, slope, -slope );
-		//Apply difference
-		target = AT_SAT_SUM( actual, diff, max, -max );
-		//DPRINT_NOTAB("diff: %5d | target result: %5d |\n", diff, target);
-		//If new reading and old reading are different in sign, force a zero
-		actual = ((target >= 0) && (actual >= 0)) || ((target <= 0) && (actual <= 0))?(target):(0);
-		//Write back
-		this -> g_pwm[t] = actual;
+		//Inactive channels keep their PWM
+		this -> g_pwm[t] = s16_select( this -> g_active_sel[t], s16_slew_step( this -> g_pwm[t], this -> g_pwm_target[t], this -> g_pwm_max[t], this -> g_pwm_accel[t], this -> g_pwm_decel[t] ), this -> g_pwm[t] );
 	} //End for: every PWM channel
+#endif
 
 	///--------------------------------------------------------------------------
 	///	RETURN
@@ -417,10 +775,13 @@ inline bool Ctrl_pwm::init_vars( void )
 		//Initialize
 		this -> g_pwm[t] = 0;
 		this -> g_pwm_target[t] = 0;
-		this -> g_pwm_max[t] = UINT16_MAX;
-		this -> g_pwm_slope[t] = UINT16_MAX;
+		this -> g_pwm_max[t] = INT16_MAX;
+		this -> g_pwm_accel[t] = INT16_MAX;
+		this -> g_pwm_decel[t] = INT16_MAX;
 
 	} //End for: every PWM channel
+	//All channels are active
+	this -> set_active( CTRL_PWM_ALL_ACTIVE );
 
 	///--------------------------------------------------------------------------
 	///	RETURN
@@ -434,14 +795,14 @@ inline bool Ctrl_pwm::init_vars( void )
 
 /***************************************************************************/
 //!	@brief Private Method
-//!	init_vars | int16_t | int16_t | uint16_t |
+//!	init_vars | uint16_t | uint16_t | uint16_t |
 /***************************************************************************/
 //! @return bool
 //!	@details
 //! Initialize class vars
 /***************************************************************************/
 
-inline bool Ctrl_pwm::init_vars( uint16_t max, uint16_t slope )
+inline bool Ctrl_pwm::init_vars( uint16_t max, uint16_t accel, uint16_t decel )
 {
 	//Trace Enter
 	DENTER();
@@ -468,9 +829,12 @@ inline bool Ctrl_pwm::init_vars( uint16_t max, uint16_t slope )
 		this -> g_pwm[t] = 0;
 		this -> g_pwm_target[t] = 0;
 		this -> g_pwm_max[t] = max;
-		this -> g_pwm_slope[t] = slope;
+		this -> g_pwm_accel[t] = accel;
+		this -> g_pwm_decel[t] = decel;
 
 	} //End for: every PWM channel
+	//All channels are active
+	this -> set_active( CTRL_PWM_ALL_ACTIVE );
 
 	///--------------------------------------------------------------------------
 	///	RETURN
@@ -15,6 +15,8 @@
 
 //Number of PWM channels to be controlled
 #define NUM_CTRL_PWM		4
+//Mask with all channels active
+#define CTRL_PWM_ALL_ACTIVE	((uint8_t)((0x01 << NUM_CTRL_PWM) -1))
 
 /**********************************************************************************
 **	MACROS
@@ -73,6 +75,8 @@ class Ctrl_pwm
 		Ctrl_pwm( void );
 		//! Initialized constructor
 		Ctrl_pwm( uint16_t max, uint16_t slope );
+		//! Initialized constructor with separate acceleration and deceleration slopes
+		Ctrl_pwm( uint16_t max, uint16_t accel, uint16_t decel );
 
 		//--------------------------------------------------------------------------
 		//	DESTRUCTORS
@@ -89,10 +93,26 @@ class Ctrl_pwm
 		//	SETTERS
 		//--------------------------------------------------------------------------
 
+		//Set the PWM limit of one channel
+		bool set_max( uint8_t index, uint16_t max );
+		//Set the acceleration and deceleration slopes of one channel
+		bool set_slope( uint8_t index, uint16_t accel, uint16_t decel );
+		//Set which channels are processed by update. One bit per channel
+		bool set_active( uint8_t mask );
+
 		//--------------------------------------------------------------------------
 		//	GETTERS
 		//--------------------------------------------------------------------------
 
+		//Get the PWM limit of one channel
+		uint16_t get_max( uint8_t index );
+		//Get the acceleration slope of one channel
+		uint16_t get_accel( uint8_t index );
+		//Get the deceleration slope of one channel
+		uint16_t get_decel( uint8_t index );
+		//Get the mask of the channels processed by update
+		uint8_t get_active( void );
+
 		//--------------------------------------------------------------------------
 		//	REFERENCES
 		//--------------------------------------------------------------------------
@@ -144,7 +164,7 @@ class Ctrl_pwm
 		//Initialize class variables
 		bool init_vars( void );
 		//Initialized initialize of class variables
-		bool init_vars( uint16_t max, uint16_t slope );
+		bool init_vars( uint16_t max, uint16_t accel, uint16_t decel );
 
 		//! dummy method for easy copy
 		bool dummy( void );
@@ -159,8 +179,16 @@ class Ctrl_pwm
 		int16_t g_pwm_target[ NUM_CTRL_PWM ];
 		//PWM limits
 		uint16_t g_pwm_max[ NUM_CTRL_PWM ];
-		//Maximum PWM slope allowed per execution tick
-		uint16_t g_pwm_slope[ NUM_CTRL_PWM ];
+		//Maximum PWM slope allowed per execution tick when moving away from zero
+		uint16_t g_pwm_accel[ NUM_CTRL_PWM ];
+		//Maximum PWM slope allowed per execution tick when moving toward zero
+		uint16_t g_pwm_decel[ NUM_CTRL_PWM ];
+		//Channels processed by update. One bit per channel
+		uint8_t g_active_mask;
+#ifndef __AVR__
+		//Active mask unpacked. 0xffff if active. Selects the results of the vectorized kernel
+		int16_t g_active_sel[ NUM_CTRL_PWM ];
+#endif
 
 };	//End Class: Ctrl_pwm
 
@@ -0,0 +1,645 @@
+/****************************************************************************
+**	INCLUDE
+****************************************************************************/
+
+//type definition using the bit width and signedness
+#include <stdint.h>
+//define the ISR routune, ISR vector, and the sei() cli() function
+#include <avr/interrupt.h>
+//name all the register and bit
+#include <avr/io.h>
+//General purpose macros
+#include "at_utils.h"
+//AT4809 PORT macros definitions
+#include "at4809_port.h"
+//Program wide definitions
+#include "global.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+/****************************************************************************
+**	ENUM
+****************************************************************************/
+
+//Steps of the diagnostic sweep
+typedef enum _Diag_state
+{
+	DIAG_STATE_IDLE,		//Current sense
+	DIAG_STATE_START,		//Main asked for a sweep. ISR raises PF1 at the end of the round
+	DIAG_STATE_SETTLE,		//PF1 high. Discard while the MultiSense settles
+	DIAG_STATE_CAPTURE,		//PF1 high. Save the round
+	DIAG_STATE_RECOVER,		//PF1 low. Discard while the MultiSense settles
+	DIAG_STATE_DONE			//Results ready for main
+} Diag_state;
+
+/****************************************************************************
+**	GLOBAL VARS
+****************************************************************************/
+
+//Filtered current of each VNH7040. Written by the ADC ISR
+volatile uint16_t g_motor_current[NUM_VNH7040];
+//Last conversions of each channel. ADC ISR only
+uint16_t g_current_ring[NUM_VNH7040][CURRENT_AVG_SIZE];
+//Sum of the ring of each channel. ADC ISR only
+uint16_t g_current_sum[NUM_VNH7040];
+//Channel being converted. ADC ISR only
+uint8_t g_current_channel = 0;
+//Slot of the ring written by the next conversion of each channel. ADC ISR only
+uint8_t g_current_slot = 0;
+//Current limit and stall current [ADC counts]. Written by main, read by the control system
+uint16_t g_current_limit = CURRENT_MA_TO_CNT( CURRENT_LIMIT_MA );
+uint16_t g_stall_current = CURRENT_MA_TO_CNT( STALL_CURRENT_MA );
+//Control ticks a channel must stay stalled
+uint16_t g_stall_ticks = STALL_TICKS;
+//PWM scale of each channel. CURRENT_SCALE_ONE = no limit. Control system only
+uint16_t g_current_scale[NUM_VNH7040];
+//Control ticks each channel has been stalled. Control system only
+uint16_t g_stall_cnt[NUM_VNH7040];
+//Step of the diagnostic sweep. Advanced by the ADC ISR at the end of each round
+volatile uint8_t g_diag_state = DIAG_STATE_IDLE;
+//Rounds left to discard. ADC ISR only
+uint8_t g_diag_rounds = 0;
+//MultiSense diagnostic conversion of each driver. Valid in DIAG_STATE_DONE
+uint16_t g_diag_raw[NUM_VNH7040];
+//SEL0 of each driver during the capture. 1 = VCC, 0 = chip temperature. Valid in DIAG_STATE_DONE
+uint8_t g_diag_sel0 = 0;
+//Fault code of each driver. Main only
+uint8_t g_diag_code[NUM_VNH7040];
+
+/****************************************************************************
+**	FUNCTION
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief function
+//!	diag_round | void
+/***************************************************************************/
+//! @return void
+//! @details
+//!	Executed by the ADC ISR at the end of each round of the four channels
+//!	>START: raise SEL1 and discard DIAG_SETTLE_ROUNDS
+//!	>CAPTURE: the next round is saved. Latch SEL0 of each driver, wired to INA
+//!	>RECOVER: lower SEL1 and discard DIAG_SETTLE_ROUNDS
+//!	>DONE: main turns the round into fault codes and returns to IDLE
+/***************************************************************************/
+
+static void diag_round( void )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: main asked for a sweep
+	if (g_diag_state == DIAG_STATE_START)
+	{
+		//SEL1 high. MultiSense reports temperature or VCC
+		PORTF.OUTSET = PIN1_bm;
+		g_diag_rounds = DIAG_SETTLE_ROUNDS;
+		g_diag_state = DIAG_STATE_SETTLE;
+	}
+	//If: MultiSense is settling on the diagnostic
+	else if (g_diag_state == DIAG_STATE_SETTLE)
+	{
+		g_diag_rounds--;
+		//If: settled
+		if (g_diag_rounds == 0)
+		{
+			//SEL0 is INA. DRV0 PA4, DRV1 PA6, DRV2 PB2, DRV3 PD6
+			g_diag_sel0 =	((IS_BIT_ONE( PORTA.OUT, 4 ))?(0x01):(0x00)) | ((IS_BIT_ONE( PORTA.OUT, 6 ))?(0x02):(0x00)) |
+							((IS_BIT_ONE( PORTB.OUT, 2 ))?(0x04):(0x00)) | ((IS_BIT_ONE( PORTD.OUT, 6 ))?(0x08):(0x00));
+			g_diag_state = DIAG_STATE_CAPTURE;
+		}
+	}
+	//If: diagnostic round saved
+	else if (g_diag_state == DIAG_STATE_CAPTURE)
+	{
+		//SEL1 low. MultiSense reports the current again
+		PORTF.OUTCLR = PIN1_bm;
+		g_diag_rounds = DIAG_SETTLE_ROUNDS;
+		g_diag_state = DIAG_STATE_RECOVER;
+	}
+	//If: MultiSense is settling on the current
+	else if (g_diag_state == DIAG_STATE_RECOVER)
+	{
+		g_diag_rounds--;
+		//If: settled
+		if (g_diag_rounds == 0)
+		{
+			g_diag_state = DIAG_STATE_DONE;
+		}
+	}
+	//If: no sweep or results waiting for main
+	else
+	{
+		//Do nothing
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: diag_round | void
+
+/***************************************************************************/
+//!	@brief function
+//!	current_sense_sample | uint16_t
+/***************************************************************************/
+//! @param sample | accumulated result of the conversion just completed
+//! @return void
+//! @details
+//!	Executed by ADC0_RESRDY_vect. The ADC sequences itself, nothing runs in the main loop
+//!	>Moving average of the channel over CURRENT_AVG_SIZE conversions
+//!	>Select the next VNH7040 sense channel and start its conversion
+//!	The ring holds 12 bit accumulated results. The sum of the ring fits in 16 bit
+//!	The control ISR preempts this one. The 16 bit current is written atomically
+//!	During a diagnostic sweep the samples are not currents. The filter is frozen
+//!	and the sweep advances at the end of each round
+/***************************************************************************/
+
+void current_sense_sample( uint16_t sample )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Channel of the sample
+	uint8_t ch = g_current_channel;
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Filtered current
+	uint16_t avg;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: MultiSense gives the current
+	if ((g_diag_state == DIAG_STATE_IDLE) || (g_diag_state == DIAG_STATE_START) || (g_diag_state == DIAG_STATE_DONE))
+	{
+		//Replace the oldest conversion in the sum
+		g_current_sum[ch] = g_current_sum[ch] -g_current_ring[ch][ g_current_slot ] +sample;
+		g_current_ring[ch][ g_current_slot ] = sample;
+		avg = g_current_sum[ch] /CURRENT_AVG_SIZE;
+		//Publish
+		sreg_tmp = SREG;
+		cli();
+		g_motor_current[ch] = avg;
+		SREG = sreg_tmp;
+	}
+	//If: sweep round to be saved
+	else if (g_diag_state == DIAG_STATE_CAPTURE)
+	{
+		g_diag_raw[ch] = sample;
+	}
+	//If: MultiSense is settling
+	else
+	{
+		//Discard
+	}
+	//Next channel
+	ch++;
+	//If: round completed
+	if (ch >= NUM_VNH7040)
+	{
+		ch = 0;
+		//Next slot of all rings
+		g_current_slot = (g_current_slot +1) & (CURRENT_AVG_SIZE -1);
+		//Advance the diagnostic sweep. MultiSense only switches between rounds
+		diag_round();
+	}
+	g_current_channel = ch;
+	//DRVn_SENSE is on PDn, AINn
+	ADC0.MUXPOS = ADC_MUXPOS_AIN0_gc +ch;
+	//Start the conversion
+	ADC0.COMMAND = ADC_STCONV_bm;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: current_sense_sample | uint16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	get_motor_current | uint8_t
+/***************************************************************************/
+//! @param index | index of the VNH7040
+//! @return uint16_t | filtered current in CURRENT_UA_PER_CNT counts. 0 for a bad index
+//! @details
+//!	Safe from main and from the control ISR. Interrupt state is restored rather than enabled
+/***************************************************************************/
+
+uint16_t get_motor_current( uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Copy
+	uint16_t current_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad index
+	if (index >= NUM_VNH7040)
+	{
+		return 0;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//ADC ISR writes the current. Copy it atomically
+	sreg_tmp = SREG;
+	cli();
+	current_tmp = g_motor_current[index];
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return current_tmp;
+}	//End function: get_motor_current | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	current_limit | uint8_t | int16_t
+/***************************************************************************/
+//! @param index | index of the VNH7040
+//! @param pwm | PWM computed by the control system
+//! @return int16_t | PWM to apply
+//! @details
+//!	Inner current loop of the control system. Runs once per tick for each channel
+//!	>Above the limit the scale is cut by limit/current in a single tick
+//!	>Below the limit the scale recovers by CURRENT_SCALE_RECOVERY per tick
+//!	Multiplicative cut and slow recovery settle the current on the limit without oscillating
+/***************************************************************************/
+
+int16_t current_limit( uint8_t index, int16_t pwm )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Filtered current of the channel
+	uint16_t current;
+	//PWM scale of the channel
+	uint16_t scale;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad index
+	if (index >= NUM_VNH7040)
+	{
+		return 0;	//FAIL
+	}
+	current = get_motor_current( index );
+	scale = g_current_scale[index];
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: current above the limit
+	if (current > g_current_limit)
+	{
+		//Cut the scale in proportion to the excess
+		scale = (uint16_t)(((uint32_t)scale *g_current_limit) /current);
+	}
+	//If: current under the limit and the channel is limited
+	else if (scale < CURRENT_SCALE_ONE)
+	{
+		//Recover slowly
+		scale += CURRENT_SCALE_RECOVERY;
+		if (scale > CURRENT_SCALE_ONE)
+		{
+			scale = CURRENT_SCALE_ONE;
+		}
+	}
+	//If: current under the limit and the channel is not limited
+	else
+	{
+		//Do nothing
+	}
+	g_current_scale[index] = scale;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return (int16_t)(((int32_t)pwm *scale) /CURRENT_SCALE_ONE);
+}	//End function: current_limit | uint8_t | int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	stall_detect | uint8_t | int16_t
+/***************************************************************************/
+//! @param index | index of the VNH7040
+//! @param pwm | PWM applied to the channel
+//! @return bool | false = OK | true = channel has been stalled for the allowed ticks
+//! @details
+//!	A channel is stalled when it is driven, draws the stall current and its encoder does not move
+//!	The same condition has to hold for g_stall_ticks consecutive ticks. The motor draws the stall
+//!	current at start up too, before the wheel moves
+/***************************************************************************/
+
+bool stall_detect( uint8_t index, int16_t pwm )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Encoder speed of the channel
+	int16_t spd;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad index or no encoder on the channel
+	if ((index >= NUM_VNH7040) || (index >= NUM_ENC))
+	{
+		return false;	//OK
+	}
+	spd = g_enc_spd[index];
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: driven, stall current and not moving
+	if ((pwm != 0) && (get_motor_current( index ) >= g_stall_current) && (spd <= STALL_MAX_SPD) && (spd >= -STALL_MAX_SPD))
+	{
+		//If: stalled for long enough
+		if (g_stall_cnt[index] >= g_stall_ticks)
+		{
+			return true;	//FAIL
+		}
+		g_stall_cnt[index]++;
+	}
+	//If: channel moves or is idle
+	else
+	{
+		g_stall_cnt[index] = 0;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: stall_detect | uint8_t | int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	current_limit_reset | void
+/***************************************************************************/
+//! @return void
+//! @details
+//!	Executed by the control system in CONTROL_STOP. Next start begins unlimited
+/***************************************************************************/
+
+void current_limit_reset( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each VNH7040
+	for (t = 0;t < NUM_VNH7040;t++)
+	{
+		g_current_scale[t] = CURRENT_SCALE_ONE;
+		g_stall_cnt[t] = 0;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: current_limit_reset | void
+
+/***************************************************************************/
+//!	@brief function
+//!	set_current_limit | uint16_t | uint16_t | uint16_t
+/***************************************************************************/
+//! @param limit_ma | current limit [mA]
+//! @param stall_ma | stall current [mA]
+//! @param stall_ticks | control ticks a channel must stay stalled
+//! @return bool | false = OK | true = bad parameters
+//! @details
+//!	Limits beyond the full scale of the sense could never trip and are refused
+//!	A stall current above the limit could never be reached and is refused
+/***************************************************************************/
+
+bool set_current_limit( uint16_t limit_ma, uint16_t stall_ma, uint16_t stall_ticks )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Full scale of the sense [mA]
+	uint32_t full_scale_ma = ((uint32_t)CURRENT_ADC_FULL_SCALE *(uint32_t)CURRENT_UA_PER_CNT) /1000UL;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad parameters
+	if ((limit_ma == 0) || (limit_ma > full_scale_ma) || (stall_ma == 0) || (stall_ma > limit_ma) || (stall_ticks == 0))
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Control system may execute inside an ISR. Parameters are 16b and have to be written atomically
+	sreg_tmp = SREG;
+	cli();
+	g_current_limit = CURRENT_MA_TO_CNT( limit_ma );
+	g_stall_current = CURRENT_MA_TO_CNT( stall_ma );
+	g_stall_ticks = stall_ticks;
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: set_current_limit | uint16_t | uint16_t | uint16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	get_current_limit | uint16_t & | uint16_t & | uint16_t &
+/***************************************************************************/
+//! @param limit_ma | returns the current limit [mA]
+//! @param stall_ma | returns the stall current [mA]
+//! @param stall_ticks | returns the control ticks a channel must stay stalled
+//! @return void
+//! @details
+//!	Parameters are only written by the main loop. No need to block interrupts
+/***************************************************************************/
+
+void get_current_limit( uint16_t &limit_ma, uint16_t &stall_ma, uint16_t &stall_ticks )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	limit_ma = (uint16_t)(((uint32_t)g_current_limit *(uint32_t)CURRENT_UA_PER_CNT) /1000UL);
+	stall_ma = (uint16_t)(((uint32_t)g_stall_current *(uint32_t)CURRENT_UA_PER_CNT) /1000UL);
+	stall_ticks = g_stall_ticks;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: get_current_limit | uint16_t & | uint16_t & | uint16_t &
+
+/***************************************************************************/
+//!	@brief function
+//!	diag_start | void
+/***************************************************************************/
+//! @return void
+//! @details
+//!	Executed by main every DIAG_PERIOD housekeeping ticks
+//!	Only asks. The ADC ISR switches SEL1 at the end of a round so no current sample is spoiled
+/***************************************************************************/
+
+void diag_start( void )
+{
+	//If: no sweep running
+	if (g_diag_state == DIAG_STATE_IDLE)
+	{
+		//The ADC ISR only advances START. A byte write is atomic
+		g_diag_state = DIAG_STATE_START;
+	}
+
+	return;
+}	//End function: diag_start | void
+
+/***************************************************************************/
+//!	@brief function
+//!	diag_process | void
+/***************************************************************************/
+//! @return bool | false = fault codes unchanged or no sweep completed | true = fault codes changed
+//! @details
+//!	Executed by main at each loop. Does nothing until the ADC ISR completes a sweep
+//!	>DIAG_FAULT: the filtered current sits at the top of the scale, where the MultiSense goes on a fault
+//!	>DIAG_OVERTEMP: driver with SEL0 low and the chip temperature above the warning
+//!	>DIAG_VCC: driver with SEL0 high and the supply out of range
+/***************************************************************************/
+
+bool diag_process( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//Fault code of a driver
+	uint8_t code;
+	//Return flag
+	bool f_ret = false;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: no sweep completed
+	if (g_diag_state != DIAG_STATE_DONE)
+	{
+		return false;	//OK
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each driver
+	for (t = 0;t < NUM_VNH7040;t++)
+	{
+		code = DIAG_OK;
+		//If: current sense saturated
+		if (get_motor_current( t ) >= DIAG_FAULT_CNT)
+		{
+			code |= DIAG_FAULT;
+		}
+		//If: MultiSense gave VCC
+		if (IS_BIT_ONE( g_diag_sel0, t ))
+		{
+			if ((g_diag_raw[t] < DIAG_VCC_MIN_CNT) || (g_diag_raw[t] > DIAG_VCC_MAX_CNT))
+			{
+				code |= DIAG_VCC;
+			}
+		}
+		//If: MultiSense gave the chip temperature
+		else
+		{
+			code |= DIAG_TCHIP;
+			//Voltage falls with temperature
+			if (g_diag_raw[t] <= DIAG_TCHIP_WARN_CNT)
+			{
+				code |= DIAG_OVERTEMP;
+			}
+		}
+		//If: fault bits changed. DIAG_TCHIP only tells what was read
+		if (((code ^ g_diag_code[t]) & (uint8_t)~DIAG_TCHIP) != 0)
+		{
+			f_ret = true;
+		}
+		g_diag_code[t] = code;
+	}
+	//Ready for the next sweep
+	g_diag_state = DIAG_STATE_IDLE;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return f_ret;
+}	//End function: diag_process | void
+
+/***************************************************************************/
+//!	@brief function
+//!	get_diag_code | uint8_t
+/***************************************************************************/
+//! @param index | index of the VNH7040
+//! @return uint8_t | DIAG_* bit field of the last sweep. DIAG_OK for a bad index
+/***************************************************************************/
+
+uint8_t get_diag_code( uint8_t index )
+{
+	//If: bad index
+	if (index >= NUM_VNH7040)
+	{
+		return DIAG_OK;	//FAIL
+	}
+
+	return g_diag_code[index];
+}	//End function: get_diag_code | uint8_t
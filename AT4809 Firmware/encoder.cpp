@@ -146,6 +146,14 @@ void quad_encoder_decoder( uint8_t enc_in )
 	bool f_err = false;
 	//this flag is used to detect when a preventive overflow update is required
 	bool f_update = false;
+	//Sync threshold. CFG_ENC_UPDATE_TH. One load for all channels
+	int8_t update_th = g_config.enc_update_th;
+	//Working copies shifted by a constant amount each channel. AVR has no barrel shifter, variable shifts are loops
+	uint8_t pin_tmp = enc_pin;
+	uint8_t pin_old_tmp = enc_pin_old;
+	uint8_t dir_tmp = enc_dir;
+	//New direction memory. Bits enter from the top and reach their channel position after the last channel
+	uint8_t dir_new = (uint8_t)0x00;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -162,11 +170,11 @@ void quad_encoder_decoder( uint8_t enc_in )
 		// | 4		| 3		| 2		| 1		| 0
 		// | dir	| old B	| old A	| B		| A
 		//Inject new AB and clear index
-		index = (((enc_pin) >> (2*t)) & 0x03);
+		index = (pin_tmp & 0x03);
 		//Inject old AB
-		index |= ((t==0)?((enc_pin_old<<2)&0x0c):(((enc_pin_old) >> (2*(t-1))) & 0x0c));
+		index |= ((pin_old_tmp << 2) & 0x0c);
 		//Inject old direction
-		index |= (((enc_dir) << (4 -t)) & 0x10);
+		index |= ((dir_tmp << 4) & 0x10);
 
 		//! Decode the increment through the LUT
 		//Use the index as address for the encoder LUT, applying the complex truth table
@@ -175,15 +183,22 @@ void quad_encoder_decoder( uint8_t enc_in )
 		//! Apply increment to local relative memory and compute special
 		//Apply increment
 		enc_cnt[t] += increment;
-		//Compute new direction flag and write it back to the correct bit of the encoder direction memory
-		enc_dir = (enc_dir & INV_MASK(t)) | (((increment < 0) & 0x01) << t);
+		//Compute new direction flag and push it in the direction memory from the top
+		dir_new = (dir_new >> 1) | ((increment < 0) ? (uint8_t)MASK(NUM_ENC -1) : (uint8_t)0x00);
 		//Detect if a double event happened and remember it. Serves as over speed warning
 		f_err |= ((increment == +2) || (increment == -2));
 		//overflow update flag. if at least a counter is getting dangerously large
-		f_update |= ((enc_cnt[t] >= ENC_UPDATE_TH) || (enc_cnt[t] <= -ENC_UPDATE_TH));
+		f_update |= ((enc_cnt[t] >= update_th) || (enc_cnt[t] <= -update_th));
 
+		//! Move to next channel
+		pin_tmp >>= 2;
+		pin_old_tmp >>= 2;
+		dir_tmp >>= 1;
 	} //End For: each encoder channel
 
+	//Save direction memory
+	enc_dir = dir_new;
+
 	//! Write back double event error flag
 	//g_isr_flags.enc_double_event |= f_err;
 
@@ -226,6 +241,7 @@ void quad_encoder_decoder( uint8_t enc_in )
 //!	>raise sync flag
 //!	>manually execute encoder decoding routine
 //! >Transfer register value to local vars
+//!	Interrupt state is restored rather than enabled, the function can be called from inside the control ISR
 /***************************************************************************/
 
 bool get_enc_cnt( int32_t *enc_cnt )
@@ -238,6 +254,8 @@ bool get_enc_cnt( int32_t *enc_cnt )
 	uint8_t t;
 	//return flag
 	bool f_ret;
+	//Save interrupt state
+	uint8_t sreg_tmp = SREG;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -254,8 +272,6 @@ bool get_enc_cnt( int32_t *enc_cnt )
 
 	//Decode encoders and update 32b counters
 	quad_encoder_decoder( PORTC.IN );
-	//Enable interrupts
-	sei();
 	//If encoder routine failed to update global counters
 	f_ret = g_isr_flags.enc_updt;
 	//For: all encoder channels
@@ -264,6 +280,8 @@ bool get_enc_cnt( int32_t *enc_cnt )
 		//Copy
 		enc_cnt[t] = g_enc_cnt[t];
 	}
+	//Restore interrupt state
+	SREG = sreg_tmp;
 	
 	//----------------------------------------------------------------
 	//	RETURN
@@ -325,7 +343,8 @@ bool process_enc( void )
 	if (cnt >= ENC_UPDATE_RETRY)
 	{
 		//Report error
-		report_error( Error_code::ERR_ENC_RETRY );
+		report_error_deferred( Error_code::ERR_ENC_RETRY );
+		send_log( LOG_ENC_RETRY, cnt, 0 );
 		//Failed to update encoder
 		return true;
 	}
@@ -15,6 +15,9 @@
 	**	TIPS: you can put here the library common to all source file
 	****************************************************************************/
 
+	//Platform configuration shared with the RPI 3B+ NODE module. NUM_VNH7040, NUM_ENC
+	#include "../orangebot_config.h"
+
 	/****************************************************************************
 	**	DEFINE
 	****************************************************************************/
@@ -24,38 +27,130 @@
 		///----------------------------------------------------------------------
 
 	#define RPI_RX_BUF_SIZE		16
-	#define RPI_TX_BUF_SIZE		64
+	//Each telemetry reply is preceded by a TIME message
+	#define RPI_TX_BUF_SIZE		128
+	
+		///----------------------------------------------------------------------
+		///	FIRMWARE LOG
+		///----------------------------------------------------------------------
+	
+	//Log messages waiting to be sent. Power of two. Messages beyond it are counted and dropped
+	#define LOG_QUEUE_SIZE		8
+	//Longest LOG message. "LOG" + u8 + ':' + s16 + ':' + s16 + '\0'
+	#define LOG_MSG_MAX_LENGTH	21
+	//Free bytes of the TX buffer left to control replies after a log message
+	#define LOG_TX_HEADROOM		48
 	
 		///----------------------------------------------------------------------
 		///	PARSER
 		///----------------------------------------------------------------------
 	
-	//Communication timeout in communication system ticks		
+	//Default link timeout in housekeeping ticks. Any valid command from the RPI is a heartbeat. CFG_LINK_TIMEOUT
 	#define RPI_COM_TIMEOUT			200
-	//Maximum size of a signature string
-	#define MAX_SIGNATURE_LENGTH	32
+	#define MIN_RPI_COM_TIMEOUT		10
+	//Default validity of a motion command [ms]. Only motion commands refresh it. Above the period of the RPI PWM messages. CFG_MOTION_TIMEOUT
+	#define MOTION_TIMEOUT_MS		500
+	#define MIN_MOTION_TIMEOUT_MS	20
+	#define MAX_MOTION_TIMEOUT_MS	10000
 	
 		///----------------------------------------------------------------------
 		///	VNH7040 DC MOTOR CONTROLLER
 		///----------------------------------------------------------------------
 	
-	//Number of VNH7040 DC Motor drivers installed
-	#define NUM_VNH7040				4
-	//PWM limits
-	#define MIN_VNH7040_PWM			16		//Too low PWM settings do not result in motion
-	#define MAX_VNH7040_PWM			127		//Limit maximum PWM setting
-	#define MAX_VNH7040_PWM_SLOPE	10		//Maximum PWM change in PWM unit per control system tick. In change of direction is forced at least one pass from zero
-	//Set which motors need to be controlled in reverse to achieve forward motion with positive PWM
-	#define LAYOUT_VNH7040_REVERSE	(MASK(0))
+	//Number of VNH7040 DC Motor drivers installed: NUM_VNH7040 in orangebot_config.h
+	//PWM limits. Defaults of the configuration, except the hardware limit
+	#define VNH7040_PWM_LIMIT		127		//Hardware limit. No configuration can go above it
+	#define MIN_VNH7040_PWM			16		//Static friction offset of the default linearization table. CFG_PWM_MIN
+	#define MAX_VNH7040_PWM			127		//Limit maximum PWM setting. CFG_PWM_MAX
+	#define MAX_VNH7040_PWM_SLOPE	1		//Maximum PWM change in PWM unit per control system tick. In change of direction is forced at least one pass from zero. CFG_PWM_ACCEL
+	#define MAX_VNH7040_PWM_DECEL	1		//Maximum PWM change in PWM unit per control system tick when moving toward zero. Default for all channels. CFG_PWM_DECEL
+	//Set which motors are on the right side of the platform. The others are on the left side
+	#define LAYOUT_VNH7040_RIGHT	(MASK(0) | MASK(2))
+	//Set which motors need to be controlled in reverse to achieve forward motion with positive PWM. CFG_LAYOUT_REVERSE
+	#define LAYOUT_VNH7040_REVERSE	(LAYOUT_VNH7040_RIGHT)
+	//Set which motors are driven by the platform. Slew rate limiter only processes these channels
+	#define LAYOUT_VNH7040_ACTIVE	(MASK(NUM_VNH7040) -1)
+	
+		///----------------------------------------------------------------------
+		///	LINEARIZATION
+		///----------------------------------------------------------------------
+		//	The control system asks for an effort from 0 to VNH7040_PWM_LIMIT. A table per motor turns it into the PWM
+		//	that gives a speed proportional to the effort. First point is the static friction offset. Zero effort is zero PWM
+		//	Tables live in the configuration. CALIB measures them, the default is a line from CFG_PWM_MIN to VNH7040_PWM_LIMIT
+	
+	//Effort between two points of the table. Power of two
+	#define LIN_EFFORT_STEP			16
+	//Points of the table. The last one covers VNH7040_PWM_LIMIT
+	#define LIN_NUM_POINTS			(VNH7040_PWM_LIMIT /LIN_EFFORT_STEP +2)
+	
+		///----------------------------------------------------------------------
+		///	CALIBRATION
+		///----------------------------------------------------------------------
+		//	CONTROL_CALIB drives the motors of a mask with the same open loop PWM ramp, one step at a time
+		//	Each step waits CALIB_SETTLE_TICKS, then sums g_enc_spd for CALIB_MEASURE_TICKS. Forward only, tables are used for both directions
+		//	Main turns the speeds into tables. The robot must be on stands. Any motion command, stall, brownout or link loss aborts it
+	
+	//PWM steps of the ramp from zero to VNH7040_PWM_LIMIT
+	#define CALIB_NUM_STEPS			17
+	//Control ticks of each step before the speed is measured, and while it is measured
+	#define CALIB_SETTLE_TICKS		256
+	#define CALIB_MEASURE_TICKS		256
+	//Summed speed of a step above which the motor moves [counts per CALIB_MEASURE_TICKS]
+	#define CALIB_MOVE_SPD			16
+
+		///----------------------------------------------------------------------
+		///	CURRENT SENSE
+		///----------------------------------------------------------------------
+		//	ADC0 converts the VNH7040 sense outputs DRVn_SENSE on PDn (AINn) round robin from its RESRDY ISR
+		//	Each conversion accumulates 4 samples into a 12 bit result. Unit is CURRENT_UA_PER_CNT in orangebot_config.h
+	
+	//Conversions of each channel in the moving average. Power of two, at most 16
+	#define CURRENT_AVG_SIZE	8
+	//Convert a current in mA into filtered ADC counts
+	#define CURRENT_MA_TO_CNT( ma )		((uint16_t)((1000UL *(ma)) /(uint32_t)CURRENT_UA_PER_CNT))
+	//Default current limit [mA]. Above it the PWM of the channel is scaled down
+	#define CURRENT_LIMIT_MA		6000
+	//Default stall current [mA]. A channel above it that does not move is stalled
+	#define STALL_CURRENT_MA		4000
+	//Default control ticks a channel must stay stalled before the platform stops. Start up draws a stall current too
+	#define STALL_TICKS				200
+	//Encoder speed at or below which a channel does not move [counts per tick]
+	#define STALL_MAX_SPD			1
+	//Control ticks the platform stays in CONTROL_STOP after a stall, whatever the master asks
+	#define STALL_HOLDOFF_TICKS		1000
+	//PWM scale of the current limiter. Unity and recovery per control tick once the current is below the limit
+	#define CURRENT_SCALE_ONE		256
+	#define CURRENT_SCALE_RECOVERY	4
+	
+		///----------------------------------------------------------------------
+		///	VNH7040 DIAGNOSTIC
+		///----------------------------------------------------------------------
+		//	The ADC ISR runs the sweep at the end of a round of the four channels. The current filter is frozen meanwhile
+		//	PF1 high, DIAG_SETTLE_ROUNDS discarded, one round captured, PF1 low, DIAG_SETTLE_ROUNDS discarded. About 2ms
+	
+	//Convert a MultiSense voltage in mV into filtered ADC counts
+	#define DIAG_MV_TO_CNT( mv )	((uint16_t)(((uint32_t)(mv) *CURRENT_ADC_FULL_SCALE) /CURRENT_VREF_MV))
+	//Housekeeping ticks between two sweeps
+	#define DIAG_PERIOD				64
+	//Rounds of the ADC discarded after each switch of PF1 while the MultiSense settles
+	#define DIAG_SETTLE_ROUNDS		2
+	//Current sense at or above it means the MultiSense is saturated by a fault
+	#define DIAG_FAULT_CNT			(CURRENT_ADC_FULL_SCALE -CURRENT_ADC_FULL_SCALE /32)
+	//Chip temperature sense at or below it is an overtemperature
+	#define DIAG_TCHIP_WARN_CNT		DIAG_MV_TO_CNT( DIAG_TCHIP_25C_MV -((uint32_t)(DIAG_TCHIP_WARN_C -25) *DIAG_TCHIP_UV_PER_K) /1000 )
+	//VCC sense range. MultiSense gives VCC /4
+	#define DIAG_VCC_MIN_CNT		DIAG_MV_TO_CNT( DIAG_VCC_MIN_MV /4 )
+	#define DIAG_VCC_MAX_CNT		DIAG_MV_TO_CNT( DIAG_VCC_MAX_MV /4 )
 
 		///----------------------------------------------------------------------
 		///	ENCODERS
 		///----------------------------------------------------------------------
 	
-	//Number of quadrature encoders
-	#define NUM_ENC				2
-	//Threshold upon which local counters are synced with global counters
+	//Number of quadrature encoders: NUM_ENC in orangebot_config.h
+	//Threshold upon which local counters are synced with global counters. CFG_ENC_UPDATE_TH
 	#define ENC_UPDATE_TH		100
+	//The ISR counters are 8 bit and take increments of two
+	#define MAX_ENC_UPDATE_TH	(INT8_MAX -2)
 	//Number of times allowed to retry an update of global encoder vars before failing
 	#define ENC_UPDATE_RETRY	3
 	
@@ -63,8 +158,45 @@
 		///	CONTROL SYSTEM
 		///----------------------------------------------------------------------
 
-	//Prescaler of the control system from the main system tick
-	#define PRE_CTRL_SYS		16
+	//Prescaler of the housekeeping code (LED, communication timeout) from the RTC PIT system tick
+	#define PRE_HOUSEKEEPING	16
+	//Execute encoder snapshot, control step and PWM write from inside the TCA0 overflow ISR at level 1 priority.
+	//Sampling instant no longer depends on parser and TX load. Messages are deferred to the main loop.
+	//Comment to execute the control system from the main loop instead
+	#define CTRL_SYS_IN_ISR
+	//Control system tick is the TCA0 overflow. TCA0 is clocked by CLK_PER/4. Ticks of TCA0 in a microsecond
+	#define CTRL_TICK_CLK_MHZ	5
+	//Period of the control system in microseconds. Default and limits allowed at runtime with TICK
+	//Encoder speed is in counts per tick. PWM slopes, stall duration and the CALIB_* durations are in ticks. All scale with the period
+	#define CTRL_TICK_US		1000
+	#define MIN_CTRL_TICK_US	250
+	#define MAX_CTRL_TICK_US	2000
+	
+		///----------------------------------------------------------------------
+		///	SAFE STATE
+		///----------------------------------------------------------------------
+		//	The WDT is fed only by the main loop, only after a control tick completed. A hung control system or main loop resets the board
+		//	A reset leaves the pins as inputs. The VNH7040 inputs have pull downs and the motors coast
+		//	The BOD level is a fuse, see main.cpp. The VLM warns a little above it and holds the platform in CONTROL_STOP
+	
+	//WDT period. Several MAX_CTRL_TICK_US of margin. The WDT clock is the 1KHz ULP oscillator
+	#define WDT_PERIOD_SEL			WDT_PERIOD_16CLK_gc
+	//Voltage level monitor above the BOD level of the fuses
+	#define BOD_VLM_LEVEL_SEL		BOD_VLMLVL_5ABOVE_gc
+	//Control ticks the platform stays in CONTROL_STOP after the supply is back above the VLM level
+	#define BROWNOUT_HOLDOFF_TICKS	1000
+	
+		///----------------------------------------------------------------------
+		///	CONFIGURATION
+		///----------------------------------------------------------------------
+		//	One block in EEPROM. Version, size, parameters, CRC16 CCITT of the bytes before it
+		//	Loaded by init(). Defaults when blank, of another version, corrupted or out of range
+		//	Saved one EEPROM page at a time by the main loop. Nothing waits for the EEPROM
+	
+	//Layout of the block. Bump it with any change of the Config structure
+	#define CONFIG_VERSION			1
+	//Address of the block in EEPROM
+	#define CONFIG_EEPROM_ADDR		0
 	
 		///----------------------------------------------------------------------
 		///	PID
@@ -81,7 +213,8 @@
 		CONTROL_STOP,	//Emergency stop mode
 		CONTROL_PWM,		//PWM control mode. Just a slew rate limiter between user and drivers
 		CONTROL_SPD,		//Speed control mode
-		CONTROL_POS			//Position control mode
+		CONTROL_POS,		//Position control mode
+		CONTROL_CALIB		//Calibration of the linearization tables. PWM ramp on the motors of a mask
 	} Control_mode;
 
 	//Error codes that can be experienced by the program
@@ -93,9 +226,22 @@
 		ERR_UNIPARSER_RUNTIME,
 		ERR_BAD_BOARD_SIGN,
 		ERR_BAD_PARSER_RUNTIME_ARGUMENT,
-		ERR_ENC_RETRY							//The encoder failed to update global vars within its allowed retries
+		ERR_ENC_RETRY,							//The encoder failed to update global vars within its allowed retries
+		ERR_MOTOR_STALL,						//A motor drew the stall current without moving. Platform was stopped
+		ERR_BROWNOUT,							//Supply fell below the VLM level. Platform was stopped
+		ERR_MOTION_EXPIRED						//No motion command within its validity window. Platform was stopped
 	} Error_code;
 
+	//Outcome of the load of the configuration at boot
+	typedef enum _Config_status
+	{
+		CONFIG_LOADED,							//Block loaded from EEPROM
+		CONFIG_BLANK,							//EEPROM never written. Defaults
+		CONFIG_BAD_VERSION,						//Block of another layout. Defaults
+		CONFIG_BAD_CRC,							//Block corrupted. Defaults
+		CONFIG_BAD_VALUE						//Parameter out of range. Defaults
+	} Config_status;
+
 	/****************************************************************************
 	**	MACRO
 	****************************************************************************/
@@ -113,6 +259,8 @@
 
 	//Global flags raised by ISR functions
 	typedef struct _Isr_flags Isr_flags;
+	//Parameters of the board kept in EEPROM
+	typedef struct _Config Config;
 
 	/****************************************************************************
 	**	STRUCTURE
@@ -122,11 +270,29 @@
 	struct _Isr_flags
 	{
 		//First byte
-		uint8_t system_tick		: 1;	//System Tick
-		uint8_t ctrl_updt		: 1;	//Control System
+		uint8_t system_tick		: 1;	//System Tick. RTC PIT. Housekeeping
+		uint8_t ctrl_updt		: 1;	//Control System. TCA0 overflow
 		uint8_t enc_sem			: 1;	//true = Encoder ISR is forbidden to write into the 32b encoder counters
 		uint8_t enc_updt		: 1;	//true = Encoder ISR is forced to update the 32b counters and clear this flag if possible.
-		uint8_t					: 4;	//unused bits
+		uint8_t ctrl_done		: 1;	//A control tick completed. Main loop feeds the WDT
+		uint8_t					: 3;	//unused bits
+	};
+
+	//Parameters of the board kept in EEPROM. AVR has no padding, the structure is the EEPROM image
+	struct _Config
+	{
+		uint8_t version;			//CONFIG_VERSION. 0xff is a blank EEPROM
+		uint8_t size;				//sizeof(Config). Catches a layout change without a version bump
+		int16_t pwm_min;			//CFG_PWM_MIN
+		int16_t pwm_max;			//CFG_PWM_MAX
+		int16_t pwm_accel;			//CFG_PWM_ACCEL
+		int16_t pwm_decel;			//CFG_PWM_DECEL
+		uint8_t layout_reverse;		//CFG_LAYOUT_REVERSE
+		int8_t enc_update_th;		//CFG_ENC_UPDATE_TH
+		uint8_t link_timeout;		//CFG_LINK_TIMEOUT
+		uint16_t motion_timeout_ms;	//CFG_MOTION_TIMEOUT
+		uint8_t lin_lut[NUM_VNH7040][LIN_NUM_POINTS];	//PWM at each LIN_EFFORT_STEP of effort. Non decreasing. Written by CALIB
+		uint16_t crc;				//CRC16 CCITT of the bytes before it. Last field
 	};
 
 	/****************************************************************************
@@ -146,10 +312,27 @@
 
 	//Signal error
 	void report_error( Error_code err_code );
+	//Signal error from a real time context. Message is sent later by the main loop
+	void report_error_deferred( Error_code err_code );
 	//Error code handler function
 	void send_msg_ctrl_mode( void );
+	//Send messages deferred by the real time control system
+	void send_deferred_msg( void );
 	
 	void send_data( uint8_t data_len, int16_t *data );
+	//Send the timestamp and sequence number of the telemetry message that follows
+	void send_timestamp( uint32_t timestamp );
+	//Queue a log message. LOG_* id in orangebot_config.h. Safe from any context
+	void send_log( uint8_t id, int16_t arg0, int16_t arg1 );
+	//Send one queued log message if the TX buffer has headroom
+	void send_log_msg( void );
+	
+		///----------------------------------------------------------------------
+		///	TIMESTAMP
+		///----------------------------------------------------------------------
+	
+	//32 bit RTC timestamp in TIMESTAMP_HZ ticks. Safe from any context
+	extern uint32_t get_timestamp( void );
 	
 		///----------------------------------------------------------------------
 		///	PARSER
@@ -159,6 +342,8 @@
 	
 	//Handle Ping message coming from the RPI 3B+
 	extern void ping_handler( void );
+	//Handle clock synchronization ping. Answer with the token and the timestamp
+	extern void ping_sync_handler( uint32_t token );
 	//Handle Request for signature coming from the RPI 3B+
 	extern void send_signature_handler( void );
 	
@@ -168,6 +353,28 @@
 	extern void send_enc_pos_handler( uint8_t index );
 	//Handle request for all encoder speed
 	extern void send_enc_spd_handler( void );
+	//Handle request to change the period of the control system
+	extern void set_ctrl_tick_handler( uint16_t period_us );
+	//Handle request to change limit and slopes of one PWM channel
+	extern void set_pwm_param_handler( uint8_t index, int16_t max, int16_t accel, int16_t decel );
+	//Handle request for the motor currents
+	extern void send_current_handler( void );
+	//Handle request to change current limit and stall detection
+	extern void set_current_limit_handler( uint16_t limit_ma, uint16_t stall_ma, uint16_t stall_ticks );
+	//Handle request for the fault codes of the VNH7040. Also sent by main when they change
+	extern void send_diag_handler( void );
+	//Handle request for a configuration parameter
+	extern void send_config_handler( uint8_t id );
+	//Handle request to change a configuration parameter
+	extern void set_config_handler( uint8_t id, int16_t value );
+	//Handle request to save the configuration in EEPROM
+	extern void save_config_handler( void );
+	//Tell the RPI the configuration is in EEPROM. Sent by main when the save completes
+	extern void send_config_save_handler( void );
+	//Handle request to calibrate the linearization tables of the motors of a mask
+	extern void calib_handler( uint8_t mask );
+	//A valid command was received. Clear the link timeout
+	extern void link_heartbeat( void );
 
 		///----------------------------------------------------------------------
 		///	VNH7040 MOTORS
@@ -178,7 +385,68 @@
 	extern bool set_vnh7040_pwm( uint8_t index, int16_t pwm );
 	//Control PWM of the platform to move according to the layout
 	extern bool set_platform_pwm( int16_t right, int16_t left );
+	//Turn the effort of the control system into the PWM of a VNH7040 through its linearization table
+	extern int16_t linearize_vnh7040_pwm( uint8_t index, int16_t effort );
+	//Set limit and acceleration/deceleration slopes of the slew rate limiter of a VNH7040 channel
+	extern bool set_vnh7040_pwm_param( uint8_t index, uint16_t max, uint16_t accel, uint16_t decel );
+	//Get limit and acceleration/deceleration slopes of the slew rate limiter of a VNH7040 channel
+	extern bool get_vnh7040_pwm_param( uint8_t index, uint16_t &max, uint16_t &accel, uint16_t &decel );
 	
+		///----------------------------------------------------------------------
+		///	CURRENT SENSE
+		///----------------------------------------------------------------------
+
+	//ADC result ready. Filter the sample and start the conversion of the next channel
+	extern void current_sense_sample( uint16_t sample );
+	//Filtered current of a VNH7040. Safe from any context
+	extern uint16_t get_motor_current( uint8_t index );
+	//Scale the PWM of a channel to keep its current under the limit. Control system only
+	extern int16_t current_limit( uint8_t index, int16_t pwm );
+	//Detect a stalled channel from its current and encoder speed. Control system only
+	extern bool stall_detect( uint8_t index, int16_t pwm );
+	//Forget the limiter and stall history. Control system only
+	extern void current_limit_reset( void );
+	//Set current limit [mA], stall current [mA] and stall duration [ticks]
+	extern bool set_current_limit( uint16_t limit_ma, uint16_t stall_ma, uint16_t stall_ticks );
+	//Ask the ADC ISR for a diagnostic sweep. Does nothing if one is running
+	extern void diag_start( void );
+	//Turn a completed sweep into fault codes. true = the codes changed
+	extern bool diag_process( void );
+	//Fault code of a VNH7040. DIAG_* bit field
+	extern uint8_t get_diag_code( uint8_t index );
+	//Get current limit [mA], stall current [mA] and stall duration [ticks]
+	extern void get_current_limit( uint16_t &limit_ma, uint16_t &stall_ma, uint16_t &stall_ticks );
+
+		///----------------------------------------------------------------------
+		///	CONFIGURATION
+		///----------------------------------------------------------------------
+
+	//Load the configuration from EEPROM. Defaults if it is not valid. false = loaded
+	extern bool config_load( void );
+	//Get a configuration parameter. CFG_* id
+	extern int16_t config_get( uint8_t id );
+	//Change a configuration parameter and apply it. false = OK
+	extern bool config_set( uint8_t id, int16_t value );
+	//Start writing the configuration in EEPROM. false = OK | true = a save is running
+	extern bool config_save( void );
+	//Write the next EEPROM page of a save. true = the save just completed
+	extern bool config_process( void );
+	//CRC16 of the saved block
+	extern uint16_t get_config_crc( void );
+	//Replace the linearization table of a VNH7040. false = OK
+	extern bool config_set_lut( uint8_t index, const uint8_t *lut );
+
+		///----------------------------------------------------------------------
+		///	CALIBRATION
+		///----------------------------------------------------------------------
+
+	//Start the calibration of the motors of a mask. false = OK
+	extern bool calib_start( uint8_t mask );
+	//Step the PWM ramp and measure the speeds. Control system only. Returns the PWM of the tick, -1 = ramp completed
+	extern int16_t calib_update( void );
+	//Turn a completed ramp into linearization tables. true = the tables were just updated
+	extern bool calib_process( void );
+
 		///----------------------------------------------------------------------
 		///	ENCODERS
 		///----------------------------------------------------------------------
@@ -198,6 +466,10 @@
 	extern bool init_ctrl_system( void );
 	//Handle switch between control systems and execute the correct control system. Handles the stop mode.
 	extern bool control_system( void );
+	//Change the period of the control system tick
+	extern bool set_ctrl_tick( uint16_t period_us );
+	//A motion command was received. Restart its validity window
+	extern void motion_refresh( void );
 	
 	/****************************************************************************
 	**	PROTOTYPE: GLOBAL VARIABILE
@@ -209,6 +481,12 @@
 
 	//Volatile flags used by ISRs
 	extern volatile	Isr_flags g_isr_flags;
+	//Errors raised by the control system and waiting to be sent by the main loop. One bit per Error_code
+	extern volatile uint16_t g_err_pending;
+	//Control system switched mode and the main loop has to send the CTRL message
+	extern volatile bool g_f_ctrl_mode_pending;
+	//Upper 16 bit of the timestamp. Incremented by the RTC overflow
+	extern volatile uint16_t g_timestamp_ovf;
 	
 		///----------------------------------------------------------------------
 		///	BUFFERS
@@ -242,6 +520,8 @@
 	//Actual and target control system mode
 	extern Control_mode g_control_mode;
 	extern Control_mode g_control_mode_target;
+	//Period of the control system in microseconds. Encoder speed is measured in counts per period
+	extern uint16_t g_ctrl_tick_us;
 	
 	//Actual and target PWM settings for all DC motor controllers
 	extern int16_t g_pwm_target[NUM_VNH7040];
@@ -260,6 +540,30 @@
 	//Global 32b encoder counters
 	extern volatile int32_t g_enc_cnt[NUM_ENC];
 	
+		///--------------------------------------------------------------------------
+		///	CURRENT SENSE
+		///--------------------------------------------------------------------------
+	
+	//Filtered current of each VNH7040. Use get_motor_current
+	extern volatile uint16_t g_motor_current[NUM_VNH7040];
+	
+		///--------------------------------------------------------------------------
+		///	CONFIGURATION
+		///--------------------------------------------------------------------------
+	
+	//Parameters in use. Written only by main through config_set, read by the ISRs
+	extern Config g_config;
+	//Outcome of the load at boot and version found in EEPROM
+	extern Config_status g_config_status;
+	extern uint8_t g_config_version_found;
+	
+		///--------------------------------------------------------------------------
+		///	CALIBRATION
+		///--------------------------------------------------------------------------
+	
+	//Motors of the calibration. Bit mask
+	extern volatile uint8_t g_calib_mask;
+	
 	//Encoder absolute position
 	extern int32_t g_enc_pos[NUM_ENC];
 	//Encoder speed
@@ -39,14 +39,20 @@ extern void init_clock( void );
 extern void init_pin( void );
 //Initialize RTC timer as periodic interrupt
 extern void init_rtc( void );
-//Initialize timer type A. AT4809 has a single of such timers.
-extern void init_timer0a_split( void );
+//Initialize timer type A as 16bit timer. Overflow is the control system tick
+extern void init_timer0a_single( uint16_t period_us );
 //setup one of four timers type B of the AT4809 as PWM generator
 extern void init_timer_b( TCB_t &timer );
 //Initialize one of four USART transceivers
 extern void init_uart( USART_t &usart );
 //Initialize port multiplexer for alternate functions
 extern void init_mux( void );
+//Initialize ADC0 as free running sequencer of the VNH7040 current sense
+extern void init_adc( void );
+//Initialize the voltage level monitor of the brownout detector
+extern void init_bod( void );
+//Arm and lock the watchdog timer
+extern void init_wdt( void );
 
 /****************************************************************************
 **	FUNCTIONS DECLARATIONS
@@ -76,6 +82,9 @@ void init(void)
 	//	BODY
 	//----------------------------------------------------------------
 
+	//Load the parameters from EEPROM before anything uses them
+	config_load();
+
 	//Initialize clock systems
 	init_clock();
 	
@@ -88,8 +97,8 @@ void init(void)
 	//Initialize RTC timer as Periodic interrupt source: RTC_PIT_vect
 	init_rtc();
 	
-	//Initialize timer type A
-	init_timer0a_split();
+	//Initialize timer type A as control system tick: TCA0_OVF_vect
+	init_timer0a_single( CTRL_TICK_US );
 	
 	//Initialize four timers type B as 20KHz 8bit PWM generators for the VNH7040 Motor drivers
 	init_timer_b( TCB0 );
@@ -99,6 +108,18 @@ void init(void)
 
 	//Initialize USART 3 as async UART 256.4Kb/s
 	init_uart( USART3 );
+	
+	//Initialize ADC0 to sample the VNH7040 current sense: ADC0_RESRDY_vect
+	init_adc();
+	
+	//Initialize all control systems. The control ISR runs them as soon as interrupts are on
+	init_ctrl_system();
+	
+	//Initialize brownout early warning. Polled by the control system
+	init_bod();
+	
+	//Arm the watchdog last. From now on the control system must tick
+	init_wdt();
 
 	//Activate interrupts
 	sei();
@@ -360,6 +381,8 @@ void init_mux( void )
 //! Interrupt vectors:
 //!		RTC_CNT_vect
 //!		RTC_PIT_vect
+//!	The counter runs free over 16 bit. Overflow extends it to the 32 bit timestamp
+//!	The PIT has its own divider and is not affected by PER
 /***************************************************************************/
 
 void init_rtc( void )
@@ -452,8 +475,8 @@ void init_rtc( void )
 	//! RTC Interrupts
 	//----------------------------------------------------------------
 
-	//! Enable overflow interrupt
-	//SET_BIT( intctrl_tmp, RTC_OVF_bp );
+	//! Enable overflow interrupt. Upper 16 bit of the timestamp
+	SET_BIT( intctrl_tmp, RTC_OVF_bp );
 	//! Enable Compare Match interrupt
 	//SET_BIT( intctrl_tmp, RTC_CMP_bp );
 	//! Enable Periodic Interrupt timer
@@ -467,9 +490,10 @@ void init_rtc( void )
 	//Calibration PPM of the RTC counter. Meant to be done in software against more precise clock sources.
 	RTC.CALIB = (uint8_t)0x00;
 
-	//Wait for the ***
-	//while (IS_BIT_ONE(RTC.STATUS, RTC_PERBUSY_bp));
-	RTC.PER = (uint16_t)0;
+	//Wait for the period register to synchronize with the RTC clock domain
+	while (IS_BIT_ONE(RTC.STATUS, RTC_PERBUSY_bp));
+	//Free running counter. Full 16 bit before overflow
+	RTC.PER = (uint16_t)0xffff;
 	//Compare register for compare interrupt
 	RTC.CMP = (uint16_t)0;
 
@@ -489,53 +513,46 @@ void init_rtc( void )
 
 /****************************************************************************
 **  Function
-**  init_timer_a |
+**  init_timer0a_single | uint16_t
 ****************************************************************************/
-//! @brief initialize timer type a in split mode as two 8bit timers with six compare channels
-//! @details setup the only timer type A of the AT4809
+//! @param period_us | uint16_t | period of the overflow interrupt in microseconds
+//! @brief initialize timer type a in normal mode as one 16bit timer
+//! @details setup the only timer type A of the AT4809 as control system tick
 //!
-//!	Clock from event control is disabled in SPLIT mode
+//!	TCA0 clock is CLK_PER/4 = 5MHz. It also clocks the TCB PWM generators through CLKTCA
+//!	keep the prescaler at DIV4 or the VNH7040 PWM frequency changes
+//!	Overflow period is (PER+1)/5MHz. 250us to 2ms are 1250 to 10000 TCA0 ticks
 //!
-//! Interrupt vectors available:
-//! TCA0_LUNF_vect
+//! Interrupt vectors used:
 //! TCA0_OVF_vect
-//! TCA0_HUNF_vect
-//! TCA0_LCMP0_vect
-//! TCA0_CMP0_vect
-//! TCA0_CMP1_vect
-//! TCA0_LCMP1_vect
-//! TCA0_LCMP2_vect
-//! TCA0_CMP2_vect
 /***************************************************************************/
 
-void init_timer0a_split( void )
+void init_timer0a_single( uint16_t period_us )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
 	//Load temporary registers
-	uint8_t ctrla_tmp			= TCA0.SPLIT.CTRLA;
-	uint8_t ctrlb_tmp			= TCA0.SPLIT.CTRLB;
-	uint8_t ctrlc_tmp			= TCA0.SPLIT.CTRLC;
-	uint8_t ctrld_tmp			= TCA0.SPLIT.CTRLD;
-	uint8_t ctrle_tmp			= TCA0.SPLIT.CTRLESET;
-	uint8_t dbgctrl_tmp			= TCA0.SPLIT.DBGCTRL;
-	uint8_t port_mux_tca0_tmp	= PORTMUX.TCAROUTEA;
-	uint8_t intctrl_tmp			= TCA0.SPLIT.INTCTRL;
+	uint8_t ctrla_tmp			= TCA0.SINGLE.CTRLA;
+	uint8_t ctrlb_tmp			= TCA0.SINGLE.CTRLB;
+	uint8_t ctrlc_tmp			= TCA0.SINGLE.CTRLC;
+	uint8_t ctrld_tmp			= TCA0.SINGLE.CTRLD;
+	uint8_t dbgctrl_tmp			= TCA0.SINGLE.DBGCTRL;
+	uint8_t intctrl_tmp			= TCA0.SINGLE.INTCTRL;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
 		//----------------------------------------------------------------
-		//! Enable Split Mode
+		//! Disable Split Mode
 		//----------------------------------------------------------------
 		//	Function of registers change according to the mode.
 		//	0 = 3x 16bit
 		//	1 = 6x 8bit
 
-	SET_BIT( ctrld_tmp, TCA_SPLIT_SPLITM_bp );
+	CLEAR_BIT( ctrld_tmp, TCA_SINGLE_SPLITM_bp );
 
 		//----------------------------------------------------------------
 		//! Enable TCA
@@ -543,71 +560,53 @@ void init_timer0a_split( void )
 		//	0 = disabled
 		//	1 = enabled
 
-	SET_BIT( ctrla_tmp, TCA_SPLIT_ENABLE_bp );
+	SET_BIT( ctrla_tmp, TCA_SINGLE_ENABLE_bp );
 
 		//----------------------------------------------------------------
 		//! TCA Clock Prescaler
 		//----------------------------------------------------------------
 		//	Set the clock prescaler of this TCA. Activate only one value
+		//	TCB PWM generators are clocked by TCA. Keep DIV4
 
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV1_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV2_gc );
-	SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV4_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV8_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV16_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV64_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV256_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV1024_gc );
-
-		//----------------------------------------------------------------
-		//! TCA Enable compare output and waveform output pin override for each compare channel
-		//----------------------------------------------------------------
-
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_LCMP0EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_LCMP1EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_LCMP2EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_HCMP0EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_HCMP1EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_HCMP2EN_bp );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV1_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV2_gc );
+	SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV4_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV8_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV16_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV64_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV256_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV1024_gc );
 
 		//----------------------------------------------------------------
-		//! TCA Enable timer commands
+		//! TCA Waveform generation mode
 		//----------------------------------------------------------------
+		//	Normal mode. Count from BOTTOM to PER then overflow
 
-	//Disable force commands
-	SET_MASKED_BIT( ctrle_tmp, (uint8_t)0x03 , (uint8_t)0x00 );
-	//ENABLE force commands for both channels
-	//SET_MASKED_BIT( ctrle_tmp, (uint8_t)0x03 , (uint8_t)0x03 );
+	SET_MASKED_BIT( ctrlb_tmp, TCA_SINGLE_WGMODE_gm, TCA_SINGLE_WGMODE_NORMAL_gc );
+	//SET_MASKED_BIT( ctrlb_tmp, TCA_SINGLE_WGMODE_gm, TCA_SINGLE_WGMODE_FRQ_gc );
+	//SET_MASKED_BIT( ctrlb_tmp, TCA_SINGLE_WGMODE_gm, TCA_SINGLE_WGMODE_SINGLESLOPE_gc );
 
 		//----------------------------------------------------------------
 		//! ENABLE TCA interrupts
 		//----------------------------------------------------------------
 
-	//Underflow of low counter
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LUNF_bp );
-	//Underflow of high counter
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_HUNF_bp );
+	//Overflow. Control system tick
+	SET_BIT( intctrl_tmp, TCA_SINGLE_OVF_bp );
 	//Compare channel
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LCMP0_bp );
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LCMP1_bp );
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LCMP2_bp );
+	//SET_BIT( intctrl_tmp, TCA_SINGLE_CMP0_bp );
+	//SET_BIT( intctrl_tmp, TCA_SINGLE_CMP1_bp );
+	//SET_BIT( intctrl_tmp, TCA_SINGLE_CMP2_bp );
 
-		//----------------------------------------------------------------
-		//! ENABLE TCA debug
-		//----------------------------------------------------------------
-
-	SET_BIT( dbgctrl_tmp, TCA_SPLIT_DBGRUN_bp );
+	#ifdef CTRL_SYS_IN_ISR
+	//! Overflow interrupt executes the control system. Give it level 1 priority so it preempts all other ISRs
+	CPUINT.LVL1VEC = TCA0_OVF_vect_num;
+	#endif
 
 		//----------------------------------------------------------------
-		//! Set TCA waveform outputs to a given port. You can activate only one port
+		//! ENABLE TCA debug
 		//----------------------------------------------------------------
 
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTA_gc );	//default
-	SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTB_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTC_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTD_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTE_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTF_gc );
+	SET_BIT( dbgctrl_tmp, TCA_SINGLE_DBGRUN_bp );
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -615,33 +614,22 @@ void init_timer0a_split( void )
 
 	//! Register write back.
 	//Write back control registers
-	TCA0.SPLIT.CTRLB = ctrlb_tmp;
-	TCA0.SPLIT.CTRLC = ctrlc_tmp;
-	TCA0.SPLIT.CTRLD = ctrld_tmp;
-	TCA0.SPLIT.CTRLESET = ctrle_tmp;
-	TCA0.SPLIT.DBGCTRL = dbgctrl_tmp;
-	//Write back output waveform port selector
-	PORTMUX.TCAROUTEA = port_mux_tca0_tmp;
-
-	//Period registers for the High and Low 8bit counters
-	TCA0.SPLIT.LPER = (uint8_t)255;
-	TCA0.SPLIT.HPER = (uint8_t)255;
-	//Initial PWM settings for channels L0 to L2
-	TCA0.SPLIT.LCMP0 = (uint8_t)0x00;
-	TCA0.SPLIT.LCMP1 = (uint8_t)0x00;
-	TCA0.SPLIT.LCMP2 = (uint8_t)0x00;
-	//Initial PWM settings for channels H0 to H2
-	TCA0.SPLIT.HCMP0 = (uint8_t)0x00;
-	TCA0.SPLIT.HCMP1 = (uint8_t)0x00;
-	TCA0.SPLIT.HCMP2 = (uint8_t)0x0;
+	TCA0.SINGLE.CTRLB = ctrlb_tmp;
+	TCA0.SINGLE.CTRLC = ctrlc_tmp;
+	TCA0.SINGLE.CTRLD = ctrld_tmp;
+	TCA0.SINGLE.DBGCTRL = dbgctrl_tmp;
+
+	//Period of the control system tick
+	TCA0.SINGLE.PER = (uint16_t)(period_us *CTRL_TICK_CLK_MHZ -1);
+	TCA0.SINGLE.CNT = (uint16_t)0;
 
 	//Write back control A for last as it's the one that sets the clock and starts the timer
-	TCA0.SPLIT.CTRLA = ctrla_tmp;
+	TCA0.SINGLE.CTRLA = ctrla_tmp;
 	//Write back interrupt enable
-	TCA0.SPLIT.INTCTRL = intctrl_tmp;
+	TCA0.SINGLE.INTCTRL = intctrl_tmp;
 
 	return;
-}	//End: init_timer0a
+}	//End: init_timer0a_single | uint16_t
 
 /****************************************************************************
 **  Function
@@ -921,3 +909,187 @@ void init_uart( USART_t &usart )
 
 	return;
 }	//End: init_uart
+
+/****************************************************************************
+**  Function
+**  init_adc |
+****************************************************************************/
+//! @brief Initialize ADC0 as free running sequencer of the VNH7040 current sense
+//! @details
+//! Interrupt vectors:
+//!		ADC0_RESRDY_vect
+//!	DRVn_SENSE is on PDn, AINn. The RESRDY ISR filters the result, moves MUXPOS
+//!	to the next channel and starts the next conversion. No polling in the main loop
+//!	The sense output is enabled by PF0 in main
+//!	CLK_ADC = 20MHz /32 = 625KHz. Each result accumulates 4 conversions of 10 bit
+//!	About 100us per result, 400us for a round of four channels
+//!	Reference is VDD. The sense output of the VNH7040 is ratiometric to its resistor
+/***************************************************************************/
+
+void init_adc( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//! Fetch registers
+	uint8_t ctrla_tmp		= ADC0.CTRLA;
+	uint8_t ctrlb_tmp		= ADC0.CTRLB;
+	uint8_t ctrlc_tmp		= ADC0.CTRLC;
+	uint8_t ctrld_tmp		= ADC0.CTRLD;
+	uint8_t intctrl_tmp		= ADC0.INTCTRL;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//! Enable the ADC
+	SET_BIT( ctrla_tmp, ADC_ENABLE_bp );
+	//! Let the ADC run in standby mode
+	//SET_BIT( ctrla_tmp, ADC_RUNSTBY_bp );
+	//! Free running mode. Not used: the ISR must move MUXPOS before the next conversion starts
+	//SET_BIT( ctrla_tmp, ADC_FREERUN_bp );
+	
+	//! Resolution. Select only one
+	SET_MASKED_BIT( ctrla_tmp, ADC_RESSEL_gm, ADC_RESSEL_10BIT_gc );
+	//SET_MASKED_BIT( ctrla_tmp, ADC_RESSEL_gm, ADC_RESSEL_8BIT_gc );
+
+	//! Conversions accumulated in one result. Select only one
+	//SET_MASKED_BIT( ctrlb_tmp, ADC_SAMPNUM_gm, ADC_SAMPNUM_ACC1_gc );
+	//SET_MASKED_BIT( ctrlb_tmp, ADC_SAMPNUM_gm, ADC_SAMPNUM_ACC2_gc );
+	SET_MASKED_BIT( ctrlb_tmp, ADC_SAMPNUM_gm, ADC_SAMPNUM_ACC4_gc );
+	//SET_MASKED_BIT( ctrlb_tmp, ADC_SAMPNUM_gm, ADC_SAMPNUM_ACC8_gc );
+
+	//! Reduced sampling capacitance. Recommended for reference above 1V
+	SET_BIT( ctrlc_tmp, ADC_SAMPCAP_bp );
+	
+	//! Reference. Select only one
+	//SET_MASKED_BIT( ctrlc_tmp, ADC_REFSEL_gm, ADC_REFSEL_INTREF_gc );
+	SET_MASKED_BIT( ctrlc_tmp, ADC_REFSEL_gm, ADC_REFSEL_VDDREF_gc );
+	//SET_MASKED_BIT( ctrlc_tmp, ADC_REFSEL_gm, ADC_REFSEL_VREFA_gc );
+
+	//! Prescaler of CLK_PER. CLK_ADC must stay below 1.5MHz at 10 bit. Select only one
+	//SET_MASKED_BIT( ctrlc_tmp, ADC_PRESC_gm, ADC_PRESC_DIV16_gc );
+	SET_MASKED_BIT( ctrlc_tmp, ADC_PRESC_gm, ADC_PRESC_DIV32_gc );
+	//SET_MASKED_BIT( ctrlc_tmp, ADC_PRESC_gm, ADC_PRESC_DIV64_gc );
+
+	//! Delay of the first conversion after enable. At least 32us for the VDD reference
+	SET_MASKED_BIT( ctrld_tmp, ADC_INITDLY_gm, ADC_INITDLY_DLY32_gc );
+
+	//----------------------------------------------------------------
+	//! ADC Interrupts
+	//----------------------------------------------------------------
+
+	//! Enable Result Ready interrupt
+	SET_BIT( intctrl_tmp, ADC_RESRDY_bp );
+	//! Enable Window Comparator interrupt
+	//SET_BIT( intctrl_tmp, ADC_WCMP_bp );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//! Disable the digital input buffers of the sense pins
+	for (uint8_t t = 0;t < NUM_VNH7040;t++)
+	{
+		(&PORTD.PIN0CTRL)[t] = PORT_ISC_INPUT_DISABLE_gc;
+	}
+	
+	//! Registers write back
+	ADC0.CTRLB = ctrlb_tmp;
+	ADC0.CTRLC = ctrlc_tmp;
+	ADC0.CTRLD = ctrld_tmp;
+	//Sampling length extension in CLK_ADC cycles. The sense output has a high impedance
+	ADC0.SAMPCTRL = 2;
+	//First channel
+	ADC0.MUXPOS = ADC_MUXPOS_AIN0_gc;
+	ADC0.INTCTRL = intctrl_tmp;
+	//Write this register last as it activates the ADC
+	ADC0.CTRLA = ctrla_tmp;
+	//Start the sequence. The RESRDY ISR starts the next conversions
+	ADC0.COMMAND = ADC_STCONV_bm;
+
+	return;
+}	//End: init_adc
+
+/****************************************************************************
+**  Function
+**  init_bod |
+****************************************************************************/
+//! @brief Initialize the voltage level monitor of the brownout detector
+//! @details
+//!	The BOD itself is configured by the BODCFG fuse, see main.cpp
+//!	The VLM only works when the fuse enables the BOD in active mode
+//!	No interrupt. The control system polls BOD.STATUS every tick
+/***************************************************************************/
+
+void init_bod( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//! Fetch registers
+	uint8_t vlmctrla_tmp	= BOD.VLMCTRLA;
+	uint8_t intctrl_tmp		= BOD.INTCTRL;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//! VLM level above the BOD level
+	SET_MASKED_BIT( vlmctrla_tmp, BOD_VLMLVL_gm, BOD_VLM_LEVEL_SEL );
+
+	//----------------------------------------------------------------
+	//! BOD Interrupts
+	//----------------------------------------------------------------
+
+	//! Enable VLM interrupt
+	//SET_BIT( intctrl_tmp, BOD_VLMIE_bp );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//! Registers write back
+	BOD.VLMCTRLA = vlmctrla_tmp;
+	BOD.INTCTRL = intctrl_tmp;
+
+	return;
+}	//End: init_bod
+
+/****************************************************************************
+**  Function
+**  init_wdt |
+****************************************************************************/
+//! @brief Arm and lock the watchdog timer
+//! @details
+//!	Normal mode, no window. The main loop feeds it after each completed control tick
+//!	Locked, a runaway code can't disable it. Only a reset unlocks it
+/***************************************************************************/
+
+void init_wdt( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Timeout period. Protected register
+	_PROTECTED_WRITE( WDT.CTRLA, WDT_PERIOD_SEL );
+	//Lock the configuration
+	_PROTECTED_WRITE( WDT.STATUS, WDT_LOCK_bm );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End: init_wdt
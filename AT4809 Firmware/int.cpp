@@ -20,6 +20,9 @@
 **GLOBAL VARS
 ****************************************************************************/
 
+//Upper 16 bit of the timestamp. Incremented by the RTC overflow
+volatile uint16_t g_timestamp_ovf = 0;
+
 /****************************************************************************
 ** INTERRUPT SERVICE ROUTINE
 *****************************************************************************
@@ -30,6 +33,7 @@
 **	RTC Periodic Interrupt
 *****************************************************************************
 **	Periodic interrupt generated by the RTC from it's independent clock source
+**	Housekeeping tick. LED and communication timeout
 ****************************************************************************/
 
 ISR( RTC_PIT_vect )
@@ -57,6 +61,71 @@ ISR( RTC_PIT_vect )
 	RTC.PITINTFLAGS = RTC_PI_bm;
 }
 
+/****************************************************************************
+**	RTC Counter Interrupt
+*****************************************************************************
+**	RTC counter overflow. Every 2s at 32.768KHz
+**	Extend the 16 bit counter to the 32 bit timestamp
+****************************************************************************/
+
+ISR( RTC_CNT_vect )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+	
+	//Upper 16 bit of the timestamp
+	g_timestamp_ovf++;
+	
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	//Manually clear the interrupt flag
+	RTC.INTFLAGS = RTC_OVF_bm;
+}
+
+/****************************************************************************
+**	TCA0 Overflow Interrupt
+*****************************************************************************
+**	Control system tick. Period is CTRL_TICK_US and can be changed at runtime
+**	CTRL_SYS_IN_ISR: this ISR is level 1 priority and executes the control system
+**	so that the sampling instant does not depend on the main loop load
+****************************************************************************/
+
+ISR( TCA0_OVF_vect )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+	
+	//Manually clear the interrupt flag. Clear it first, control system can take a while
+	TCA0.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm;
+	
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+	
+	#ifdef CTRL_SYS_IN_ISR
+	//Execute encoder snapshot, control system and PWM write
+	control_system();
+	//Tick completed. Main loop feeds the WDT
+	g_isr_flags.ctrl_done = true;
+	#else
+	//Authorize the main loop to execute one step of the control system
+	g_isr_flags.ctrl_updt = true;
+	#endif
+	
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+}
+
 /****************************************************************************
 **	USART3 RX Interrupt
 *****************************************************************************
@@ -91,6 +160,31 @@ ISR( USART3_RXC_vect )
 	
 }
 
+/****************************************************************************
+**  ISR
+**  ADC0_RESRDY_vect
+****************************************************************************/
+//! @brief
+//! @details
+//! A VNH7040 current sense conversion is complete
+//! Reading the result clears the flag. The sequencer starts the next conversion
+/***************************************************************************/
+
+ISR( ADC0_RESRDY_vect )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+	
+	//Filter the result and start the next channel
+	current_sense_sample( ADC0.RES );
+	
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+} //End ISR: ADC0_RESRDY_vect
+
 /****************************************************************************
 **  ISR
 **  PORTC_PORT_vect
@@ -100,21 +194,88 @@ ISR( USART3_RXC_vect )
 //! Any edge on any pin in PORTC will trigger this interrupt
 //! Call the quad channel encoder decoder routine
 //! Do it as call because the routine can be called from elsewhere
+//!	CTRL_SYS_IN_ISR: the level 1 control ISR calls the decoder too. Block it while decoding
+//!	Only the flags raised before the read of the pins are cleared. An edge after it raises the ISR again
 /***************************************************************************/
 
 ISR( PORTC_PORT_vect )
 {
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+	
+	//Interrupt flags serviced by this execution
+	uint8_t flags;
+	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 	
+	#ifdef CTRL_SYS_IN_ISR
+	//Decoder is not reentrant. Forbid the control ISR from preempting it
+	cli();
+	#endif
+	//Clear the Interrupt Flags of PORTC that the read of the pins below services
+	flags = PORTC.INTFLAGS;
+	PORTC.INTFLAGS = flags;
 	//quad channel encoder decoder routine
 	quad_encoder_decoder( PORTC.IN );
+	#ifdef CTRL_SYS_IN_ISR
+	//Allow the control ISR again
+	sei();
+	#endif
 	
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
-	//Clear the Interrupt Flags of PORTC
-	PORTC.INTFLAGS = (uint8_t)0xff;
 } //End ISR: PORTC_PORT_vect
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief function
+//!	get_timestamp | void
+/***************************************************************************/
+//! @return uint32_t | RTC timestamp in TIMESTAMP_HZ ticks
+//!	@details
+//!	Counter and overflow count are read with interrupts off
+//!	If the counter wrapped and the overflow ISR did not run yet, account for it here
+/***************************************************************************/
+
+uint32_t get_timestamp( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Lower 16 bit
+	uint16_t cnt_tmp;
+	//Upper 16 bit
+	uint16_t ovf_tmp;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	sreg_tmp = SREG;
+	cli();
+	cnt_tmp = RTC.CNT;
+	ovf_tmp = g_timestamp_ovf;
+	//If: overflow is pending and the counter was read after it
+	if ((IS_BIT_ONE( RTC.INTFLAGS, RTC_OVF_bp )) && (cnt_tmp < 0x8000))
+	{
+		ovf_tmp++;
+	}
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return (((uint32_t)ovf_tmp) << 16) | cnt_tmp;
+}	//End function: get_timestamp | void
@@ -49,6 +49,10 @@
 **	Prune out everything and slowly add modules back in
 **		2020-01-03
 **	Reworked VNH7040 HAL API to hide direction, 8bit PWM and reverse layout.
+**	CTRL_SYS_IN_ISR option: control system executes inside the level 1 RTC PIT ISR. Messages are deferred to the main loop
+**	Control system tick from TCA0 overflow. 250us to 2ms. Runtime selectable with TICK command. RTC PIT is only housekeeping
+**	WDT fed only by completed control ticks. BOD VLM holds the platform in CONTROL_STOP. Reset flags reported and cleared on boot
+**	Linearization table per motor replaces the PWM dead zone. CALIB measures the tables with a PWM ramp, CFG_SAVE keeps them in EEPROM
 ****************************************************************/
 
 /****************************************************************
@@ -64,6 +68,16 @@
 **	uC_CTRLB	|	PA5		|	PA7		|	PB3		|	PD7		|	INB
 ****************************************************************/
 
+/****************************************************************
+**	FUSES
+****************************************************************
+**	BODCFG	= 0xE5	| BOD enabled in active and sleep mode. BODLEVEL7 4.3V. CLK_PER 20MHz wants VDD above 4.5V
+**	WDTCFG	= 0x00	| WDT off at reset. init_wdt() arms and locks it, so a programmer or bootloader is never reset
+**	Other fuses are left at their default
+**	The FUSES section below writes them into the .fuse section of the ELF. Programmers flash them with the code
+**	LOG_BOOT reports RSTCTRL.RSTFR and FUSE.BODCFG. With another BODCFG the VLM does not stop the motors
+****************************************************************/
+
 /****************************************************************
 **	KNOWN BUGS
 ****************************************************************
@@ -98,6 +112,28 @@
 #include "global.h"
 //hard delay
 #include <util/delay.h>
+//wdt_reset
+#include <avr/wdt.h>
+//FUSES section of the ELF
+#include <avr/fuse.h>
+
+/****************************************************************
+** FUSES
+****************************************************************/
+
+FUSES =
+{
+	//0x00 | WDT off at reset. init_wdt() arms and locks it
+	.WDTCFG = WDT_PERIOD_OFF_gc | WDT_WINDOW_OFF_gc,
+	//0xE5 | BOD enabled in active and sleep mode. BODLEVEL7 4.3V
+	.BODCFG = BOD_LVL_BODLEVEL7_gc | BOD_SAMPFREQ_1KHZ_gc | BOD_ACTIVE_ENABLED_gc | BOD_SLEEP_ENABLED_gc,
+	//Defaults
+	.OSCCFG = FUSE_OSCCFG_DEFAULT,
+	.SYSCFG0 = FUSE_SYSCFG0_DEFAULT,
+	.SYSCFG1 = FUSE_SYSCFG1_DEFAULT,
+	.APPEND = FUSE_APPEND_DEFAULT,
+	.BOOTEND = FUSE_BOOTEND_DEFAULT,
+};
 
 /****************************************************************
 ** FUNCTION PROTOTYPES
@@ -163,12 +199,18 @@ int main(void)
 	//	VARS
 	//----------------------------------------------------------------
 
-	//system tick prescaler
+	//system tick prescaler. Housekeeping
 	uint8_t pre = 0;
 	//activity LED prescaler
 	uint8_t pre_led = 0;
 	//Blink speed of the LED. Start slow
 	uint8_t blink_speed = 99;
+	//Communication timeouts since boot
+	int16_t timeout_cnt = 0;
+	//VNH7040 diagnostic sweep prescaler
+	uint8_t pre_diag = 0;
+	//Cause of the last reset. RSTCTRL.RSTFR
+	uint8_t reset_flags;
 	
 	
 	//----------------------------------------------------------------
@@ -188,7 +230,7 @@ int main(void)
 		//!	Initialize VNH7040
 	//Enable sense output
 	SET_BIT_VALUE( PORTF.OUT, 0, true );
-	//Diagnostic mode OFF
+	//Diagnostic mode OFF. The ADC ISR raises it during a diagnostic sweep
 	SET_BIT_VALUE( PORTF.OUT, 1, false );
 	
 		///----------------------------------------------------------------------
@@ -197,8 +239,13 @@ int main(void)
 	
 	//Initialize UART parser from RPI to OrangeBot Motor Board
 	init_parser_commands( rpi_rx_parser );
-	//Initialize all control systems
-	init_ctrl_system();
+	//Why the board started. Flags are sticky across resets other than power on. Clear them
+	reset_flags = RSTCTRL.RSTFR;
+	RSTCTRL.RSTFR = reset_flags;
+	//Tell the RPI why the board started and how the BOD is configured
+	send_log( LOG_BOOT, reset_flags, FUSE.BODCFG );
+	//Tell the RPI whether the parameters came from EEPROM
+	send_log( LOG_CONFIG, g_config_status, g_config_version_found );
 	
 	//----------------------------------------------------------------
 	//	BODY
@@ -220,9 +267,6 @@ int main(void)
 			//If prescaler has reset
 			if (pre == 0)
 			{
-				//Execute speed PID
-				g_isr_flags.ctrl_updt = true;
-				
 				//----------------------------------------------------------------
 				//	LED BLINK
 				//----------------------------------------------------------------
@@ -238,6 +282,17 @@ int main(void)
 				//Increment with top
 				pre_led = AT_TOP_INC( pre_led, blink_speed );
 				
+				//----------------------------------------------------------------
+				//	VNH7040 DIAGNOSTIC
+				//----------------------------------------------------------------
+				//	The ADC ISR performs the sweep between its rounds. Main only asks
+				
+				if (pre_diag == 0)
+				{
+					diag_start();
+				}
+				pre_diag = AT_TOP_INC( pre_diag, DIAG_PERIOD );
+				
 				//----------------------------------------------------------------
 				//	PARSER TIMEOUT
 				//----------------------------------------------------------------
@@ -248,7 +303,7 @@ int main(void)
 					//Update communication timeout counter
 					g_uart_timeout_cnt++;
 					//If: timeout 
-					if (g_uart_timeout_cnt >= RPI_COM_TIMEOUT)
+					if (g_uart_timeout_cnt >= g_config.link_timeout)
 					{
 						//If: it's the first time the communication timeout is detected
 						if (g_f_timeout_detected == false)
@@ -262,13 +317,15 @@ int main(void)
 						g_control_mode_target = CONTROL_STOP;
 						//If, communication timeout was detected
 						report_error( ERR_CODE_COMMUNICATION_TIMEOUT );
+						timeout_cnt++;
+						send_log( LOG_TIMEOUT, timeout_cnt, 0 );
 					}
 				}
 				//If: currently in timeout
 				else
 				{
 					//If timeout counter has been reset
-					if (g_uart_timeout_cnt < RPI_COM_TIMEOUT)
+					if (g_uart_timeout_cnt < g_config.link_timeout)
 					{
 						//This is the only code allowed to reset the timeout flag
 						g_f_timeout_detected = false;
@@ -278,7 +335,7 @@ int main(void)
 				}
 			}
 			//Increment prescaler and reset if it exceeds the TOP.
-			pre = AT_TOP_INC( pre, PRE_CTRL_SYS);
+			pre = AT_TOP_INC( pre, PRE_HOUSEKEEPING );
 			
 		}	//End If: System Tick
 		
@@ -293,8 +350,48 @@ int main(void)
 			g_isr_flags.ctrl_updt = 0;
 			//Execute the control system for all VNH7040 motor controllers
 			control_system();
+			//Tick completed
+			g_isr_flags.ctrl_done = 1;
 		}	//End If: Authorized to execute one step the PID speed controllers
 		
+		//----------------------------------------------------------------
+		//	WATCHDOG
+		//----------------------------------------------------------------
+		//	Fed only when a control tick completed. If the control system or this loop hang, the WDT resets the board
+		
+		//If: a control tick completed since the last feed
+		if (g_isr_flags.ctrl_done == 1)
+		{
+			//Clear flag
+			g_isr_flags.ctrl_done = 0;
+			//Feed the WDT
+			wdt_reset();
+		}
+		
+		//----------------------------------------------------------------
+		//	DEFERRED MESSAGES
+		//----------------------------------------------------------------
+		//	The control system is not allowed to push into the TX buffer
+		
+		//Send mode switch and error messages raised by the control system
+		send_deferred_msg();
+		//If: a diagnostic sweep changed the fault codes of the drivers
+		if (diag_process() == true)
+		{
+			//Tell the RPI without waiting for a request
+			send_diag_handler();
+		}
+		//If: a save of the configuration just completed
+		if (config_process() == true)
+		{
+			//Tell the RPI the parameters are in EEPROM
+			send_config_save_handler();
+		}
+		//Turn a completed calibration ramp into linearization tables. Results go out as LOG_CALIB
+		calib_process();
+		//Log messages only use the room left by the control replies
+		send_log_msg();
+		
 		//----------------------------------------------------------------
 		//	AT4809 --> RPI USART TX
 		//----------------------------------------------------------------
@@ -335,6 +432,12 @@ int main(void)
 			if (rpi_rx_parser.parse( rx_tmp ) == true)
 			{
 				report_error( ERR_UNIPARSER_RUNTIME );
+				send_log( LOG_PARSER_ERR, (int16_t)rpi_rx_parser.get_error(), 0 );
+			}
+			//If: a command was completed. Link is alive
+			if (rpi_rx_parser.is_executed() == true)
+			{
+				link_heartbeat();
 			}
 			
 		} //endif: RPI RX buffer is not empty
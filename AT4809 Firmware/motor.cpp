@@ -28,8 +28,18 @@
 //Actual and target control system mode
 Control_mode g_control_mode					= CONTROL_STOP;
 Control_mode g_control_mode_target			= CONTROL_STOP;
+//Period of the control system in microseconds
+uint16_t g_ctrl_tick_us						= CTRL_TICK_US;
 //Slew rate limiter controller for the PWM channels
 Orangebot::Ctrl_pwm g_vnh7040_pwm_ctrl;
+//Control ticks left before the platform may leave CONTROL_STOP after a stall or a brownout
+uint16_t g_safe_holdoff						= 0;
+//Supply is below the VLM level
+bool g_f_brownout							= false;
+//Brownouts since boot
+int16_t g_brownout_cnt						= 0;
+//Control ticks left before the last motion command expires. Written by main, decremented by the control system
+volatile uint16_t g_motion_window			= 0;
 
 /****************************************************************************
 **	FUNCTION
@@ -59,7 +69,11 @@ bool init_ctrl_system( void )
 	//----------------------------------------------------------------
 
 	//Initialize 
-	g_vnh7040_pwm_ctrl = Orangebot::Ctrl_pwm( MAX_VNH7040_PWM, MAX_VNH7040_PWM_SLOPE );
+	g_vnh7040_pwm_ctrl = Orangebot::Ctrl_pwm( g_config.pwm_max, g_config.pwm_accel, g_config.pwm_decel );
+	//Only process the channels driven by the platform
+	g_vnh7040_pwm_ctrl.set_active( LAYOUT_VNH7040_ACTIVE );
+	//Current limiter starts unlimited
+	current_limit_reset();
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -68,6 +82,50 @@ bool init_ctrl_system( void )
 	return false; //OK
 }	//End function: init_ctrl_system | void
 
+/***************************************************************************/
+//!	@brief function
+//!	stall_stop | uint8_t
+/***************************************************************************/
+//! @param index | uint8_t | VNH7040 channel that stalled
+//! @return void
+//! @details
+//!	Control system only. Stop in this tick. Don't wait for the mode switch of the next tick
+//!	Stops every channel, including the ones already updated in this tick
+/***************************************************************************/
+
+static void stall_stop( uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	g_control_mode = CONTROL_STOP;
+	g_control_mode_target = CONTROL_STOP;
+	g_f_ctrl_mode_pending = true;
+	g_safe_holdoff = STALL_HOLDOFF_TICKS;
+	g_vnh7040_pwm_ctrl.reset();
+	report_error_deferred( ERR_MOTOR_STALL );
+	send_log( LOG_MOTOR_STALL, index, get_motor_current( index ) );
+	//For: every VNH7040 motor controller
+	for (t = 0;t < NUM_VNH7040;t++)
+	{
+		set_vnh7040_pwm( t, 0 );
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: stall_stop | uint8_t
+
 /***************************************************************************/
 //!	@brief function
 //!	control_system
@@ -75,6 +133,14 @@ bool init_ctrl_system( void )
 //! @return bool | true: failed to execute control system
 //! @brief select and execute correct control system
 //! @details
+//!	With CTRL_SYS_IN_ISR this function executes inside the TCA0 overflow ISR, level 1, once per control tick
+//!	It must never push into the TX buffer. Messages are deferred to the main loop
+//!	Keep it short. USART3 RX ISR is held off while it executes
+//!	The current limiter scales the PWM of each channel in the same tick
+//!	A stalled channel drops the platform to CONTROL_STOP in the same tick
+//!	A supply below the VLM level drops the platform to CONTROL_STOP in the same tick
+//!	An expired motion command drops the platform to CONTROL_STOP in the same tick
+//!	The effort of the PWM mode goes through the linearization table of the channel. The calibration ramp does not
 /***************************************************************************/
 
 bool control_system( void )
@@ -85,6 +151,10 @@ bool control_system( void )
 
 	//Counter
 	uint8_t t;
+	//PWM after the current limiter
+	int16_t pwm;
+	//PWM of the calibration ramp
+	int16_t pwm_ramp;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -97,14 +167,52 @@ bool control_system( void )
 		//----------------------------------------------------------------
 		//	CONTROL MODE
 		//----------------------------------------------------------------
-		
+	
+	//If: supply below the VLM level
+	if (IS_BIT_ONE( BOD.STATUS, BOD_VLMS_bp ))
+	{
+		//If: supply just dropped
+		if (g_f_brownout == false)
+		{
+			g_f_brownout = true;
+			g_brownout_cnt++;
+			report_error_deferred( ERR_BROWNOUT );
+			send_log( LOG_BROWNOUT, g_brownout_cnt, 0 );
+		}
+		//Hold the platform until the supply stays good for a while
+		g_safe_holdoff = BROWNOUT_HOLDOFF_TICKS;
+	}
+	//If: supply good
+	else
+	{
+		g_f_brownout = false;
+	}
+	//If: the last motion command is still valid
+	if (g_motion_window > 0)
+	{
+		g_motion_window--;
+	}
+	//If: the last motion command expired and the platform is still asked to move. The calibration ends by itself
+	else if ((g_control_mode_target != CONTROL_STOP) && (g_control_mode_target != CONTROL_CALIB))
+	{
+		g_control_mode_target = CONTROL_STOP;
+		report_error_deferred( ERR_MOTION_EXPIRED );
+		send_log( LOG_MOTION_EXPIRED, (int16_t)g_config.motion_timeout_ms, 0 );
+	}
+	//If: platform stopped by a stall or a brownout not long ago
+	if (g_safe_holdoff > 0)
+	{
+		g_safe_holdoff--;
+		//Refuse to move whatever the master asks
+		g_control_mode_target = CONTROL_STOP;
+	}
 	//If: switch of control mode
 	if (g_control_mode != g_control_mode_target)
 	{
 		//Control mode is the one desired by the user
 		g_control_mode = g_control_mode_target;
-		//Signal switch to main
-		send_msg_ctrl_mode();
+		//Signal switch to main. Main loop will send the message
+		g_f_ctrl_mode_pending = true;
 	}
 	//otherwise control mode is already correct
 	else
@@ -128,6 +236,8 @@ bool control_system( void )
 	{
 		//Forcefully reset the PWM controller
 		g_vnh7040_pwm_ctrl.reset();
+		//Forget the current limiter and stall history
+		current_limit_reset();
 		//For: every VNH7040 motor controller
 		for (t = 0;t < NUM_VNH7040;t++)
 		{
@@ -143,10 +253,52 @@ bool control_system( void )
 		//For: every VNH7040 motor controller
 		for (t = 0;t < NUM_VNH7040;t++)
 		{
-			//Apply computed PWM settings to the motors
-			set_vnh7040_pwm( t, g_vnh7040_pwm_ctrl.pwm(t) );
+			//Inner current loop scales the computed PWM
+			pwm = current_limit( t, g_vnh7040_pwm_ctrl.pwm(t) );
+			//If: the channel is stalled
+			if (stall_detect( t, pwm ) == true)
+			{
+				stall_stop( t );
+				break;
+			}
+			//Apply computed PWM settings to the motors. The table removes the dead zone and flattens the speed curve
+			set_vnh7040_pwm( t, linearize_vnh7040_pwm( t, pwm ) );
 		} //End for: every VNH7040 motor controller
 	}	//End If: control system is open loop PWM
+	//If: calibration of the linearization tables
+	else if (g_control_mode == CONTROL_CALIB)
+	{
+		//Measure the last tick and get the PWM of the ramp
+		pwm_ramp = calib_update();
+		//If: ramp completed. Main builds the tables
+		if (pwm_ramp < 0)
+		{
+			g_control_mode_target = CONTROL_STOP;
+			pwm_ramp = 0;
+		}
+		//For: every VNH7040 motor controller
+		for (t = 0;t < NUM_VNH7040;t++)
+		{
+			//If: motor of the calibration
+			if (IS_BIT_ONE( g_calib_mask, t ))
+			{
+				//The ramp is raw PWM. Current limiter and stall detector still protect the motor
+				pwm = current_limit( t, pwm_ramp );
+				//If: the channel is stalled. The calibration is aborted
+				if (stall_detect( t, pwm ) == true)
+				{
+					stall_stop( t );
+					break;
+				}
+				set_vnh7040_pwm( t, pwm );
+			}
+			//If: motor not calibrated
+			else
+			{
+				set_vnh7040_pwm( t, 0 );
+			}
+		} //End for: every VNH7040 motor controller
+	}	//End If: calibration of the linearization tables
 	//If: control system is closed loop speed
 	else if (g_control_mode == CONTROL_SPD)
 	{
@@ -157,7 +309,7 @@ bool control_system( void )
 	else
 	{
 		//Signal error
-		report_error( ERR_CODE_UNDEFINED_CONTROL_SYSTEM );
+		report_error_deferred( ERR_CODE_UNDEFINED_CONTROL_SYSTEM );
 		//Reset control mode
 		g_control_mode_target = CONTROL_STOP;
 	}	//End if: undefined control system
@@ -169,6 +321,194 @@ bool control_system( void )
 	return false; //OK
 }	//End function: control_system | void
 
+/***************************************************************************/
+//!	@brief function
+//!	set_ctrl_tick | uint16_t
+/***************************************************************************/
+//! @param period_us | uint16_t | period of the control system in microseconds
+//! @return bool | false = OK | true = period is outside the allowed range
+//! @brief Change the period of the control system tick
+//! @details
+//!	Write the buffered period register of TCA0. The new period is applied
+//!	on the next overflow, the running period is never cut short
+//!	Encoder speed is counts per control period and scales with it
+//!	An open motion window is rescaled, it keeps the time it had left
+/***************************************************************************/
+
+bool set_ctrl_tick( uint16_t period_us )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Motion window in ticks of the new period
+	uint32_t window_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: period outside allowed range
+	if ((period_us < MIN_CTRL_TICK_US) || (period_us > MAX_CTRL_TICK_US))
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//16b register write uses the shared TEMP register of TCA0. Do it atomically
+	sreg_tmp = SREG;
+	cli();
+	//Buffered period. Applied at the next update condition
+	TCA0.SINGLE.PERBUF = (uint16_t)(period_us *CTRL_TICK_CLK_MHZ -1);
+	//Same time left in the motion window, counted in ticks of the new period
+	window_tmp = ((uint32_t)g_motion_window *g_ctrl_tick_us) /period_us;
+	if (window_tmp > UINT16_MAX)
+	{
+		window_tmp = UINT16_MAX;
+	}
+	//If: window still open. Never close it early
+	else if ((window_tmp == 0) && (g_motion_window > 0))
+	{
+		window_tmp = 1;
+	}
+	g_motion_window = (uint16_t)window_tmp;
+	//Save the new period
+	g_ctrl_tick_us = period_us;
+	//Restore interrupt state
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false; //OK
+}	//End function: set_ctrl_tick | uint16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	motion_refresh | void
+/***************************************************************************/
+//! @return void
+//! @brief A motion command was received. Restart its validity window
+//! @details
+//!	Call it before setting the target mode, or the control system may expire the new command
+//!	The window is counted in control ticks of the current period. set_ctrl_tick rescales an open window
+//!	Telemetry requests don't call it. The platform stops within CFG_MOTION_TIMEOUT of the last motion command
+/***************************************************************************/
+
+void motion_refresh( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Window in control ticks
+	uint32_t window_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Convert the validity into control ticks
+	window_tmp = ((uint32_t)g_config.motion_timeout_ms *1000) /g_ctrl_tick_us;
+	//If: too long for the counter
+	if (window_tmp > UINT16_MAX)
+	{
+		window_tmp = UINT16_MAX;
+	}
+	//If: shorter than a tick
+	else if (window_tmp == 0)
+	{
+		window_tmp = 1;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//The control system decrements the window from inside an ISR. Write it atomically
+	sreg_tmp = SREG;
+	cli();
+	g_motion_window = (uint16_t)window_tmp;
+	//Restore interrupt state
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: motion_refresh | void
+
+/***************************************************************************/
+//!	@brief function
+//!	linearize_vnh7040_pwm | uint8_t | int16_t
+/***************************************************************************/
+//! @param index | uint8_t | index of the motor. 0 to 3
+//! @param effort | int16_t | effort of the control system. -VNH7040_PWM_LIMIT to +VNH7040_PWM_LIMIT
+//! @return int16_t | PWM for set_vnh7040_pwm. Same sign as the effort
+//! @details
+//!	Interpolates the linearization table of the motor. Zero effort is zero PWM
+//!	Any other effort is at least the static friction offset of the first point
+//!	Both directions use the same table
+/***************************************************************************/
+
+int16_t linearize_vnh7040_pwm( uint8_t index, int16_t effort )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Magnitude of the effort
+	int16_t magnitude;
+	//Segment of the table and position inside it
+	uint8_t segment;
+	int16_t offset;
+	//Table of the motor
+	const uint8_t *lut;
+	//PWM
+	int16_t pwm;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad index or no effort
+	if ((index >= NUM_VNH7040) || (effort == 0))
+	{
+		return 0;
+	}
+	magnitude = (effort < 0) ? (-effort) : (effort);
+	//If: above full effort
+	if (magnitude > VNH7040_PWM_LIMIT)
+	{
+		magnitude = VNH7040_PWM_LIMIT;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	lut = g_config.lin_lut[index];
+	segment = magnitude /LIN_EFFORT_STEP;
+	offset = magnitude %LIN_EFFORT_STEP;
+	//Interpolate between the two points of the segment
+	pwm = lut[segment] +((lut[segment +1] -lut[segment]) *offset) /LIN_EFFORT_STEP;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return (effort < 0) ? (-pwm) : (pwm);
+}	//End function: linearize_vnh7040_pwm | uint8_t | int16_t
+
 /****************************************************************************
 //!	@brief function
 **  set_vnh7040_pwm
@@ -213,18 +553,12 @@ bool set_vnh7040_pwm( uint8_t index, int16_t pwm )
 		f_dir = uint8_t(0x00);
 	}
 	
-		///STEP2: Apply VNH7040 Hardware PWM limits
-	//If: PWM setting is too low
-	if (pwm <= MIN_VNH7040_PWM)
-	{
-		//Set PWM to zero. It would not result to motion anyway
-		pwm = 0;
-	}
+		///STEP2: Apply VNH7040 PWM limit. CFG_PWM_MAX. Low PWM is handled by the linearization table
 	//If: PWM exceed maximum
-	else if (pwm >= MAX_VNH7040_PWM)
+	if (pwm >= g_config.pwm_max)
 	{
 		//Clip PWM to maximum
-		pwm = MAX_VNH7040_PWM;
+		pwm = g_config.pwm_max;
 	}
 	//If: PWM is correct
 	else
@@ -241,7 +575,7 @@ bool set_vnh7040_pwm( uint8_t index, int16_t pwm )
 	// 0	1	1 backward
 	// 1	0	1 backward
 	// 1	1	0 forward
-	f_dir = ( ( (f_dir ^ LAYOUT_VNH7040_REVERSE) & MASK(index) ) != 0 );
+	f_dir = ( ( (f_dir ^ g_config.layout_reverse) & MASK(index) ) != 0 );
 	
 	//----------------------------------------------------------------
 	//	BODY
@@ -323,18 +657,30 @@ bool set_platform_pwm( int16_t right, int16_t left )
 	//----------------------------------------------------------------
 	
 	//int16_t data[2];
+	//Counter
+	uint8_t t;
+	//Save interrupt state
+	uint8_t sreg_tmp = SREG;
 	
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
+	//Control system may execute inside an ISR. Targets are 16b and have to be written atomically
+	cli();
+
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
-	//The PWM references are set as target for the PWM slope controller
-	g_vnh7040_pwm_ctrl.target( 0 ) = right;
-	g_vnh7040_pwm_ctrl.target( 1 ) = left;
+	//For: each VNH7040 channel
+	for (t = 0;t < NUM_VNH7040;t++)
+	{
+		//The PWM references are set as target for the PWM slope controller according to the side of the motor
+		g_vnh7040_pwm_ctrl.target( t ) = ((LAYOUT_VNH7040_RIGHT & MASK(t)) != 0)?(right):(left);
+	}
+	//Restore interrupt state
+	SREG = sreg_tmp;
 	//Debug: send actual PWM back as response to PWM message
 	//data[0] = g_vnh7040_pwm_ctrl.pwm( 0 );
 	//data[1] = g_vnh7040_pwm_ctrl.pwm( 1 );
@@ -347,3 +693,97 @@ bool set_platform_pwm( int16_t right, int16_t left )
 	
 	return false; //OK
 }	//End function:
+
+/***************************************************************************/
+//!	@brief function
+//!	set_vnh7040_pwm_param | uint8_t | uint16_t | uint16_t | uint16_t
+/***************************************************************************/
+//! @param index | uint8_t | index of the VNH7040 channel
+//! @param max | uint16_t | PWM limit of the channel
+//! @param accel | uint16_t | maximum PWM change per tick moving away from zero
+//! @param decel | uint16_t | maximum PWM change per tick moving toward zero
+//! @return bool | false = OK | true = bad index or parameters
+//! @brief Set limit and slopes of the slew rate limiter of a VNH7040 channel
+//! @details
+//!	Slopes of zero would freeze the channel and are refused
+//!	Limit above the VNH7040 maximum would be clipped by the HAL anyway and is refused
+/***************************************************************************/
+
+bool set_vnh7040_pwm_param( uint8_t index, uint16_t max, uint16_t accel, uint16_t decel )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Return flag
+	bool f_ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad parameters
+	if ((index >= NUM_VNH7040) || (max > (uint16_t)g_config.pwm_max) || (accel == 0) || (decel == 0))
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Control system may execute inside an ISR. Parameters are 16b and have to be written atomically
+	sreg_tmp = SREG;
+	cli();
+	f_ret = g_vnh7040_pwm_ctrl.set_max( index, max );
+	f_ret |= g_vnh7040_pwm_ctrl.set_slope( index, accel, decel );
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return f_ret;
+}	//End function: set_vnh7040_pwm_param | uint8_t | uint16_t | uint16_t | uint16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	get_vnh7040_pwm_param | uint8_t | uint16_t & | uint16_t & | uint16_t &
+/***************************************************************************/
+//! @param index | uint8_t | index of the VNH7040 channel
+//! @param max | uint16_t & | returns the PWM limit of the channel
+//! @param accel | uint16_t & | returns the acceleration slope of the channel
+//! @param decel | uint16_t & | returns the deceleration slope of the channel
+//! @return bool | false = OK | true = bad index
+//! @brief Get limit and slopes of the slew rate limiter of a VNH7040 channel
+/***************************************************************************/
+
+bool get_vnh7040_pwm_param( uint8_t index, uint16_t &max, uint16_t &accel, uint16_t &decel )
+{
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad index
+	if (index >= NUM_VNH7040)
+	{
+		return true;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Parameters are only written by the main loop. No need to block interrupts
+	max = g_vnh7040_pwm_ctrl.get_max( index );
+	accel = g_vnh7040_pwm_ctrl.get_accel( index );
+	decel = g_vnh7040_pwm_ctrl.get_decel( index );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: get_vnh7040_pwm_param | uint8_t | uint16_t & | uint16_t & | uint16_t &
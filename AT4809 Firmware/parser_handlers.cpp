@@ -5,6 +5,10 @@
 
 //type definition using the bit width and signedness
 #include <stdint.h>
+//define the ISR routune, ISR vector, and the sei() cli() function
+#include <avr/interrupt.h>
+//name all the register and bit
+#include <avr/io.h>
 
 //General purpose macros
 #include "at_utils.h"
@@ -26,7 +30,7 @@
 
 //Board Signature
 uint8_t *g_board_sign = (uint8_t *)"OrangeBot-2020-01-19";
-//communication timeout counter
+//Link timeout counter. Housekeeping ticks since the last valid command
 uint8_t g_uart_timeout_cnt = 0;
 //Communication timeout has been detected
 bool g_f_timeout_detected = false;
@@ -61,6 +65,8 @@ bool init_parser_commands( Orangebot::Uniparser &parser_tmp )
 	//! Register commands and handler for the universal parser class. A masterpiece :')
 	//Register ping command. It's used to reset the communication timeout
 	f_ret = parser_tmp.add_cmd( "P", (void *)&ping_handler );
+	//Register clock synchronization ping. Also resets the communication timeout
+	f_ret |= parser_tmp.add_cmd( "PING%D", (void *)&ping_sync_handler );
 	//Register the Find command. Board answers with board signature
 	f_ret |= parser_tmp.add_cmd( "F", (void *)&send_signature_handler );
 	//Direct platform PWM command
@@ -69,6 +75,24 @@ bool init_parser_commands( Orangebot::Uniparser &parser_tmp )
 	f_ret |= parser_tmp.add_cmd( "ENC_ABS%u", (void *)&send_enc_pos_handler );
 	//Master asks for encoder speed
 	f_ret |= parser_tmp.add_cmd( "ENC_SPD", (void *)&send_enc_spd_handler );
+	//Master sets the period of the control system in microseconds
+	f_ret |= parser_tmp.add_cmd( "TICK%U", (void *)&set_ctrl_tick_handler );
+	//Master sets limit, acceleration and deceleration slope of one PWM channel
+	f_ret |= parser_tmp.add_cmd( "PWM_PARAM%u:%S:%S:%S", (void *)&set_pwm_param_handler );
+	//Master asks for the motor currents
+	f_ret |= parser_tmp.add_cmd( "CUR", (void *)&send_current_handler );
+	//Master sets current limit, stall current and stall duration
+	f_ret |= parser_tmp.add_cmd( "CUR_LIMIT%U:%U:%U", (void *)&set_current_limit_handler );
+	//Master asks for the fault codes of the motor drivers
+	f_ret |= parser_tmp.add_cmd( "DIAG", (void *)&send_diag_handler );
+	//Master asks for a configuration parameter
+	f_ret |= parser_tmp.add_cmd( "CFG_GET%u", (void *)&send_config_handler );
+	//Master changes a configuration parameter
+	f_ret |= parser_tmp.add_cmd( "CFG_SET%u:%S", (void *)&set_config_handler );
+	//Master saves the configuration in EEPROM
+	f_ret |= parser_tmp.add_cmd( "CFG_SAVE", (void *)&save_config_handler );
+	//Master starts the calibration of the linearization tables. Last slot of UNIPARSER_MAX_CMD
+	f_ret |= parser_tmp.add_cmd( "CALIB%u", (void *)&calib_handler );
 	
 	//If: Uniparser V4 failed to register a command
 	if (f_ret == true)
@@ -91,6 +115,7 @@ bool init_parser_commands( Orangebot::Uniparser &parser_tmp )
 //! @return void
 //!	@details
 //! Handler for the ping command. Keep alive connection
+//!	Nothing to do. The main loop clears the link timeout on every completed command
 /***************************************************************************/
 
 void ping_handler( void )
@@ -103,9 +128,6 @@ void ping_handler( void )
 	//	INIT
 	//----------------------------------------------------------------
 	
-	//Reset communication timeout handler
-	g_uart_timeout_cnt = 0;
-	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
@@ -117,6 +139,73 @@ void ping_handler( void )
 	return; //OK
 }	//end handler: ping_handler | void
 
+/***************************************************************************/
+//!	@brief clock synchronization ping handler
+//!	ping_sync_handler | uint32_t
+/***************************************************************************/
+//! @param token | uint32_t | RPI token of the ping, echoed back
+//! @return void
+//!	@details
+//! Answer PONG<token>:<timestamp> with the RTC timestamp when the ping was decoded
+//!	The RPI measures the round trip and maps the RTC timestamps to its own clock
+/***************************************************************************/
+
+void ping_sync_handler( uint32_t token )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint32_t
+	uint8_t str[MAX_STRING32];
+	//When the ping was decoded
+	uint32_t timestamp_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+	
+	//Sample the clock first. Everything after counts as reply delay
+	timestamp_tmp = get_timestamp();
+	
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	AT_BUF_PUSH( rpi_tx_buf, 'P' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'N' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	//Construct token string
+	ret = u32_to_str( token, str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send argument separator
+	AT_BUF_PUSH( rpi_tx_buf, ':' );
+	//Construct timestamp string
+	ret = u32_to_str( timestamp_tmp, str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: ping_sync_handler | uint32_t
+
 /***************************************************************************/
 //!	@brief board signature handler
 //!	signature_handler | void
@@ -141,8 +230,6 @@ void send_signature_handler( void )
 	//	INIT
 	//----------------------------------------------------------------
 
-	//Reset communication timeout handler
-	g_uart_timeout_cnt = 0;
 	//Length of the board signature string
 	uint8_t board_sign_length = str_len( g_board_sign, MAX_SIGNATURE_LENGTH );
 	//If: string is invalid
@@ -206,8 +293,8 @@ void set_platform_pwm_handler( int16_t right, int16_t left )
 	//	INIT
 	//----------------------------------------------------------------
 
-	//Reset communication timeout handler
-	g_uart_timeout_cnt = 0;
+	//Motion command. Refresh its validity before the control system sees the new mode
+	motion_refresh();
 
 	//----------------------------------------------------------------
 	//	BODY
@@ -245,6 +332,12 @@ void send_enc_pos_handler( uint8_t index )
 	uint8_t t;
 	//return
 	uint8_t ret;
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Local copy of the encoder position
+	int32_t enc_pos_tmp;
+	//When the position was copied
+	uint32_t timestamp_tmp;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -256,8 +349,12 @@ void send_enc_pos_handler( uint8_t index )
 		report_error(Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT);
 		return;	//FAIL
 	}
-	//Reset communication timeout handler
-	g_uart_timeout_cnt = 0;
+	//Control system may be writing the position from inside an ISR. Copy it atomically
+	sreg_tmp = SREG;
+	cli();
+	enc_pos_tmp = g_enc_pos[ index ];
+	timestamp_tmp = get_timestamp();
+	SREG = sreg_tmp;
 	
 	//----------------------------------------------------------------
 	//	BODY
@@ -265,6 +362,8 @@ void send_enc_pos_handler( uint8_t index )
 
 	//Temp string sized for an int32_t
 	uint8_t str[MAX_STRING32];
+	//Stamp the message
+	send_timestamp( timestamp_tmp );
 	//Construct index string
 	ret = u8_to_str( index, str );
 	//Send a encoder absolute position message
@@ -284,7 +383,7 @@ void send_enc_pos_handler( uint8_t index )
 	//Send argument separator
 	AT_BUF_PUSH( rpi_tx_buf, ':' );
 	//Construct encoder position string
-	ret = s32_to_str( g_enc_pos[ index ], str );
+	ret = s32_to_str( enc_pos_tmp, str );
 	//For each string character
 	for (t = 0;t < ret;t++)
 	{
@@ -323,18 +422,34 @@ void send_enc_spd_handler( void )
 	uint8_t ret;
 	//Temp string sized for an int16_t
 	uint8_t str[MAX_STRING16];
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Local copy of the encoder speed
+	int16_t enc_spd_tmp[NUM_ENC];
+	//When the speed was copied
+	uint32_t timestamp_tmp;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
-	//Reset communication timeout handler
-	g_uart_timeout_cnt = 0;
+	//Control system may be writing the speed from inside an ISR. Copy it atomically
+	sreg_tmp = SREG;
+	cli();
+	//For: each encoder channel
+	for (t = 0;t < NUM_ENC;t++)
+	{
+		enc_spd_tmp[t] = g_enc_spd[t];
+	}
+	timestamp_tmp = get_timestamp();
+	SREG = sreg_tmp;
 	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
+	//Stamp the message
+	send_timestamp( timestamp_tmp );
 	//Send a encoder absolute position message
 	AT_BUF_PUSH( rpi_tx_buf, 'E' );
 	AT_BUF_PUSH( rpi_tx_buf, 'N' );
@@ -343,17 +458,20 @@ void send_enc_spd_handler( void )
 	AT_BUF_PUSH( rpi_tx_buf, 'S' );
 	AT_BUF_PUSH( rpi_tx_buf, 'P' );
 	AT_BUF_PUSH( rpi_tx_buf, 'D' );
+	//Two encoder platform uses the dual message. Four encoder platform uses ENC_SPD
+	#if (NUM_ENC == 2)
 	AT_BUF_PUSH( rpi_tx_buf, '_' );
 	AT_BUF_PUSH( rpi_tx_buf, 'D' );
 	AT_BUF_PUSH( rpi_tx_buf, 'U' );
 	AT_BUF_PUSH( rpi_tx_buf, 'A' );
 	AT_BUF_PUSH( rpi_tx_buf, 'L' );
+	#endif
 	
 	//For: each encoder channel
 	for (t = 0;t < NUM_ENC;t++)
 	{
 		//Construct encoder position string
-		ret = s16_to_str( g_enc_spd[ t ], str );
+		ret = s16_to_str( enc_spd_tmp[ t ], str );
 		//For each string character
 		for (ti = 0;ti < ret;ti++)
 		{
@@ -376,4 +494,640 @@ void send_enc_spd_handler( void )
 	//----------------------------------------------------------------
 
 	return; //OK
-}	//end handler: signature_handler | void
\ No newline at end of file
+}	//end handler: signature_handler | void
+
+/***************************************************************************/
+//!	@brief control system tick handler
+//!	set_ctrl_tick_handler | uint16_t
+/***************************************************************************/
+//! @param period_us | uint16_t | period of the control system in microseconds
+//! @return void
+//!	@details
+//! Handle request to change the period of the control system
+//!	Answer with the period in use so the master knows the unit of the encoder speed
+/***************************************************************************/
+
+void set_ctrl_tick_handler( uint16_t period_us )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint16_t
+	uint8_t str[MAX_STRING16];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: period outside allowed range
+	if (set_ctrl_tick( period_us ) == true)
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		send_log( LOG_CTRL_TICK_REFUSED, (int16_t)period_us, 0 );
+		return;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Construct period string
+	ret = u16_to_str( g_ctrl_tick_us, str );
+	//Send the period in use
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'K' );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: set_ctrl_tick_handler | uint16_t
+
+/***************************************************************************/
+//!	@brief PWM slew rate limiter parameters handler
+//!	set_pwm_param_handler | uint8_t | int16_t | int16_t | int16_t
+/***************************************************************************/
+//! @param index | uint8_t | index of the PWM channel
+//! @param max | int16_t | PWM limit of the channel
+//! @param accel | int16_t | maximum PWM change per control tick moving away from zero
+//! @param decel | int16_t | maximum PWM change per control tick moving toward zero
+//! @return void
+//!	@details
+//! Handle request to change limit and slopes of one PWM channel
+//!	Answer with the parameters in use: PWM_PARAM%u:%S:%S:%S
+/***************************************************************************/
+
+void set_pwm_param_handler( uint8_t index, int16_t max, int16_t accel, int16_t decel )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t, ti;
+	//return
+	uint8_t ret;
+	//Temp string sized for an int16_t
+	uint8_t str[MAX_STRING16];
+	//Parameters in use
+	uint16_t param[3];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: negative parameters or parameters refused by the HAL
+	if ((max < 0) || (accel < 0) || (decel < 0) || (set_vnh7040_pwm_param( index, max, accel, decel ) == true))
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		send_log( LOG_PWM_PARAM_REFUSED, index, 0 );
+		return;	//FAIL
+	}
+	//Read back the parameters in use
+	get_vnh7040_pwm_param( index, param[0], param[1], param[2] );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	AT_BUF_PUSH( rpi_tx_buf, 'P' );
+	AT_BUF_PUSH( rpi_tx_buf, 'W' );
+	AT_BUF_PUSH( rpi_tx_buf, 'M' );
+	AT_BUF_PUSH( rpi_tx_buf, '_' );
+	AT_BUF_PUSH( rpi_tx_buf, 'P' );
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	AT_BUF_PUSH( rpi_tx_buf, 'R' );
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	AT_BUF_PUSH( rpi_tx_buf, 'M' );
+	//Construct index string
+	ret = u8_to_str( index, str );
+	//For each string character
+	for (ti = 0;ti < ret;ti++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[ti] );
+	}
+	//For: each parameter
+	for (t = 0;t < 3;t++)
+	{
+		//Send argument separator
+		AT_BUF_PUSH( rpi_tx_buf, ':' );
+		//Construct parameter string
+		ret = s16_to_str( param[t], str );
+		//For each string character
+		for (ti = 0;ti < ret;ti++)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, str[ti] );
+		}
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: set_pwm_param_handler | uint8_t | int16_t | int16_t | int16_t
+
+/***************************************************************************/
+//!	@brief motor current handler
+//!	send_current_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Handle request for the filtered current of the VNH7040
+//!	Answer CUR<cur0>:<cur1>:<cur2>:<cur3> in CURRENT_UA_PER_CNT counts
+//!	Message always has four arguments. Drivers not installed read 0
+/***************************************************************************/
+
+void send_current_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t, ti;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint16_t
+	uint8_t str[MAX_STRING16];
+	//Save interrupt state
+	uint8_t sreg_tmp;
+	//Local copy of the currents
+	uint16_t current_tmp[4];
+	//When the currents were copied
+	uint32_t timestamp_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//ADC ISR is writing the currents. Copy them atomically
+	sreg_tmp = SREG;
+	cli();
+	//For: each argument of the message
+	for (t = 0;t < 4;t++)
+	{
+		current_tmp[t] = (t < NUM_VNH7040) ? (g_motor_current[t]) : (0);
+	}
+	timestamp_tmp = get_timestamp();
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Stamp the message
+	send_timestamp( timestamp_tmp );
+	//Send a motor current message
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	AT_BUF_PUSH( rpi_tx_buf, 'R' );
+	//For: each argument of the message
+	for (t = 0;t < 4;t++)
+	{
+		//If not first argument
+		if (t > 0)
+		{
+			//Send argument separator
+			AT_BUF_PUSH( rpi_tx_buf, ':' );
+		}
+		//Construct current string
+		ret = u16_to_str( current_tmp[t], str );
+		//For each string character
+		for (ti = 0;ti < ret;ti++)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, str[ti] );
+		}
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: send_current_handler | void
+
+/***************************************************************************/
+//!	@brief current limit handler
+//!	set_current_limit_handler | uint16_t | uint16_t | uint16_t
+/***************************************************************************/
+//! @param limit_ma | uint16_t | current limit [mA]
+//! @param stall_ma | uint16_t | stall current [mA]
+//! @param stall_ticks | uint16_t | control ticks a channel must stay stalled
+//! @return void
+//!	@details
+//! Handle request to change current limit and stall detection
+//!	Answer with the same message holding the parameters in use
+/***************************************************************************/
+
+void set_current_limit_handler( uint16_t limit_ma, uint16_t stall_ma, uint16_t stall_ticks )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t, ti;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint16_t
+	uint8_t str[MAX_STRING16];
+	//Parameters in use
+	uint16_t param[3];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: parameters refused
+	if (set_current_limit( limit_ma, stall_ma, stall_ticks ) == true)
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		send_log( LOG_CUR_LIMIT_REFUSED, limit_ma, stall_ma );
+		return;	//FAIL
+	}
+	//Read back the parameters in use. Rounded to the ADC resolution
+	get_current_limit( param[0], param[1], param[2] );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	AT_BUF_PUSH( rpi_tx_buf, 'R' );
+	AT_BUF_PUSH( rpi_tx_buf, '_' );
+	AT_BUF_PUSH( rpi_tx_buf, 'L' );
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	AT_BUF_PUSH( rpi_tx_buf, 'M' );
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	//For: each parameter
+	for (t = 0;t < 3;t++)
+	{
+		//If not first argument
+		if (t > 0)
+		{
+			//Send argument separator
+			AT_BUF_PUSH( rpi_tx_buf, ':' );
+		}
+		//Construct parameter string
+		ret = u16_to_str( param[t], str );
+		//For each string character
+		for (ti = 0;ti < ret;ti++)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, str[ti] );
+		}
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: set_current_limit_handler | uint16_t | uint16_t | uint16_t
+
+/***************************************************************************/
+//!	@brief diagnostic handler
+//!	send_diag_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Handle request for the fault codes of the VNH7040. Main sends it too when the codes change
+//!	Answer DIAG<code0>:<code1>:<code2>:<code3>. DIAG_* bit fields in orangebot_config.h
+//!	Message always has four arguments. Drivers not installed read DIAG_OK
+/***************************************************************************/
+
+void send_diag_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t, ti;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint8_t
+	uint8_t str[MAX_STRING16];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//No heartbeat. Main calls it on its own, a request alone must not keep the link alive
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Codes are only written by main. No need to block interrupts
+	AT_BUF_PUSH( rpi_tx_buf, 'D' );
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	//For: each argument of the message
+	for (t = 0;t < 4;t++)
+	{
+		//If not first argument
+		if (t > 0)
+		{
+			//Send argument separator
+			AT_BUF_PUSH( rpi_tx_buf, ':' );
+		}
+		//Construct fault code string
+		ret = u8_to_str( get_diag_code( t ), str );
+		//For each string character
+		for (ti = 0;ti < ret;ti++)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, str[ti] );
+		}
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: send_diag_handler | void
+
+/***************************************************************************/
+//!	@brief configuration handler
+//!	send_config_handler | uint8_t
+/***************************************************************************/
+//! @param id | uint8_t | CFG_* id of orangebot_config.h
+//! @return void
+//!	@details
+//! Handle request for a configuration parameter
+//!	Answer CFG<id>:<value> with the value in use
+/***************************************************************************/
+
+void send_config_handler( uint8_t id )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return
+	uint8_t ret;
+	//Temp string sized for an int16_t
+	uint8_t str[MAX_STRING16];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad parameter
+	if (id >= CFG_NUM_ID)
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		return;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'F' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	//Construct id string
+	ret = u8_to_str( id, str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send argument separator
+	AT_BUF_PUSH( rpi_tx_buf, ':' );
+	//Construct value string
+	ret = s16_to_str( config_get( id ), str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: send_config_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief configuration handler
+//!	set_config_handler | uint8_t | int16_t
+/***************************************************************************/
+//! @param id | uint8_t | CFG_* id of orangebot_config.h
+//! @param value | int16_t | new value
+//! @return void
+//!	@details
+//! Handle request to change a configuration parameter. Applied at once, kept in EEPROM by CFG_SAVE
+//!	Answer CFG<id>:<value> with the value in use
+/***************************************************************************/
+
+void set_config_handler( uint8_t id, int16_t value )
+{
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//If: bad id or value out of range
+	if (config_set( id, value ) == true)
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		send_log( LOG_CFG_REFUSED, id, value );
+		return;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Answer with the value in use
+	send_config_handler( id );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: set_config_handler | uint8_t | int16_t
+
+/***************************************************************************/
+//!	@brief configuration handler
+//!	save_config_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Handle request to save the configuration in EEPROM
+//!	No answer now. Main sends CFG_SAVE<crc> once the EEPROM is written
+/***************************************************************************/
+
+void save_config_handler( void )
+{
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: a save is already running
+	if (config_save() == true)
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		return;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: save_config_handler | void
+
+/***************************************************************************/
+//!	@brief configuration handler
+//!	send_config_save_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Called by main when a save of the configuration completes
+//!	Send CFG_SAVE<crc>. The RPI can compare the CRC with the one of the next boot
+/***************************************************************************/
+
+void send_config_save_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return
+	uint8_t ret;
+	//Temp string sized for an uint16_t
+	uint8_t str[MAX_STRING16];
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'F' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	AT_BUF_PUSH( rpi_tx_buf, '_' );
+	AT_BUF_PUSH( rpi_tx_buf, 'S' );
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	AT_BUF_PUSH( rpi_tx_buf, 'V' );
+	AT_BUF_PUSH( rpi_tx_buf, 'E' );
+	//Construct CRC string
+	ret = u16_to_str( get_config_crc(), str );
+	//For each string character
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, str[t] );
+	}
+	//Send terminator
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: send_config_save_handler | void
+
+/***************************************************************************/
+//!	@brief calibration handler
+//!	calib_handler | uint8_t
+/***************************************************************************/
+//! @param mask | uint8_t | motors to calibrate. Bit mask
+//! @return void
+//!	@details
+//! Handle request to calibrate the linearization tables. The robot must be on stands
+//!	The CTRL message tells the switch to CONTROL_CALIB. Each motor answers with a LOG_CALIB when the ramp completes
+/***************************************************************************/
+
+void calib_handler( uint8_t mask )
+{
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: bad mask or a calibration is running
+	if (calib_start( mask ) == true)
+	{
+		report_error( Error_code::ERR_BAD_PARSER_RUNTIME_ARGUMENT );
+		return;	//FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: calib_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief function
+//!	link_heartbeat | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Called by the main loop once per command completed by the parser. Clear the link timeout
+//!	Handlers do not call it. Only the link. Motion commands also call motion_refresh()
+//!	Main checks the link timeout in the housekeeping code
+/***************************************************************************/
+
+void link_heartbeat( void )
+{
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Reset communication timeout counter
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End function: link_heartbeat | void
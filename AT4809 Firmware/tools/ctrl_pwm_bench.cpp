@@ -0,0 +1,153 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	ctrl_pwm_bench
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Host benchmark of Ctrl_pwm::update with 2 and 4 active channels
+**	Targets jump every few ticks so the channels keep slewing
+**	Checks that the inactive channels are never touched
+**	Build:	g++ -std=c++11 -O3 -I.. -o ctrl_pwm_bench ctrl_pwm_bench.cpp ../ctrl_pwm.cpp
+**	Use:	./ctrl_pwm_bench [ticks]
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+//PWM slew controller
+#include "ctrl_pwm.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+using namespace Orangebot;
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Default number of ticks of each run
+#define BENCH_TICKS			10000000
+//Ticks between target changes
+#define BENCH_TARGET_TICKS	64
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+//Run the controller with a channel mask. Return ns per update. Negative = an inactive channel moved
+static double bench( uint8_t mask, long ticks )
+{
+	//Controller under test. Same limits as the firmware motors
+	Ctrl_pwm ctrl( 500, 8, 16 );
+	//Counters
+	long t;
+	uint8_t c;
+	//Pseudo random targets
+	uint32_t seed = 12345;
+	//Sum of the PWM. Keeps the updates alive
+	long sum = 0;
+
+	ctrl.set_active( mask );
+	//Inactive channels get a target that update must ignore
+	for (c = 0;c < NUM_CTRL_PWM;c++)
+	{
+		if (((mask >> c) & 0x01) == 0)
+		{
+			ctrl.target( c ) = 100;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (t = 0;t < ticks;t++)
+	{
+		//If: new targets
+		if ((t % BENCH_TARGET_TICKS) == 0)
+		{
+			for (c = 0;c < NUM_CTRL_PWM;c++)
+			{
+				if (((mask >> c) & 0x01) != 0)
+				{
+					seed = seed *1103515245 +12345;
+					ctrl.target( c ) = (int16_t)((int)((seed >> 16) % 1001) -500);
+				}
+			}
+		}
+		ctrl.update();
+		sum += ctrl.pwm( 0 );
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	//If: an inactive channel moved
+	for (c = 0;c < NUM_CTRL_PWM;c++)
+	{
+		if ((((mask >> c) & 0x01) == 0) && (ctrl.pwm( c ) != 0))
+		{
+			return -1.0;
+		}
+	}
+	printf( "checksum %ld\n", sum );
+
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>( stop -start ).count() /ticks;
+}
+
+int main( int argc, char *argv[] )
+{
+	//Number of ticks of each run
+	long ticks = (argc > 1) ? (atol( argv[1] )) : (BENCH_TICKS);
+	//Channel masks under test
+	const uint8_t masks[] = { 0x03, 0x0f };
+	//ns per update
+	double ns;
+
+	if (ticks <= 0)
+	{
+		fprintf( stderr, "ERR: bad number of ticks\n" );
+		return 1;
+	}
+	for (uint8_t mask : masks)
+	{
+		ns = bench( mask, ticks );
+		if (ns < 0.0)
+		{
+			fprintf( stderr, "ERR: mask 0x%02x | inactive channel moved\n", mask );
+			return 1;
+		}
+		printf( "mask 0x%02x | %ld ticks | %.2f ns/update\n", mask, ticks, ns );
+	}
+
+	return 0;
+}
@@ -203,6 +203,24 @@ Err_codes Uniparser::get_error( void )
 *****************************************************************************
 ****************************************************************************/
 
+/***************************************************************************/
+//!	@brief Public Tester
+//!	is_executed | void
+/***************************************************************************/
+//! @return bool | true = the last call to parse completed a command and executed its handler
+//!	@details
+//! Lets the caller act once per command without touching the handlers
+/***************************************************************************/
+
+bool Uniparser::is_executed( void )
+{
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return this -> g_f_executed;
+}	//end tester: is_executed | void
+
 /****************************************************************************
 *****************************************************************************
 **	PUBLIC METHODS
@@ -323,6 +341,9 @@ bool Uniparser::parse( uint8_t data )
 	//	INIT
 	//----------------------------------------------------------------
 
+	//No handler executed by this call yet
+	this -> g_f_executed = false;
+
 		//----------------------------------------------------------------
 		//	CLEAR ERROR
 		//----------------------------------------------------------------
@@ -862,6 +883,8 @@ bool Uniparser::parse( uint8_t data )
 		DPRINT("%d | Executing handler of command %d | num arguments: %d\n", __LINE__, exe_index, this -> g_arg_fsm_status.num_arg);
 		//Execute handler of given function. Automatically deduce arguments from argument vector
         this -> execute_callback( this ->g_cmd_handler[exe_index] );
+		//A command was completed
+		this -> g_f_executed = true;
         //Reset the argument decoder and prepare for a new command
 		this -> init_arg_decoder();
 	}	//If: a reset was issued
@@ -933,6 +956,8 @@ inline void Uniparser::init( void )
 	this -> g_status = Orangebot::Parser_status::PARSER_IDLE;
 	//No error
 	this -> g_err = Orangebot::Err_codes::NO_ERR;
+	//No handler executed
+	this -> g_f_executed = false;
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -272,6 +272,9 @@ class Uniparser
 		//	TESTERS
 		//--------------------------------------------------------------------------
 
+		//! true = the last call to parse completed a command and executed its handler
+		bool is_executed( void );
+
 		//--------------------------------------------------------------------------
 		//	PUBLIC METHODS
 		//--------------------------------------------------------------------------
@@ -366,6 +369,8 @@ class Uniparser
 		Parser_status g_status;
 		//Error status of the parser. NO_ERR means OK
 		Err_codes g_err;
+		//The last call to parse executed a handler
+		bool g_f_executed;
 
 };	//End Class: Uniparser
 
@@ -8,7 +8,16 @@
 			"src/panopticon.cpp",
 			"src/ob.cpp",
 			"src/uniparser.cpp",
-			"src/debug.cpp"
+			"src/debug.cpp",
+			"src/serial_thread.cpp",
+			"src/status_snapshot.cpp",
+			"src/odometry.cpp",
+			"src/telemetry_stats.cpp",
+			"src/clock_sync.cpp",
+			"src/firmware_log.cpp",
+			"src/session_log.cpp",
+			"src/session_replay.cpp",
+			"src/trace.cpp"
         ],
         'include_dirs': [
             "<!@(node -p \"require('node-addon-api').include\")"
@@ -17,6 +26,6 @@
         'dependencies': [
             "<!(node -p \"require('node-addon-api').gyp\")"
         ],
-        'defines': [ 'NAPI_DISABLE_CPP_EXCEPTIONS' ]
+        'defines': [ 'NAPI_DISABLE_CPP_EXCEPTIONS', 'NAPI_VERSION=4', 'ENABLE_TRACE' ]
     }]
 }
@@ -7,6 +7,7 @@
 //	Include native C++ module
 //		2020-01-18
 //	Added C++ library version 2020-01-18
+//	Configure per channel PWM limit and acceleration/deceleration slopes at startup
 //
 
 //-----------------------------------------------------------------------------------
@@ -25,11 +26,13 @@ const url = require("url");
 const io = require("socket.io")(http);
 //Websocket used to stream video
 const websocket = require("ws");
-//Communicate with the RPI hardware serial port on the GPIO
-const SerialPort = require("serialport");
+//Dispatch the robot status events of the C++ module to the connected browsers
+const EventEmitter = require("events");
 //Include native C++ module
 const orangebot_platform_cpp_module = require('./build/Release/OrangebotNodeCpp.node');
 console.log('My custom c++ module',orangebot_platform_cpp_module);
+//Index of each field inside the status Int32Array of the C++ module
+const status_layout = orangebot_platform_cpp_module.get_status_layout();
 
 //orangebot_platform_cpp_module.parse("PWM:+100:+100");
 //console.log("pwm0:", orangebot_platform_cpp_module.getPwm(0));
@@ -63,6 +66,8 @@ module.exports = orangebot_platform_cpp_module;
 //Port the server will listen to
 var server_port = 8080;
 var websocket_stream_port = 8082;
+//Binary telemetry to the browsers
+var websocket_telemetry_port = 8083;
 //Path of the http and css files for the http server
 var file_index_name = "index.html";
 var file_script_key_name = "orangebot_key.js";
@@ -73,10 +78,16 @@ var file_script_key;
 var file_jsplayer;
 //Name of the local video stream
 var stream_name = "mystream";
-//Time between emission of data to browser
-const time_send_robot_data_to_browser = 333
-//Time between emission of serial messages to the robot electronics
+//Maximum rate of robot status events from the C++ module to the browsers [Hz]
+const robot_event_rate = 50;
+//Raised with "status" each time a message from the robot changed its status
+const robot_events = new EventEmitter();
+//Time between emission of serial messages to the robot electronics. Below MOTION_TIMEOUT_MS of the firmware, or the robot stops between two PWM messages
 const time_send_serial_messages = 250
+//Period of the clock synchronization pings [ms]. Round trips map the firmware timestamps on the RPI clock
+const time_clock_sync = 100;
+//Period of the check for log messages of the motor board [ms]
+const time_firmware_log = 500;
 
 //-----------------------------------------------------------------------------------
 //	MOTOR VARS
@@ -91,6 +102,14 @@ var max_velocity = 150;
 var velocity = 100;
 //Ratio of forward to sideways during turn. 0 full turn, 1 full forward
 var steering_ratio = 0.7;
+//PWM limit and slopes are CFG_PWM_MAX/ACCEL/DECEL, loaded by the motor board from EEPROM. Tune them with send_message_config_set and keep them with send_message_config_save
+//Current limiter and stall detector use the defaults of the firmware. send_message_set_current_limit overrides them until the next reset
+//Period of the control system of the motor board [us]. Encoder speed, PWM slopes and stall ticks are per control tick and scale with it
+const ctrl_tick_us = 1000;
+//Number of motor channels driven by the platform PWM command. NUM_VNH7040 in orangebot_config.h
+const num_pwm = status_layout.num_pwm;
+//Number of configuration parameters of the motor board. CFG_NUM_ID in orangebot_config.h
+const num_config = orangebot_platform_cpp_module.get_status().config.length;
 //Current direction of the platform
 var direction = { forward : 0, right : 0 };
 
@@ -98,8 +117,8 @@ var direction = { forward : 0, right : 0 };
 //	ENCODER VARS
 //-----------------------------------------------------------------------------------
 
-//Number of encoder installed on the platform
-const num_enc = 2;
+//Number of encoder installed on the platform. NUM_ENC in orangebot_config.h
+const num_enc = status_layout.num_enc;
 //Ask one encoder at a time 
 var scan_encoder_index = 0
 
@@ -245,6 +264,8 @@ function http_handler(req, res)
 //-----------------------------------------------------------------------------------
 //	Handle websocket connection to the client
 
+//	Robot status is sent on the binary telemetry websocket
+
 io.on
 (
 	"connection",
@@ -254,20 +275,6 @@ io.on
 
 		socket.emit("welcome", { payload: "Server says hello" });
 
-		//Periodically send the current server time to the client in string form
-		setInterval
-		(
-			function()
-			{
-				//Fetch the object containing the current robot status vars
-				var robot_status = orangebot_platform_cpp_module.get_status();
-				//Send the object directly to the browser
-				socket.emit("robot_status", robot_status );	
-			},
-			//Send periodically
-			time_send_robot_data_to_browser
-		);
-
 		socket.on
 		(
 			"myclick",
@@ -304,6 +311,66 @@ io.on
 				console.log("Pong received. Round trip time[ms]: " +(timestamp_ms_pong -timestamp_ms_ping));
 			}
 		);
+
+		//Trace level of a module of the C++ module, on the live robot. { module: "parser", level: "call" }
+		socket.on
+		(
+			"trace_level",
+			function (data)
+			{
+				if (orangebot_platform_cpp_module.trace_set_level( String(data.module), String(data.level) ) == true)
+				{
+					console.log("ERR: bad trace level ", data.module, data.level);
+				}
+				socket.emit("trace_levels", orangebot_platform_cpp_module.trace_get_levels());
+			}
+		);
+	}
+);
+
+//-----------------------------------------------------------------------------------
+//	WEBSOCKET SERVER: BINARY TELEMETRY
+//-----------------------------------------------------------------------------------
+//	The C++ module serializes the robot status in a fixed little endian frame. Layout in status_snapshot.h
+//	Single producer: one frame per status event, the same Buffer is sent to every browser
+//	Closed sockets leave the clients set on their own
+
+var telemetry_websocket = new websocket.Server({port: websocket_telemetry_port, perMessageDeflate: false});
+
+robot_events.on
+(
+	"status",
+	function()
+	{
+		//If: nobody is watching
+		if (telemetry_websocket.clients.size <= 0)
+		{
+			return;
+		}
+		//Serialize once
+		var frame = orangebot_platform_cpp_module.get_status_frame();
+		//Fan out
+		telemetry_websocket.clients.forEach
+		(
+			function(client)
+			{
+				if (client.readyState === websocket.OPEN)
+				{
+					client.send( frame );
+				}
+			}
+		);
+	}
+);
+
+telemetry_websocket.on
+(
+	"connection",
+	function(socket)
+	{
+		console.log("telemetry viewers: ", telemetry_websocket.clients.size);
+		//Show the current status right away, don't wait for the next change
+		socket.send( orangebot_platform_cpp_module.get_status_frame() );
 	}
 );
 
@@ -363,16 +430,95 @@ streaming_websocket.broadcast = function(data)
 //-----------------------------------------------------------------------------------
 //	Communication with the HotBlack Hat through GPIO
 
-//Connect to the serial port on th GPIO
-var my_uart = new SerialPort
+//Serial port on the GPIO. Override with a pty to test without the motor board
+const serial_port_name = process.env.ORANGEBOT_SERIAL || "/dev/ttyS0";
+//Serial port baud rate
+const serial_port_baud = 256000;
+//Record the serial traffic to this file. Empty = no recording
+const session_log_name = process.env.ORANGEBOT_SESSION_LOG || "";
+//Time between attempts to reopen a serial port that hung up [ms]
+const time_serial_reopen = 1000;
+//Replay this recorded session instead of opening the serial port. Empty = live robot
+const session_replay_name = process.env.ORANGEBOT_REPLAY || "";
+//Replay pace. "fast" feeds the recording at max speed to benchmark the parser
+const session_replay_realtime = (process.env.ORANGEBOT_REPLAY_SPEED != "fast");
+//kill -USR2 <pid> writes the trace rings of the C++ module here. Decode with tools/trace_decode
+const trace_dump_name = process.env.ORANGEBOT_TRACE_DUMP || "trace.bin";
+//Trace levels at start. "module:level,...", e.g. "parser:call,handlers:info" or "all:off". Default error
+const trace_level_config = process.env.ORANGEBOT_TRACE || "";
+
+//Apply the trace levels. Modules and levels are named in trace.h
+trace_level_config.split(",").filter( item => item.length > 0 ).forEach
 (
-	"/dev/ttyS0",
+	function( item )
 	{
-		baudRate: 256000,
-		openImmediately: true
-	},
-	false
+		const field = item.split(":");
+		if ((field.length != 2) || (orangebot_platform_cpp_module.trace_set_level( field[0], field[1] ) == true))
+		{
+			console.log("ERR: bad trace level ", item);
+		}
+	}
 );
+console.log("Trace levels: ", orangebot_platform_cpp_module.trace_get_levels());
+
+process.on
+(
+	"SIGUSR2",
+	function()
+	{
+		if (orangebot_platform_cpp_module.trace_dump( trace_dump_name ) == false)
+		{
+			console.log("Trace dumped to ", trace_dump_name);
+		}
+		else
+		{
+			console.log("ERR: failed to dump trace to ", trace_dump_name);
+		}
+	}
+);
+//Firmware log messages lost so far
+var firmware_log_lost = 0;
+//Numeric robot status. Int32Array owned by the C++ module, refreshed in place. Index with status_layout
+const robot_status = orangebot_platform_cpp_module.get_status_array();
+
+//Called on the NODE.JS thread with the robot status. f_hangup = true when the serial port hung up
+function serial_status_callback( status_array, f_hangup )
+{
+	//If: port hung up (USB unplugged, pty closed). The serial thread is gone
+	if (f_hangup === true)
+	{
+		console.log("ERR: serial port hung up ", serial_port_name);
+		orangebot_platform_cpp_module.serial_close();
+		setTimeout( serial_reopen, time_serial_reopen );
+		return;
+	}
+	robot_events.emit( "status", status_array );
+}
+
+//Reopen the serial port after a hang up. Try again until it comes back
+function serial_reopen()
+{
+	if (orangebot_platform_cpp_module.serial_open( serial_port_name, serial_port_baud, serial_status_callback ) == false)
+	{
+		console.log("Port is open again!");
+		//The motor board may have been reset meanwhile
+		robot_communication_config();
+	}
+	else
+	{
+		setTimeout( serial_reopen, time_serial_reopen );
+	}
+}
+
+//The C++ module owns the serial port on its own thread. Keep the write(msg, callback) interface of the senders
+var my_uart =
+{
+	write : function( msg, callback )
+	{
+		var ret = orangebot_platform_cpp_module.serial_write( msg );
+		callback( (ret < 0) ? ("serial write failed") : (null), ret );
+	}
+};
 
 //-----------------------------------------------------------------------------------
 //	SERIAL PORT HANDLER
@@ -382,28 +528,67 @@ var my_uart = new SerialPort
 //	"F\0"		would be signature if RX worked in this demo. Probably an electrical problem on the hat
 //	"VR%dL%d\0"	set speed to motors. -13 to +13 are the caps. over 100 make the hat crash. It's a demo.
 
-//Detect port open
-my_uart.on
-(
-	"open",
-	function()
+//Open the port. The serial thread parses the messages and calls back with the robot status
+//Limit the rate of status events. Bursts of messages are merged
+orangebot_platform_cpp_module.set_event_rate( robot_event_rate );
+//The callback receives robot_status itself, already refreshed
+if (session_replay_name != "")
+{
+	//Same status events as the live robot, from the recording
+	if (orangebot_platform_cpp_module.session_replay( session_replay_name, session_replay_realtime, function( status_array ) { robot_events.emit( "status", status_array ); } ) == false)
 	{
-		console.log("Port is open!");
-		//Initialize robot communication
-		robot_communication_init();
+		console.log("Replaying ", session_replay_name);
+		//Report when the recording is over
+		var replay_timer = setInterval
+		(
+			function()
+			{
+				var replay_stats = orangebot_platform_cpp_module.session_replay_stats();
+				if (replay_stats.running == false)
+				{
+					clearInterval( replay_timer );
+					console.log("Replay done: ", replay_stats, "parser MB/s:", replay_stats.bytes /replay_stats.handler_ms /1000);
+					orangebot_platform_cpp_module.serial_close();
+				}
+			},
+			time_send_serial_messages
+		);
 	}
-);
+	else
+	{
+		console.log("ERR: failed to open session ", session_replay_name);
+	}
+}
+else if (orangebot_platform_cpp_module.serial_open( serial_port_name, serial_port_baud, serial_status_callback ) == false)
+{
+	//If: recording the session
+	if ((session_log_name != "") && (orangebot_platform_cpp_module.session_log_open( session_log_name ) == true))
+	{
+		console.log("ERR: failed to open session log ", session_log_name);
+	}
+	console.log("Port is open!");
+	//Initialize robot communication
+	robot_communication_init();
+}
+else
+{
+	console.log("ERR: failed to open serial port ", serial_port_name);
+}
 
-//Data from hat. Currently does not work neither in HW nor in SW.
-my_uart.on
+//Show the log messages of the motor board. Live or replayed
+setInterval
 (
-	"data",
-	function(data)
+	function()
 	{
-		console.log( "RX: ", data.toString() );
-		//Feed data to C++ module that takes care of decoding the serial stream
-		orangebot_platform_cpp_module.parse( data.toString() );
-	}
+		var log = orangebot_platform_cpp_module.firmware_log();
+		log.messages.forEach( msg => console.log("FW", msg.time.toFixed(1), msg.text) );
+		if (log.lost > firmware_log_lost)
+		{
+			console.log("ERR: firmware log messages lost: ", log.lost -firmware_log_lost);
+			firmware_log_lost = log.lost;
+		}
+	},
+	time_firmware_log
 );
 
 //-----------------------------------------------------------------------------------
@@ -416,8 +601,11 @@ my_uart.on
 
 function robot_communication_init()
 {
-	//Ask robot for firmware signature
-	send_message_signature_request();
+	//Configure the motor board
+	robot_communication_config();
+	
+	//Periodically ping the motor board to keep the clocks synchronized
+	setInterval( orangebot_platform_cpp_module.serial_sync, time_clock_sync );
 	
 	//Periodically send the current server time to the client in string form
 	setInterval
@@ -434,16 +622,39 @@ function robot_communication_init()
 			}
 			//Ask for the next encoder speed
 			send_message_enc_spd_request();
+			//Ask for the motor currents
+			send_message_current_request();
 			//Set the PWM
 			send_message_set_pwm_dual( vel_r, vel_l );
 			//Show decoded
-			console.log( orangebot_platform_cpp_module.get_status() );
+			console.log
+			(
+				"generation:", robot_status[status_layout.generation] >>> 0,
+				"enc_pos:", robot_status.subarray( status_layout.enc_pos, status_layout.enc_pos +num_enc ),
+				"enc_spd:", robot_status.subarray( status_layout.enc_spd, status_layout.enc_spd +num_enc ),
+				"current:", robot_status.subarray( status_layout.current, status_layout.current +num_pwm ),
+				"diag:", robot_status.subarray( status_layout.diag, status_layout.diag +num_pwm )
+			);
 		},
 		//Send periodically speed to the motors
 		time_send_serial_messages
 	);
 }
 
+//Messages that configure the motor board. At start and each time the serial port is reopened
+function robot_communication_config()
+{
+	//Ask robot for firmware signature
+	send_message_signature_request();
+	//Configure the period of the control system. Board answers with the period in use
+	send_message_set_ctrl_tick( ctrl_tick_us );
+	//Read back the configuration the board loaded from EEPROM. Never overwrite it here, the tuned values would be lost
+	for (var id = 0;id < num_config;id++)
+	{
+		send_message_config_get( id );
+	}
+}
+
 //-----------------------------------------------------------------------------------
 //	SERVER DATE&TIME
 //-----------------------------------------------------------------------------------
@@ -662,6 +873,29 @@ function send_message_enc_spd_request()
 	);
 }
 
+//Ask for the filtered motor currents
+function send_message_current_request()
+{
+	//Construct motor current request
+	var msg = "CUR\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
 //Compute the PWM set message to send the HotBlack Shield
 function send_message_set_pwm_dual( vel_r, vel_l )
 {
@@ -687,3 +921,163 @@ function send_message_set_pwm_dual( vel_r, vel_l )
 	);
 }
 
+//Set limit, acceleration and deceleration slope of one channel of the slew rate limiter
+function send_message_set_pwm_param( index, max, accel, decel )
+{
+	//Construct message
+	var msg = "PWM_PARAM" + index + ":" + max + ":" + accel + ":" + decel + "\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
+//Set the period of the control system of the motor board [us]
+function send_message_set_ctrl_tick( period_us )
+{
+	//Construct message
+	var msg = "TICK" + period_us + "\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
+//Set current limit, stall current and stall duration of the motor board
+function send_message_set_current_limit( limit, stall, ticks )
+{
+	//Construct message
+	var msg = "CUR_LIMIT" + limit + ":" + stall + ":" + ticks + "\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
+//Ask the motor board for a configuration parameter. CFG_* id of orangebot_config.h
+function send_message_config_get( id )
+{
+	//Construct message
+	var msg = "CFG_GET" + id + "\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
+//Change a configuration parameter of the motor board. Applied at once, lost at reset unless saved
+function send_message_config_set( id, value )
+{
+	//Construct message
+	var msg = "CFG_SET" + id + ":" + value + "\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
+//Save the configuration of the motor board in EEPROM. Board answers with the CRC once done
+function send_message_config_save()
+{
+	//Construct message
+	var msg = "CFG_SAVE\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
+
+//Calibrate the linearization tables of the motors of a bit mask. Robot on stands. Each motor answers with a LOG. CFG_SAVE keeps the tables
+function send_message_calib( mask )
+{
+	//Construct message
+	var msg = "CALIB" + mask + "\0";
+	//UART Send message
+	my_uart.write
+	(
+		msg,
+		function(err, res)
+		{
+			if (err)
+			{
+				console.log("err ", err);
+			}
+			else
+			{
+				console.log("TX: ", msg);
+			}
+		}
+	);
+}
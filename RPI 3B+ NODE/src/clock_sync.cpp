@@ -0,0 +1,604 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Clock_sync
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Offset and drift of the AT4809 RTC against the RPI CLOCK_MONOTONIC
+**	The RTC runs from the internal 32.768KHz oscillator. It can be a few
+**	percent off and drifts with temperature. The fit tracks both
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_OTHER
+#include "debug.h"
+//Platform configuration. TIMESTAMP_HZ
+#include "../../orangebot_config.h"
+//Class Header
+#include "clock_sync.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Nanoseconds of one firmware tick at the nominal rate
+#define CLOCK_SYNC_NOMINAL_NS_PER_TICK	(1000000000.0 /TIMESTAMP_HZ)
+
+/****************************************************************************
+**	LOCAL FUNCTIONS
+****************************************************************************/
+
+//Number of decimal digits of a number
+static inline int num_digits( uint32_t num )
+{
+	int ret = 1;
+	while (num >= 10)
+	{
+		num /= 10;
+		ret++;
+	}
+	return ret;
+}
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Clock_sync | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Clock_sync::Clock_sync( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Setter
+//!	set_baud | int
+/***************************************************************************/
+//! @param baud | baud rate of the serial link
+//! @return bool | false = OK | true = FAIL
+/***************************************************************************/
+
+bool Clock_sync::set_baud( int baud )
+{
+	//If: bad baud rate
+	if (baud <= 0)
+	{
+		return true;	//FAIL
+	}
+	//8N1. Ten bits per byte
+	this -> g_byte_ns = 10LL *1000000000LL /baud;
+	return false;	//OK
+}	//end setter: set_baud | int
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	samples | void
+/***************************************************************************/
+//! @return int | round trips used by the fit
+/***************************************************************************/
+
+int Clock_sync::samples( void ) const
+{
+	return this -> g_fit_samples;
+}	//end getter: samples | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	rtt_min_ns | void
+/***************************************************************************/
+//! @return int64_t | fastest round trip without UART time [ns]. -1 = none
+/***************************************************************************/
+
+int64_t Clock_sync::rtt_min_ns( void ) const
+{
+	return this -> g_rtt_min_ns;
+}	//end getter: rtt_min_ns | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	skew_ppm | void
+/***************************************************************************/
+//! @return double | drift of the firmware clock [ppm]. Positive = firmware runs fast
+/***************************************************************************/
+
+double Clock_sync::skew_ppm( void ) const
+{
+	//Fast firmware clock = fewer ns per tick
+	return (CLOCK_SYNC_NOMINAL_NS_PER_TICK /this -> g_fit_b -1.0) *1000000.0;
+}	//end getter: skew_ppm | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	error_ns | void
+/***************************************************************************/
+//! @return int64_t | estimated error of the mapping [ns]. -1 = no mapping
+/***************************************************************************/
+
+int64_t Clock_sync::error_ns( void ) const
+{
+	//If: no round trip yet
+	if (this -> g_fit_samples == 0)
+	{
+		return -1;
+	}
+	return this -> g_rtt_min_ns /2 +this -> g_residual_ns;
+}	//end getter: error_ns | void
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_synced | void
+/***************************************************************************/
+//! @return bool | true = enough round trips to trust the mapping
+/***************************************************************************/
+
+bool Clock_sync::is_synced( void ) const
+{
+	return (this -> g_fit_samples >= CLOCK_SYNC_MIN_SAMPLES);
+}	//end tester: is_synced | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Forget round trips and fit. Baud rate is kept
+/***************************************************************************/
+
+void Clock_sync::reset( void )
+{
+	//Baud rate is a property of the link
+	int64_t byte_ns = this -> g_byte_ns;
+	this -> init();
+	this -> g_byte_ns = byte_ns;
+	return;
+}	//end method: reset | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	restart | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	The firmware was reset (LOG_BOOT). Round trips before the reset belong to another clock
+//!	Pings in flight are kept, the firmware answers them with the new clock
+/***************************************************************************/
+
+void Clock_sync::restart( void )
+{
+	//Trace Enter
+	DENTER();
+	this -> clear_samples();
+	//Trace Return
+	DRETURN();
+	return;
+}	//end method: restart | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	request | int64_t, char *, int
+/***************************************************************************/
+//! @param now_ns | CLOCK_MONOTONIC. Caller sends the message right after
+//! @param msg | destination of the message
+//! @param size | size of msg
+//! @return int | bytes of the message including the '\0' terminator | -1 = FAIL
+//!	@details
+//!	PING<token>. The oldest pending ping is dropped if no slot is free
+/***************************************************************************/
+
+int Clock_sync::request( int64_t now_ns, char *msg, int size )
+{
+	//Trace Enter
+	DENTER();
+
+	//Bytes of the message
+	int length;
+	//Slot of the ping
+	Clock_sync_pending &pending = this -> g_pending[ this -> g_token %CLOCK_SYNC_PENDING ];
+
+	length = snprintf( msg, size, "PING%u", this -> g_token );
+	//If: message does not fit
+	if ((length < 0) || (length +1 > size))
+	{
+		DRETURN_ARG("ERR: message buffer too small\n");
+		return -1;	//FAIL
+	}
+	//Terminator is part of the message
+	length++;
+	pending.token = this -> g_token;
+	pending.sent_ns = now_ns;
+	pending.length = length;
+	this -> g_token++;
+
+	//Trace Return
+	DRETURN_ARG("token: %u\n", pending.token);
+	return length;	//OK
+}	//end method: request | int64_t, char *, int
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reply | uint32_t, uint32_t, int64_t
+/***************************************************************************/
+//! @param token | token echoed by the firmware
+//! @param timestamp | firmware RTC timestamp when the ping was decoded
+//! @param arrival_ns | CLOCK_MONOTONIC when the reply was read
+//! @return bool | false = OK | true = unknown token or too slow
+//!	@details
+//!	Algorithm:
+//!	>Round trip from send to arrival, minus the UART time of PING and PONG
+//!	>Firmware instant is the end of the PING on the wire plus half the remaining round trip
+//!	>Timestamp before the previous one: the firmware was reset. Empty the ring
+//!	>Add to the ring and fit again
+/***************************************************************************/
+
+bool Clock_sync::reply( uint32_t token, uint32_t timestamp, int64_t arrival_ns )
+{
+	//Trace Enter
+	DENTER_ARG("token: %u | timestamp: %u\n", token, timestamp);
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Slot of the ping
+	Clock_sync_pending &pending = this -> g_pending[ token %CLOCK_SYNC_PENDING ];
+	//UART time of the ping and of the reply
+	int64_t uart_ping_ns;
+	int64_t uart_pong_ns;
+	//New round trip
+	Clock_sync_sample sample;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: reply to a ping that is not pending
+	if ((pending.sent_ns == 0) || (pending.token != token))
+	{
+		DRETURN_ARG("ERR: unknown token\n");
+		return true;	//FAIL
+	}
+	//PONG<token>:<timestamp> and terminator
+	uart_ping_ns = pending.length *this -> g_byte_ns;
+	uart_pong_ns = (4 +num_digits( token ) +1 +num_digits( timestamp ) +1) *this -> g_byte_ns;
+	sample.rtt_ns = arrival_ns -pending.sent_ns -uart_ping_ns -uart_pong_ns;
+	sample.local_ns = pending.sent_ns +uart_ping_ns +sample.rtt_ns /2;
+	//If: reply queued behind other traffic for too long
+	if (arrival_ns -pending.sent_ns > CLOCK_SYNC_MAX_RTT_NS)
+	{
+		pending.sent_ns = 0;
+		DRETURN_ARG("ERR: too slow\n");
+		return true;	//FAIL
+	}
+	//Slot is free again
+	pending.sent_ns = 0;
+	//Bytes arrive in chunks. Round trip can come out slightly below the UART time
+	if (sample.rtt_ns < 0)
+	{
+		sample.rtt_ns = 0;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//! Unwrap near the previous timestamp
+	sample.ticks = (this -> g_num_samples == 0) ? ((int64_t)timestamp) : (this -> unwrap( timestamp ));
+	//If: firmware clock went backwards. Pings are answered in order, only a reset does this
+	if (sample.ticks < this -> g_ref_ticks)
+	{
+		DPRINT("firmware clock restarted | timestamp: %u\n", timestamp);
+		this -> clear_samples();
+		sample.ticks = (int64_t)timestamp;
+	}
+	this -> g_ref_ticks = sample.ticks;
+	//! Add to the ring
+	this -> g_sample[ this -> g_sample_index ] = sample;
+	this -> g_sample_index = (this -> g_sample_index +1) %CLOCK_SYNC_SAMPLES;
+	if (this -> g_num_samples < CLOCK_SYNC_SAMPLES)
+	{
+		this -> g_num_samples++;
+	}
+	//! New mapping
+	this -> fit();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN_ARG("rtt: %lld | skew: %f ppm\n", (long long)sample.rtt_ns, this -> skew_ppm());
+	return false;	//OK
+}	//end method: reply | uint32_t, uint32_t, int64_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	unwrap | uint32_t
+/***************************************************************************/
+//! @param timestamp | 32 bit firmware timestamp
+//! @return int64_t | timestamp on the same 64 bit scale as the round trips
+//!	@details
+//!	Valid for timestamps within 18 hours of the latest round trip
+/***************************************************************************/
+
+int64_t Clock_sync::unwrap( uint32_t timestamp ) const
+{
+	return this -> g_ref_ticks +(int32_t)(timestamp -(uint32_t)this -> g_ref_ticks);
+}	//end method: unwrap | uint32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	to_local_ns | uint32_t
+/***************************************************************************/
+//! @param timestamp | 32 bit firmware timestamp
+//! @return int64_t | RPI CLOCK_MONOTONIC of the same instant [ns]
+//!	@details
+//!	Meaningful once is_synced(). Before the first round trip it returns 0
+/***************************************************************************/
+
+int64_t Clock_sync::to_local_ns( uint32_t timestamp ) const
+{
+	//If: no round trip yet
+	if (this -> g_fit_samples == 0)
+	{
+		return 0;
+	}
+	return this -> g_fit_y0 +(int64_t)llround( this -> g_fit_a +this -> g_fit_b *(double)(this -> unwrap( timestamp ) -this -> g_fit_x0) );
+}	//end method: to_local_ns | uint32_t
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables. Default baud rate is the one of the motor board
+/***************************************************************************/
+
+void Clock_sync::init( void )
+{
+	//Default link
+	this -> set_baud( 256000 );
+	this -> g_token = 0;
+	memset( this -> g_pending, 0, sizeof(this -> g_pending) );
+	this -> clear_samples();
+
+	return;	//OK
+}	//end method: init | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	clear_samples | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Empty the ring of round trips. No mapping, nominal rate
+/***************************************************************************/
+
+void Clock_sync::clear_samples( void )
+{
+	memset( this -> g_sample, 0, sizeof(this -> g_sample) );
+	this -> g_num_samples = 0;
+	this -> g_sample_index = 0;
+	this -> g_ref_ticks = 0;
+	//No mapping. Nominal rate
+	this -> g_fit_x0 = 0;
+	this -> g_fit_y0 = 0;
+	this -> g_fit_a = 0.0;
+	this -> g_fit_b = CLOCK_SYNC_NOMINAL_NS_PER_TICK;
+	this -> g_rtt_min_ns = -1;
+	this -> g_residual_ns = 0;
+	this -> g_fit_samples = 0;
+
+	return;	//OK
+}	//end method: clear_samples | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	fit | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Algorithm:
+//!	>Fastest round trip in the ring
+//!	>Keep the round trips within CLOCK_SYNC_RTT_MARGIN_NS of it
+//!	>Least squares line local_ns = a +b *ticks, relative to the latest round trip for precision
+//!	>Too short a span, or an absurd drift: nominal rate, mean offset
+/***************************************************************************/
+
+void Clock_sync::fit( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Counter
+	int t;
+	//Round trips used
+	int n = 0;
+	//Sums of the least squares
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	//Span of the used round trips [ticks]
+	int64_t x_min = 0, x_max = 0;
+	//Coordinates of a round trip
+	double x, y;
+	//Residual
+	double res, sres = 0.0;
+	//Fastest round trip
+	int64_t rtt_min = -1;
+	//Latest round trip is the reference of the fit
+	const Clock_sync_sample &latest = this -> g_sample[ (this -> g_sample_index +CLOCK_SYNC_SAMPLES -1) %CLOCK_SYNC_SAMPLES ];
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//! Fastest round trip
+	for (t = 0;t < this -> g_num_samples;t++)
+	{
+		if ((rtt_min < 0) || (this -> g_sample[t].rtt_ns < rtt_min))
+		{
+			rtt_min = this -> g_sample[t].rtt_ns;
+		}
+	}
+	//! Sums over the fast round trips
+	for (t = 0;t < this -> g_num_samples;t++)
+	{
+		const Clock_sync_sample &sample = this -> g_sample[t];
+		if (sample.rtt_ns > rtt_min +CLOCK_SYNC_RTT_MARGIN_NS)
+		{
+			continue;
+		}
+		x = (double)(sample.ticks -latest.ticks);
+		y = (double)(sample.local_ns -latest.local_ns);
+		x_min = ((n == 0) || (sample.ticks < x_min)) ? (sample.ticks) : (x_min);
+		x_max = ((n == 0) || (sample.ticks > x_max)) ? (sample.ticks) : (x_max);
+		sx += x;
+		sy += y;
+		sxx += x *x;
+		sxy += x *y;
+		n++;
+	}
+	//! Line
+	this -> g_fit_x0 = latest.ticks;
+	this -> g_fit_y0 = latest.local_ns;
+	this -> g_fit_b = CLOCK_SYNC_NOMINAL_NS_PER_TICK;
+	//If: span long enough to see the drift
+	if ((n >= 2) && (x_max -x_min >= CLOCK_SYNC_MIN_SPAN))
+	{
+		this -> g_fit_b = (n *sxy -sx *sy) /(n *sxx -sx *sx);
+		//If: absurd drift. Bad samples, keep the nominal rate
+		if (fabs( CLOCK_SYNC_NOMINAL_NS_PER_TICK /this -> g_fit_b -1.0 ) *1000000.0 > CLOCK_SYNC_MAX_SKEW_PPM)
+		{
+			this -> g_fit_b = CLOCK_SYNC_NOMINAL_NS_PER_TICK;
+		}
+	}
+	this -> g_fit_a = (sy -this -> g_fit_b *sx) /n;
+	//! Quality
+	for (t = 0;t < this -> g_num_samples;t++)
+	{
+		const Clock_sync_sample &sample = this -> g_sample[t];
+		if (sample.rtt_ns > rtt_min +CLOCK_SYNC_RTT_MARGIN_NS)
+		{
+			continue;
+		}
+		res = (double)(sample.local_ns -latest.local_ns) -this -> g_fit_a -this -> g_fit_b *(double)(sample.ticks -latest.ticks);
+		sres += res *res;
+	}
+	this -> g_residual_ns = (int64_t)sqrt( sres /n );
+	this -> g_rtt_min_ns = rtt_min;
+	this -> g_fit_samples = n;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end method: fit | void
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,241 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef CLOCK_SYNC_H_
+	#define CLOCK_SYNC_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+//Requires orangebot_config.h (through panopticon.h) to be included before. TIMESTAMP_HZ
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Round trip samples kept for the fit. At one ping every 100ms the fit spans about 3s
+#define CLOCK_SYNC_SAMPLES			32
+//Pings waiting for their reply
+#define CLOCK_SYNC_PENDING			4
+//Samples with a round trip within this margin of the fastest one are used for the fit [ns]
+#define CLOCK_SYNC_RTT_MARGIN_NS	300000
+//Replies slower than this are discarded [ns]
+#define CLOCK_SYNC_MAX_RTT_NS		50000000
+//Samples needed before the mapping is trusted
+#define CLOCK_SYNC_MIN_SAMPLES		4
+//Minimum span of the fit before drift is estimated. Below it the nominal TIMESTAMP_HZ is used [ticks]
+#define CLOCK_SYNC_MIN_SPAN			(TIMESTAMP_HZ /2)
+//Drift beyond this is treated as a bad fit and the nominal rate is used [ppm]
+#define CLOCK_SYNC_MAX_SKEW_PPM		50000.0
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//! One ping round trip
+typedef struct _Clock_sync_sample
+{
+	//Firmware timestamp, unwrapped [ticks]
+	int64_t ticks;
+	//RPI CLOCK_MONOTONIC estimate of the same instant [ns]
+	int64_t local_ns;
+	//Round trip without the UART serialization [ns]
+	int64_t rtt_ns;
+} Clock_sync_sample;
+
+//! Ping waiting for its reply
+typedef struct _Clock_sync_pending
+{
+	//Token of the ping
+	uint32_t token;
+	//RPI CLOCK_MONOTONIC when the ping was sent [ns]. 0 = free slot
+	int64_t sent_ns;
+	//Bytes of the ping message
+	int length;
+} Clock_sync_pending;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Clock_sync
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Map the firmware RTC timestamps to the RPI CLOCK_MONOTONIC
+//! @details
+//!	The RPI sends PING<token>. The firmware answers PONG<token>:<timestamp> \n
+//!	The firmware instant is placed in the middle of the round trip, after removing the UART time of both messages \n
+//!	Queueing only ever adds delay. Only the round trips close to the fastest one are kept \n
+//!	A least squares line through them gives offset and drift of the firmware clock \n
+//!	A firmware reset restarts the timestamps. A timestamp going backwards, or restart() on LOG_BOOT, empties the ring \n
+//!	Plain data. Can be copied to hand a consistent view to another thread
+//! @bug		None
+//! @warning	Not thread safe. Owner serializes access
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Clock_sync
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Clock_sync( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Baud rate of the serial link. Used to remove the UART time from the round trip. false = OK
+		bool set_baud( int baud );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Round trips kept for the fit
+		int samples( void ) const;
+		//Fastest round trip in the fit [ns]. -1 = none
+		int64_t rtt_min_ns( void ) const;
+		//Drift of the firmware clock against the RPI clock [ppm]. Positive = firmware runs fast
+		double skew_ppm( void ) const;
+		//Estimated error of the mapping [ns]. Half the fastest round trip plus the RMS residual of the fit
+		int64_t error_ns( void ) const;
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = enough round trips to trust the mapping
+		bool is_synced( void ) const;
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Forget all round trips
+		void reset( void );
+		//The firmware restarted its clock. Forget the round trips, keep the pending pings
+		void restart( void );
+		//Build the next PING message. Return the length including the terminator. -1 = FAIL
+		int request( int64_t now_ns, char *msg, int size );
+		//A PONG message arrived. false = OK | true = unknown token or too slow
+		bool reply( uint32_t token, uint32_t timestamp, int64_t arrival_ns );
+		//Unwrap a 32 bit firmware timestamp near the latest round trip [ticks]
+		int64_t unwrap( uint32_t timestamp ) const;
+		//RPI CLOCK_MONOTONIC [ns] of a firmware timestamp
+		int64_t to_local_ns( uint32_t timestamp ) const;
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+		//Empty the ring of round trips and drop the mapping
+		void clear_samples( void );
+		//Fit the line through the fastest round trips
+		void fit( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//UART time of one byte. Start, 8 data, stop [ns]
+		int64_t g_byte_ns;
+		//Token of the next ping
+		uint32_t g_token;
+		//Pings waiting for their reply
+		Clock_sync_pending g_pending[ CLOCK_SYNC_PENDING ];
+		//Ring of round trips
+		Clock_sync_sample g_sample[ CLOCK_SYNC_SAMPLES ];
+		//Round trips in the ring
+		int g_num_samples;
+		//Next slot of the ring
+		int g_sample_index;
+		//Latest firmware timestamp, unwrapped. Reference to unwrap the others
+		int64_t g_ref_ticks;
+		//Fit: local_ns = g_fit_y0 +g_fit_a +g_fit_b *(ticks -g_fit_x0)
+		int64_t g_fit_x0;
+		int64_t g_fit_y0;
+		double g_fit_a;
+		double g_fit_b;
+		//Fit quality
+		int64_t g_rtt_min_ns;
+		int64_t g_residual_ns;
+		//Round trips used by the fit
+		int g_fit_samples;
+
+};	//End Class: Clock_sync
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -89,6 +89,48 @@
 		#define DRETURN_ARG( ... )	\
 			(_debug_indent_level>0)?(--_debug_indent_level):(0), DPRINT( "<<-- \"%s\" | ", __FUNCTION__), DPRINT_NOTAB( __VA_ARGS__ )
 
+	#elif defined( ENABLE_TRACE )
+
+		///----------------------------------------------------------------
+		///	BINARY TRACE
+		///----------------------------------------------------------------
+		//	Same macros, recorded as binary records in per thread rings. See trace.h
+		//	Cheap enough to stay on in production. Dump with trace_dump, decode with tools/trace_decode
+		//	ENABLE_DEBUG in a file takes precedence and prints that file to debug.log
+		//	Each file selects its TRACE_MODULE. The level of each module is set at run time with trace_set_level
+
+		#include "trace.h"
+
+		#define DEBUG_VARS_PROTOTYPES()
+
+		#define DEBUG_VARS()
+
+		#define DSHOW( ... )
+
+		#define DSTART( ... )
+
+		#define DSTOP()
+
+		#define DTAB( ... )
+
+		#define DPRINT( ... )	\
+			TRACE_POINT( ::Orangebot::TRACE_PRINT, __VA_ARGS__ )
+
+		#define DPRINT_NOTAB( ... )	\
+			TRACE_POINT( ::Orangebot::TRACE_PRINT, __VA_ARGS__ )
+
+		#define DENTER( ... )	\
+			TRACE_POINT( ::Orangebot::TRACE_ENTER, nullptr )
+
+		#define DRETURN( ... )	\
+			TRACE_POINT( ::Orangebot::TRACE_RETURN, nullptr )
+
+		#define DENTER_ARG( ... )	\
+			TRACE_POINT( ::Orangebot::TRACE_ENTER, __VA_ARGS__ )
+
+		#define DRETURN_ARG( ... )	\
+			TRACE_POINT( ::Orangebot::TRACE_RETURN, __VA_ARGS__ )
+
 	#else
 		#define DEBUG_VARS_PROTOTYPES()
 
@@ -0,0 +1,251 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Firmware_log
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Log messages of the motor board. LOG<id>:<arg0>:<arg1>
+**	The firmware has no room for strings and no spare UART bandwidth
+**	It sends an id and two numbers, the text lives in LOG_FORMATS
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_OTHER
+#include "debug.h"
+//Platform configuration. LOG_FORMATS
+#include "../../orangebot_config.h"
+//Class Header
+#include "firmware_log.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILE
+****************************************************************************/
+
+//Text of each LOG_* id
+static const char *g_firmware_log_format[ LOG_NUM_ID ] = LOG_FORMATS;
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Firmware_log | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Firmware_log::Firmware_log( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> reset();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	received | void
+/***************************************************************************/
+//! @return uint32_t | LOG messages received
+/***************************************************************************/
+
+uint32_t Firmware_log::received( void ) const
+{
+	return this -> g_top;
+}	//end getter: received | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	lost | void
+/***************************************************************************/
+//! @return uint32_t | LOG messages overwritten before NODE.JS read them
+//!	@details
+//!	Messages dropped by the firmware are reported by the firmware itself with LOG_DROPPED
+/***************************************************************************/
+
+uint32_t Firmware_log::lost( void ) const
+{
+	return this -> g_lost;
+}	//end getter: lost | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Forget the undelivered messages and clear the counters
+/***************************************************************************/
+
+void Firmware_log::reset( void )
+{
+	this -> g_top = 0;
+	this -> g_bot = 0;
+	this -> g_lost = 0;
+	return;
+}	//end method: reset | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	push | int64_t, uint8_t, int16_t, int16_t
+/***************************************************************************/
+//! @param time_ns | arrival of the message. CLOCK_MONOTONIC [ns]
+//! @param id | LOG_* id
+//! @param arg0 | first argument
+//! @param arg1 | second argument
+//! @return void
+//!	@details
+//!	If the ring is full the oldest undelivered message is overwritten
+/***************************************************************************/
+
+void Firmware_log::push( int64_t time_ns, uint8_t id, int16_t arg0, int16_t arg1 )
+{
+	//If: ring is full. Drop the oldest
+	if (this -> g_top -this -> g_bot >= FIRMWARE_LOG_SIZE)
+	{
+		this -> g_bot++;
+		this -> g_lost++;
+	}
+	Firmware_log_entry &entry = this -> g_entry[ this -> g_top & (FIRMWARE_LOG_SIZE -1) ];
+	entry.time_ns = time_ns;
+	entry.id = id;
+	entry.arg[0] = arg0;
+	entry.arg[1] = arg1;
+	this -> g_top++;
+
+	return;
+}	//end method: push | int64_t, uint8_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	pop | Firmware_log_entry &
+/***************************************************************************/
+//! @param entry | destination of the oldest undelivered message
+//! @return bool | false = OK | true = no message
+/***************************************************************************/
+
+bool Firmware_log::pop( Firmware_log_entry &entry )
+{
+	//If: nothing to deliver
+	if (this -> g_top == this -> g_bot)
+	{
+		return true;	//FAIL
+	}
+	entry = this -> g_entry[ this -> g_bot & (FIRMWARE_LOG_SIZE -1) ];
+	this -> g_bot++;
+
+	return false;	//OK
+}	//end method: pop | Firmware_log_entry &
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	format | const Firmware_log_entry &, char *, int
+/***************************************************************************/
+//! @param entry | message to decode
+//! @param text | destination of the text
+//! @param size | size of the destination
+//! @return int | length of the text. -1 = FAIL
+//!	@details
+//!	Ids unknown to this build, e.g. a newer firmware, are shown as id and arguments
+/***************************************************************************/
+
+int Firmware_log::format( const Firmware_log_entry &entry, char *text, int size )
+{
+	//If: bad destination
+	if ((text == nullptr) || (size <= 0))
+	{
+		return -1;	//FAIL
+	}
+	//If: unknown id
+	if (entry.id >= LOG_NUM_ID)
+	{
+		return snprintf( text, size, "LOG%u: %d %d", (unsigned)entry.id, entry.arg[0], entry.arg[1] );
+	}
+	//Every text is given both arguments, it uses the ones it needs
+	return snprintf( text, size, g_firmware_log_format[ entry.id ], entry.arg[0], entry.arg[1] );
+}	//end method: format | const Firmware_log_entry &, char *, int
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
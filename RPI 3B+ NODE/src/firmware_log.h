@@ -0,0 +1,180 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef FIRMWARE_LOG_H_
+	#define FIRMWARE_LOG_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+//Requires orangebot_config.h (through panopticon.h) to be included before. LOG_NUM_ID
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Log messages kept until NODE.JS reads them. Power of two. The oldest are overwritten
+#define FIRMWARE_LOG_SIZE		64
+//Longest decoded text, terminator included
+#define FIRMWARE_LOG_MAX_TEXT	80
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//! One LOG message of the motor board as it arrived
+typedef struct _Firmware_log_entry
+{
+	//Arrival CLOCK_MONOTONIC [ns]
+	int64_t time_ns;
+	//LOG_* id of orangebot_config.h
+	uint8_t id;
+	//Arguments of the text
+	int16_t arg[2];
+} Firmware_log_entry;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Firmware_log
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Log messages of the motor board waiting for NODE.JS
+//! @details
+//!	The firmware sends LOG<id>:<arg0>:<arg1> when its TX buffer has room to spare \n
+//!	Only the id travels on the UART. The text is LOG_FORMATS of orangebot_config.h, expanded here \n
+//!	Ring of the undelivered messages. If NODE.JS falls behind the oldest are overwritten and counted
+//! @bug		None
+//! @warning	Not thread safe. Owner serializes access
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Firmware_log
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Firmware_log( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//LOG messages received
+		uint32_t received( void ) const;
+		//LOG messages overwritten before NODE.JS read them
+		uint32_t lost( void ) const;
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Forget all messages and counters
+		void reset( void );
+		//A LOG message arrived
+		void push( int64_t time_ns, uint8_t id, int16_t arg0, int16_t arg1 );
+		//Oldest undelivered message. false = OK | true = none
+		bool pop( Firmware_log_entry &entry );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Text of a message. Return the length. Unknown ids are shown raw
+		static int format( const Firmware_log_entry &entry, char *text, int size );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Undelivered messages. Index is modulo FIRMWARE_LOG_SIZE
+		Firmware_log_entry g_entry[ FIRMWARE_LOG_SIZE ];
+		//Messages pushed and popped
+		uint32_t g_top;
+		uint32_t g_bot;
+		//Messages overwritten
+		uint32_t g_lost;
+
+};	//End Class: Firmware_log
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
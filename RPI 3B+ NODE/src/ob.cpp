@@ -46,6 +46,17 @@
 **	Main Motor board answers with the relative encoder readings for all encoder channels
 **		SET_ENC_SPD%s:%%s:%s:%s\0
 **	Main Motor board answers with the encoder speed readings for all encoder channels
+**		CUR%U:%U:%U:%U\0
+**	Main Motor board answers with the filtered current of the four VNH7040 in ADC counts
+**		DIAG%u:%u:%u:%u\0
+**	Fault codes of the four VNH7040. Sent on request and whenever a diagnostic sweep changes them
+**		CFG%u:%S\0
+**	Configuration parameter in use. CFG_* id of orangebot_config.h and value
+**		CFG_SAVE%U\0
+**	Configuration was written in EEPROM. Argument is the CRC16 of the record
+**		TICK%U\0
+**	Period of the control system in use [us]. Answer to TICK
+**	ENC_SPD is in counts per control tick. Stall duration, PWM slopes and the CALIB ramp are in control ticks. All scale with the period
 *****************************************************************************
 **		MESSAGES TO MAIN MOTOR BOARD
 **  	OFF\0
@@ -66,8 +77,24 @@
 **	Answer with one %s%s%s%s message
 **		GET_ENC_SPD\0
 **	Ask for all encoder speed readings
-**		SET_PWM_SLOPE%s\0
-**	Set the PWM slope of the PWM slew rate limiter controller
+**		CUR\0
+**	Ask for the motor currents
+**		DIAG\0
+**	Ask for the fault codes of the VNH7040
+**		CFG_GET%u\0
+**	Ask for a configuration parameter. Board answers with CFG
+**		CFG_SET%u:%S\0
+**	Change a configuration parameter. Applied at once. Board answers with CFG
+**		CFG_SAVE\0
+**	Write the configuration in EEPROM. Board answers with CFG_SAVE once done
+**		CUR_LIMIT%U:%U:%U\0
+**	Set current limit [mA], stall current [mA] and stall duration [control ticks]
+**	Board answers with the same message holding the parameters in use
+**		TICK%U\0
+**	Set the period of the control system [us]. Board answers with TICK holding the period in use. No answer if refused
+**		PWM_PARAM%u:%S:%S:%S\0
+**	Set limit, acceleration and deceleration slope of one channel of the PWM slew rate limiter controller
+**	Board answers with the same message holding the parameters in use
 **		GET_POS_PID%s\n
 **
 **		SET_POS_PID%s:%s:%s\0
@@ -99,6 +126,8 @@ Set the gain of the speed PID
 
 //Standard C++ libraries
 #include <iostream>
+#include <string>
+#include <mutex>
 //#include <array>
 //#include <vector>
 //#include <queue>
@@ -114,6 +143,8 @@ Set the gain of the speed PID
 //User Libraries
 //Include user log trace
 //#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_HANDLERS
 #include "debug.h"
 //Universal Parser V5
 #include "uniparser.h"
@@ -121,6 +152,16 @@ Set the gain of the speed PID
 #include "ob.h"
 //Stores robot status variables
 #include "panopticon.h"
+//Lock free copies of the robot status variables for NODE.JS
+#include "status_snapshot.h"
+//Differential drive odometry from the encoder counts
+#include "odometry.h"
+//Latency and inter arrival of the telemetry
+#include "telemetry_stats.h"
+//Map the firmware timestamps to the RPI clock
+#include "clock_sync.h"
+//Log messages of the motor board
+#include "firmware_log.h"
 
 /****************************************************************************
 **	NAMESPACES
@@ -146,6 +187,23 @@ int g_signature_remaining_length;
 int g_signature_length;
 //Temp signature storage
 char g_signature[MAX_SIGNATURE_LENGTH];
+//Held while the parser writes the platform status vars. Serial thread and NODE.JS parse can both write
+std::mutex g_orangebot_platform_mutex;
+//Consistent copies of the platform status vars handed to NODE.JS without locks
+Status_snapshot g_orangebot_status_snapshot;
+//Platform pose integrated from the encoder counts. Protected by g_orangebot_platform_mutex
+Odometry g_orangebot_odometry;
+//Freshness of the telemetry. Protected by g_orangebot_platform_mutex
+Telemetry_stats g_orangebot_telemetry_stats;
+//CLOCK_MONOTONIC [ns] when the bytes being parsed were received
+int64_t g_rx_arrival_ns = 0;
+//Firmware clock against the RPI clock. Protected by g_orangebot_platform_mutex
+Clock_sync g_orangebot_clock_sync;
+//Timestamp of the next telemetry message, valid if the flag is set
+uint32_t g_telemetry_stamp = 0;
+bool g_f_telemetry_stamp = false;
+//Log messages of the motor board waiting for NODE.JS. Protected by g_orangebot_platform_mutex
+Firmware_log g_orangebot_firmware_log;
 
 /****************************************************************************
 **	FUNCTION PROTOTYPES
@@ -158,6 +216,10 @@ extern Orangebot::Panopticon &get_robot_status( void );
 extern bool set_signature_length( int length );
 //Process current data as part of a signature
 extern bool parse_signature( uint8_t data );
+//Feed the encoder counts to the odometry and save the pose
+extern void update_odometry( void );
+//Record the freshness of a telemetry message. Return when its data was sampled on the RPI clock [ms]
+extern double record_telemetry( int type );
 
 	//----------------------------------------------------------------
 	//	HANDLERS
@@ -172,7 +234,11 @@ extern void ping_handler( void );
 //Signature Handler
 extern void get_signature_handler( uint8_t str_length );
 //Timestamp Handler
-extern void get_timestamp_handler( int32_t timestamp );
+extern void get_timestamp_handler( uint32_t timestamp, uint8_t sequence );
+//Clock synchronization reply
+extern void get_pong_handler( uint32_t token, uint32_t timestamp );
+//Log message of the motor board
+extern void get_log_handler( uint8_t id, int16_t arg0, int16_t arg1 );
 
 	//!Encoder Group
 //Single encoder absolute count update
@@ -184,13 +250,29 @@ extern void get_four_enc_spd_handler( int16_t enc_spd_a, int16_t enc_spd_b, int1
 //Two encoder speed update handler
 extern void get_two_enc_spd_handler( int16_t enc_spd_a, int16_t enc_spd_b );
 
+	//! Current Group
+//Motor current update handler
+extern void get_current_handler( uint16_t cur_a, uint16_t cur_b, uint16_t cur_c, uint16_t cur_d );
+//Current limiter and stall detector parameters handler
+extern void get_current_limit_handler( uint16_t limit_ma, uint16_t stall_ma, uint16_t stall_ticks );
+//Fault codes of the motor drivers handler
+extern void get_diag_handler( uint8_t diag_a, uint8_t diag_b, uint8_t diag_c, uint8_t diag_d );
+
+	//! Configuration Group
+//Configuration parameter in use handler
+extern void get_config_handler( uint8_t id, int16_t value );
+//Configuration saved in EEPROM handler
+extern void get_config_save_handler( uint16_t crc );
+
 	//! Control System Target Group
 //Handle the PWM message from the motor board
 extern void get_two_vnh7040_pwm_handler( int16_t pwm_a, int16_t pwm_b );
 
 	//! Control System Group
+//Period of the control system handler
+extern void get_ctrl_tick_handler( uint16_t period_us );
 //PWM slew rate limiter handler
-extern void get_pwm_ctrl_handler( int16_t slew_rate );
+extern void get_pwm_ctrl_handler( uint8_t index, int16_t max, int16_t accel, int16_t decel );
 //Speed PID control parameters handler
 extern void get_spd_ctrl_handler( int16_t gain_proportional, int16_t gain_derivative, int16_t gain_integrative );
 //Position PID control parameters handler
@@ -218,6 +300,297 @@ Panopticon &get_robot_status( void )
 	return g_orangebot_platform;
 }	//end function: get_robot_status | void
 
+/***************************************************************************/
+//!	@brief reference
+//!	get_status_snapshot | void
+/***************************************************************************/
+//! @return Status_snapshot & | published copies of the robot status vars
+//! @details
+//!	NODE.JS reads the status from here. Parser publishes after each chunk of data
+/***************************************************************************/
+
+Status_snapshot &get_status_snapshot( void )
+{
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return g_orangebot_status_snapshot;
+}	//end function: get_status_snapshot | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	odometry_reset | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//!	Pose back to the origin. Current encoder counts become the reference
+/***************************************************************************/
+
+void odometry_reset( void )
+{
+	//Trace Enter
+	DENTER();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//The serial thread may be feeding encoder counts
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	g_orangebot_odometry.reset();
+	//Record the current counts as reference
+	update_odometry();
+	g_orangebot_platform.odom_x() = 0.0;
+	g_orangebot_platform.odom_y() = 0.0;
+	g_orangebot_platform.odom_heading() = 0.0;
+	//Make the pose at the origin visible to NODE.JS
+	g_orangebot_status_snapshot.publish( g_orangebot_platform );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return;
+}	//end function: odometry_reset | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	odometry_config | double, double
+/***************************************************************************/
+//! @param cnt_per_mm | encoder counts per mm of wheel travel
+//! @param track_mm | distance between left and right wheels [mm]
+//! @return bool | false = OK | true = FAIL
+//! @details
+//!	Replace the default geometry from orangebot_config.h. Pose is kept, the heading does not jump
+/***************************************************************************/
+
+bool odometry_config( double cnt_per_mm, double track_mm )
+{
+	//Trace Enter
+	DENTER();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//The serial thread may be feeding encoder counts
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	bool f_ret = g_orangebot_odometry.set_geometry( cnt_per_mm, track_mm );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Trace Return
+	DRETURN_ARG("fail: %d\n", f_ret);
+	return f_ret;
+}	//end function: odometry_config | double, double
+
+/***************************************************************************/
+//!	@brief Function
+//!	get_telemetry_stats | Telemetry_stats &
+/***************************************************************************/
+//! @param stats | destination of the copy
+//! @return void |
+//! @details
+//!	Copy under the lock, the serial thread keeps recording meanwhile
+/***************************************************************************/
+
+void get_telemetry_stats( Telemetry_stats &stats )
+{
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	stats = g_orangebot_telemetry_stats;
+	return;
+}	//end function: get_telemetry_stats | Telemetry_stats &
+
+/***************************************************************************/
+//!	@brief Function
+//!	telemetry_stats_reset | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//!	Clear the histograms and restart the clock offset estimate
+/***************************************************************************/
+
+void telemetry_stats_reset( void )
+{
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	g_orangebot_telemetry_stats.reset();
+	return;
+}	//end function: telemetry_stats_reset | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	clock_sync_request | char *, int
+/***************************************************************************/
+//! @param msg | destination of the PING message
+//! @param size | size of the destination
+//! @return int | bytes to send including the terminator. -1 = FAIL
+//! @details
+//!	Build the next PING and remember when it was sent. Caller writes it to the serial port right away
+/***************************************************************************/
+
+int clock_sync_request( char *msg, int size )
+{
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	return g_orangebot_clock_sync.request( Telemetry_stats::now_ns(), msg, size );
+}	//end function: clock_sync_request | char *, int
+
+/***************************************************************************/
+//!	@brief Function
+//!	get_clock_sync | Clock_sync &
+/***************************************************************************/
+//! @param sync | destination of the copy
+//! @return void |
+//! @details
+//!	Copy under the lock, the serial thread keeps adding round trips meanwhile
+/***************************************************************************/
+
+void get_clock_sync( Clock_sync &sync )
+{
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	sync = g_orangebot_clock_sync;
+	return;
+}	//end function: get_clock_sync | Clock_sync &
+
+/***************************************************************************/
+//!	@brief Function
+//!	clock_sync_set_baud | int
+/***************************************************************************/
+//! @param baud | baud rate of the serial link
+//! @return bool | false = OK | true = FAIL
+//! @details
+//!	The UART time of PING and PONG is removed from the round trip. Round trips are restarted
+/***************************************************************************/
+
+bool clock_sync_set_baud( int baud )
+{
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	return g_orangebot_clock_sync.set_baud( baud );
+}	//end function: clock_sync_set_baud | int
+
+/***************************************************************************/
+//!	@brief Function
+//!	firmware_log_pop | double &, std::string &
+/***************************************************************************/
+//! @param time_ms | arrival of the message. CLOCK_MONOTONIC [ms]
+//! @param text | decoded text of the message
+//! @return bool | false = OK | true = no message
+//! @details
+//!	Oldest log message of the motor board not yet handed to NODE.JS
+/***************************************************************************/
+
+bool firmware_log_pop( double &time_ms, std::string &text )
+{
+	//Message
+	Firmware_log_entry entry;
+	//Decoded text
+	char str[ FIRMWARE_LOG_MAX_TEXT ];
+	{
+		std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+		//If: nothing to deliver
+		if (g_orangebot_firmware_log.pop( entry ) == true)
+		{
+			return true;	//FAIL
+		}
+	}
+	//Format outside the lock
+	Firmware_log::format( entry, str, sizeof(str) );
+	time_ms = entry.time_ns /1000000.0;
+	text = str;
+	return false;	//OK
+}	//end function: firmware_log_pop | double &, std::string &
+
+/***************************************************************************/
+//!	@brief Function
+//!	firmware_log_lost | void
+/***************************************************************************/
+//! @return uint32_t | log messages overwritten before NODE.JS read them
+/***************************************************************************/
+
+uint32_t firmware_log_lost( void )
+{
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	return g_orangebot_firmware_log.lost();
+}	//end function: firmware_log_lost | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	record_telemetry | int
+/***************************************************************************/
+//! @param type | Telemetry_type of the message
+//! @return double | when the data was sampled. RPI CLOCK_MONOTONIC [ms]
+//! @details
+//!	Consume the pending timestamp. With the clocks synchronized the firmware sampling time is mapped on the RPI clock
+//!	Otherwise fall back on the arrival time
+/***************************************************************************/
+
+double record_telemetry( int type )
+{
+	//Sampling time on the RPI clock [ns]. -1 = unknown
+	int64_t sample_ns = -1;
+
+	//If: message is stamped and the clocks are synchronized
+	if ((g_f_telemetry_stamp == true) && (g_orangebot_clock_sync.is_synced() == true))
+	{
+		sample_ns = g_orangebot_clock_sync.to_local_ns( g_telemetry_stamp );
+	}
+	//The stamp belongs to this message only
+	g_f_telemetry_stamp = false;
+	//Freshness of the message
+	g_orangebot_telemetry_stats.record( type, g_rx_arrival_ns, sample_ns );
+
+	return ((sample_ns >= 0) ? (sample_ns) : (g_rx_arrival_ns)) /1000000.0;
+}	//end function: record_telemetry | int
+
+/***************************************************************************/
+//!	@brief Function
+//!	update_odometry | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//!	Called by the encoder handlers with g_orangebot_platform_mutex held
+//!	Feed all the encoder counts to the odometry and save the pose in the status vars
+/***************************************************************************/
+
+void update_odometry( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	int t;
+	//Copy of the encoder counts
+	int enc_pos[ NUM_ENC ];
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	for (t = 0;t < NUM_ENC;t++)
+	{
+		enc_pos[t] = g_orangebot_platform.enc_pos( t );
+	}
+	//If: pose did not change
+	if (g_orangebot_odometry.update( enc_pos ) == false)
+	{
+		return;
+	}
+	g_orangebot_platform.odom_x() = g_orangebot_odometry.x();
+	g_orangebot_platform.odom_y() = g_orangebot_odometry.y();
+	g_orangebot_platform.odom_heading() = g_orangebot_odometry.heading();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//end function: update_odometry | void
+
 /***************************************************************************/
 //!	@brief Function
 //!	orangebotNodeCppInit | void
@@ -258,7 +631,11 @@ void orangebot_node_cpp_init( void )
 	//Register | Get Signature command
 	f_ret = g_orangebot_motor_board_rx_parser.add_cmd( "F%u", (void *)&get_signature_handler);
 	//Register | Get Timestamp
-	f_ret = g_orangebot_motor_board_rx_parser.add_cmd( "TIME%d", (void *)&get_timestamp_handler);
+	f_ret = g_orangebot_motor_board_rx_parser.add_cmd( "TIME%D:%u", (void *)&get_timestamp_handler);
+		//Clock synchronization reply
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "PONG%D:%D", (void *)&get_pong_handler);
+		//Log message. Sent by the firmware when its TX buffer has room to spare
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "LOG%u:%S:%S", (void *)&get_log_handler);
 
 		//!Encoder Group
 	//Get single absolute encoder reading
@@ -270,13 +647,29 @@ void orangebot_node_cpp_init( void )
 	//Get quad encoder speed reading
 	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "ENC_SPD%S:%S:%S:%S", (void *)&get_four_enc_spd_handler );
 
+		//!Current Group
+	//Get filtered motor currents
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "CUR%U:%U:%U:%U", (void *)&get_current_handler );
+	//Get current limiter and stall detector parameters
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "CUR_LIMIT%U:%U:%U", (void *)&get_current_limit_handler );
+	//Get fault codes of the motor drivers
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "DIAG%u:%u:%u:%u", (void *)&get_diag_handler );
+
+		//! Configuration Group
+	//Get a configuration parameter in use
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "CFG%u:%S", (void *)&get_config_handler );
+	//Get the CRC of the configuration saved in EEPROM
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "CFG_SAVE%U", (void *)&get_config_save_handler );
+
 		//! Control System Target Group
 	//Register | Dual PWM Command
 	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "PWM_DUAL%S:%S", (void *)&get_two_vnh7040_pwm_handler );
 
 		//! Control System Group
 	//Register | Get PWM Slew Rate Limiter Parameters
-	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "PWM_PARAM%S", (void *)&get_pwm_ctrl_handler );
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "PWM_PARAM%u:%S:%S:%S", (void *)&get_pwm_ctrl_handler );
+	//Register | Get Period of the Control System
+	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "TICK%U", (void *)&get_ctrl_tick_handler );
 	//Register | Get Speed PID Parameters
 	f_ret |= g_orangebot_motor_board_rx_parser.add_cmd( "SPD_PARAM%S:%S:%S", (void *)&get_spd_ctrl_handler );
 	//Register | Get Position PID Parameters
@@ -289,6 +682,8 @@ void orangebot_node_cpp_init( void )
 	}
 	//Initialize parser
 	g_orangebot_motor_board_rx_parser.parse('\0');
+	//Publish the initial status
+	g_orangebot_status_snapshot.publish( g_orangebot_platform );
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -302,9 +697,10 @@ void orangebot_node_cpp_init( void )
 //!	@brief
 //!	orangebotParse | std::string
 /***************************************************************************/
-//! @param x |
+//! @param str | string to be parsed. Can hold '\0' terminators
 //! @return void |
 //! @details
+//!	Echo the string on the console, then parse it
 /***************************************************************************/
 
 void orangebot_parse( std::string str )
@@ -329,8 +725,8 @@ void orangebot_parse( std::string str )
 
 	cout << "CPP: Parsing: ";
 
-	//For: all char in the string but the last (an extra \0)
-	for (t = 0;t <= str.length() -1 ;t++)
+	//For: all char in the string
+	for (t = 0;t < str.length();t++)
 	{
 			//NODE:JS
 		//If character is printable
@@ -343,22 +739,77 @@ void orangebot_parse( std::string str )
 			int num = str[t];
 			cout << "(" << num << ")";
 		}
+	} //End for: all cahr in the string
+
+	cout << "\n";
+
+	//Parse the string
+	orangebot_parse( str.c_str(), (int)str.length() );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//end function: orangebotParse | std::string
+
+/***************************************************************************/
+//!	@brief
+//!	orangebot_parse | const char *, int
+/***************************************************************************/
+//! @param data | bytes received from the motor board
+//! @param length | number of bytes
+//! @return void |
+//! @details
+//!	Called by the serial thread for each read. No console echo on this path
+//!	Holds the robot status lock while handlers update the status vars and while publishing the snapshot
+/***************************************************************************/
+
+void orangebot_parse( const char *data, int length )
+{
+	//Trace Enter with arguments
+	DENTER_ARG( "length: %d\n", length );
+
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	int t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Handlers write the status vars
+	std::lock_guard<std::mutex> lock( g_orangebot_platform_mutex );
+	//Messages completed by these bytes arrived now
+	g_rx_arrival_ns = Telemetry_stats::now_ns();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: all bytes
+	for (t = 0;t < length;t++)
+	{
 		//If: there are no signature characters to be processed
 		if (g_signature_remaining_length <= 0)
 		{
-			DPRINT(">%x<\n", str[t]);
+			DPRINT(">%x<\n", data[t]);
 			//Extract char and feed it to the parser
-			g_orangebot_motor_board_rx_parser.parse( str[t] );
+			g_orangebot_motor_board_rx_parser.parse( data[t] );
 		}
 		//If: there is at least a signature character to process
 		else
 		{
 			//Process current data as part of a signature
-			parse_signature( str[t] );
+			parse_signature( data[t] );
 		}
-	} //End for: all cahr in the string
-
-	cout << "\n";
+	} //End for: all bytes
+	//Publish a copy for NODE.JS if anything changed
+	g_orangebot_status_snapshot.publish( g_orangebot_platform );
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -366,7 +817,7 @@ void orangebot_parse( std::string str )
 
 	DRETURN();
 	return;
-}	//end function: orangebotParse | std::string
+}	//end function: orangebot_parse | const char *, int
 
 /***************************************************************************/
 //!	@brief function
@@ -578,18 +1029,19 @@ void get_signature_handler( uint8_t str_length )
 
 /***************************************************************************/
 //!	@brief
-//!	get_timestamp_handler | int32_t
+//!	get_timestamp_handler | uint32_t, uint8_t
 /***************************************************************************/
-//! @param timestamp | int32_t | platform side timestamp
+//! @param timestamp | uint32_t | RTC tick when the firmware sampled the data of the next message
+//! @param sequence | uint8_t | sequence number of the next message
 //! @return void |
 //! @details
-//! Timestamp Handler
+//! Timestamp Handler. The firmware sends it before each telemetry message
 /***************************************************************************/
 
-void get_timestamp_handler( int32_t timestamp )
+void get_timestamp_handler( uint32_t timestamp, uint8_t sequence )
 {
 	//Trace Enter
-	DENTER();
+	DENTER_ARG( "timestamp: %u | sequence: %u\n", timestamp, sequence );
 
 	//----------------------------------------------------------------
 	//	VARS
@@ -602,7 +1054,10 @@ void get_timestamp_handler( int32_t timestamp )
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
-	//! @todo add timestamp on NODE.JS
+	//Stamp the next telemetry message
+	g_orangebot_telemetry_stats.timestamp( timestamp, sequence );
+	g_telemetry_stamp = timestamp;
+	g_f_telemetry_stamp = true;
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -610,7 +1065,76 @@ void get_timestamp_handler( int32_t timestamp )
 
 	DRETURN();
 	return;
-}	//end function:	get_timestamp_handler | int32_t
+}	//end function:	get_timestamp_handler | uint32_t, uint8_t
+
+/***************************************************************************/
+//!	@brief
+//!	get_pong_handler | uint32_t, uint32_t
+/***************************************************************************/
+//! @param token | uint32_t | token of the PING being answered
+//! @param timestamp | uint32_t | RTC tick when the firmware processed the PING
+//! @return void |
+//! @details
+//! Clock synchronization reply. Adds a round trip to the clock mapping
+/***************************************************************************/
+
+void get_pong_handler( uint32_t token, uint32_t timestamp )
+{
+	//Trace Enter
+	DENTER_ARG( "token: %u | timestamp: %u\n", token, timestamp );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Round trip ends when the bytes were received. Unknown tokens and slow replies are discarded
+	g_orangebot_clock_sync.reply( token, timestamp, g_rx_arrival_ns );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//end function:	get_pong_handler | uint32_t, uint32_t
+
+/***************************************************************************/
+//!	@brief
+//!	get_log_handler | uint8_t, int16_t, int16_t
+/***************************************************************************/
+//! @param id | uint8_t | LOG_* id of orangebot_config.h
+//! @param arg0 | int16_t | first argument of the text
+//! @param arg1 | int16_t | second argument of the text
+//! @return void |
+//! @details
+//! Log message of the motor board. Queued for NODE.JS and recorded in the trace
+/***************************************************************************/
+
+void get_log_handler( uint8_t id, int16_t arg0, int16_t arg1 )
+{
+	//Trace Enter
+	DENTER_ARG( "id: %u | arg: %d %d\n", id, arg0, arg1 );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Text is expanded when NODE.JS reads it
+	g_orangebot_firmware_log.push( g_rx_arrival_ns, id, arg0, arg1 );
+	//If: the motor board booted. Its timestamps restarted
+	if (id == LOG_BOOT)
+	{
+		g_orangebot_clock_sync.restart();
+	}
+	DPRINT("firmware log: %u %d %d\n", id, arg0, arg1);
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//end function:	get_log_handler | uint8_t, int16_t, int16_t
 
 /***************************************************************************/
 //!	@brief
@@ -648,6 +1172,10 @@ void get_one_enc_abs_handler( uint8_t index, int32_t enc )
 
 	//Save the encoder reading
 	g_orangebot_platform.enc_pos( index ) = enc;
+	//Integrate the platform pose
+	update_odometry();
+	//Freshness of the message and sampling time of the reading
+	g_orangebot_platform.enc_pos_time( index ) = record_telemetry( TELEMETRY_ENC_ABS );
 
     #ifdef ENABLE_DEBUG
 		enc = g_orangebot_platform.enc_pos( index );
@@ -681,6 +1209,9 @@ void get_four_enc_rel_handler( int16_t enc_rel_a, int16_t enc_rel_b, int16_t enc
 	//	VARS
 	//----------------------------------------------------------------
 
+	//When the counts were sampled [ms]
+	double sample_time;
+
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
@@ -694,6 +1225,14 @@ void get_four_enc_rel_handler( int16_t enc_rel_a, int16_t enc_rel_b, int16_t enc
 	g_orangebot_platform.enc_pos( 1 ) += enc_rel_b;
 	g_orangebot_platform.enc_pos( 2 ) += enc_rel_c;
 	g_orangebot_platform.enc_pos( 3 ) += enc_rel_d;
+	//Integrate the platform pose
+	update_odometry();
+	//Freshness of the message and sampling time of the readings
+	sample_time = record_telemetry( TELEMETRY_ENC_REL );
+	g_orangebot_platform.enc_pos_time( 0 ) = sample_time;
+	g_orangebot_platform.enc_pos_time( 1 ) = sample_time;
+	g_orangebot_platform.enc_pos_time( 2 ) = sample_time;
+	g_orangebot_platform.enc_pos_time( 3 ) = sample_time;
 
 	#ifdef ENABLE_DEBUG
 	int t;
@@ -746,6 +1285,8 @@ void get_four_enc_spd_handler( int16_t enc_spd_a, int16_t enc_spd_b, int16_t enc
 	g_orangebot_platform.enc_spd( 1 ) = enc_spd_b;
 	g_orangebot_platform.enc_spd( 2 ) = enc_spd_c;
 	g_orangebot_platform.enc_spd( 3 ) = enc_spd_d;
+	//Freshness of the message and sampling time of the readings
+	g_orangebot_platform.enc_spd_time() = record_telemetry( TELEMETRY_ENC_SPD );
 
 	#ifdef ENABLE_DEBUG
 	int t;
@@ -805,6 +1346,8 @@ void get_two_enc_spd_handler( int16_t enc_spd_a, int16_t enc_spd_b )
 	{
 		g_orangebot_platform.enc_spd( 1 ) -= 65536;
 	}
+	//Freshness of the message and sampling time of the readings
+	g_orangebot_platform.enc_spd_time() = record_telemetry( TELEMETRY_ENC_SPD );
 
 	#ifdef ENABLE_DEBUG
 	int t;
@@ -825,6 +1368,199 @@ void get_two_enc_spd_handler( int16_t enc_spd_a, int16_t enc_spd_b )
 	return;
 }	//End handler: get_two_enc_spd_handler | int16_t, int16_t
 
+/***************************************************************************/
+//!	@brief handler
+//!	get_current_handler | uint16_t, uint16_t, uint16_t, uint16_t
+/***************************************************************************/
+//! @param cur_* | uint16_t | filtered current of a VNH7040 [ADC counts]
+//! @return void |
+//! @details
+//! Motor current update handler. Firmware always sends four channels
+//!	Convert the counts to mA with CURRENT_UA_PER_CNT of orangebot_config.h
+/***************************************************************************/
+
+void get_current_handler( uint16_t cur_a, uint16_t cur_b, uint16_t cur_c, uint16_t cur_d )
+{
+	//Trace Enter
+	DENTER_ARG("cur: %d | %d | %d | %d\n", cur_a, cur_b, cur_c, cur_d);
+
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	int t;
+	//Currents in message order
+	uint16_t cur[4] = { cur_a, cur_b, cur_c, cur_d };
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each installed driver
+	for (t = 0;t < NUM_VNH7040PWM;t++)
+	{
+		//Save the current [mA]
+		g_orangebot_platform.current( t ) = (int)(((uint64_t)cur[t] *CURRENT_UA_PER_CNT) /1000);
+	}
+	//Freshness of the message and sampling time of the readings
+	g_orangebot_platform.current_time() = record_telemetry( TELEMETRY_CURRENT );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//End handler: get_current_handler | uint16_t, uint16_t, uint16_t, uint16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_current_limit_handler | uint16_t, uint16_t, uint16_t
+/***************************************************************************/
+//! @param limit_ma | uint16_t | current limit [mA]
+//! @param stall_ma | uint16_t | stall current [mA]
+//! @param stall_ticks | uint16_t | stall duration [control ticks]
+//! @return void |
+//! @details
+//! Firmware answers CUR_LIMIT with the parameters in use
+/***************************************************************************/
+
+void get_current_limit_handler( uint16_t limit_ma, uint16_t stall_ma, uint16_t stall_ticks )
+{
+	//Trace Enter
+	DENTER_ARG("limit: %d | stall: %d | ticks: %d\n", limit_ma, stall_ma, stall_ticks);
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Save current limiter parameters
+	g_orangebot_platform.current_limit() = limit_ma;
+	g_orangebot_platform.stall_current() = stall_ma;
+	g_orangebot_platform.stall_ticks() = stall_ticks;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//End handler: get_current_limit_handler | uint16_t, uint16_t, uint16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_diag_handler | uint8_t, uint8_t, uint8_t, uint8_t
+/***************************************************************************/
+//! @param diag_* | uint8_t | fault code of a VNH7040. DIAG_* bit field
+//! @return void |
+//! @details
+//! Firmware always sends four channels
+/***************************************************************************/
+
+void get_diag_handler( uint8_t diag_a, uint8_t diag_b, uint8_t diag_c, uint8_t diag_d )
+{
+	//Trace Enter
+	DENTER_ARG("diag: 0x%02x | 0x%02x | 0x%02x | 0x%02x\n", diag_a, diag_b, diag_c, diag_d);
+
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	int t;
+	//Codes in message order
+	uint8_t diag[4] = { diag_a, diag_b, diag_c, diag_d };
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each installed driver
+	for (t = 0;t < NUM_VNH7040PWM;t++)
+	{
+		//If: a fault appeared
+		if (((diag[t] & ~g_orangebot_platform.diag( t )) & (DIAG_FAULT | DIAG_OVERTEMP | DIAG_VCC)) != 0)
+		{
+			DPRINT("ERR: driver %d | fault code: 0x%02x\n", t, diag[t]);
+		}
+		g_orangebot_platform.diag( t ) = diag[t];
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//End handler: get_diag_handler | uint8_t, uint8_t, uint8_t, uint8_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_config_handler | uint8_t, int16_t
+/***************************************************************************/
+//! @param id | uint8_t | CFG_* id of orangebot_config.h
+//! @param value | int16_t | value in use on the board
+//! @return void |
+//! @details
+//! Answer to both CFG_GET and CFG_SET
+/***************************************************************************/
+
+void get_config_handler( uint8_t id, int16_t value )
+{
+	//Trace Enter
+	DENTER_ARG("id: %d | value: %d\n", id, value);
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//If: firmware knows more parameters than the RPI
+	if (id >= CFG_NUM_ID)
+	{
+		DPRINT("ERR: unknown config id: %d\n", id);
+		DRETURN();
+		return;
+	}
+	g_orangebot_platform.config( id ) = value;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//End handler: get_config_handler | uint8_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_config_save_handler | uint16_t
+/***************************************************************************/
+//! @param crc | uint16_t | CRC16 of the record written in EEPROM
+//! @return void |
+//! @details
+//! Board sends it once the EEPROM write of CFG_SAVE completes
+/***************************************************************************/
+
+void get_config_save_handler( uint16_t crc )
+{
+	//Trace Enter
+	DENTER_ARG("crc: 0x%04x\n", crc);
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	g_orangebot_platform.config_crc() = crc;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//End handler: get_config_save_handler | uint16_t
+
 /***************************************************************************/
 //!	@brief
 //!	get_vnh7040_pwm_handler | int16_t | int16_t
@@ -879,18 +1615,21 @@ void get_two_vnh7040_pwm_handler( int16_t pwm_a, int16_t pwm_b )
 
 /***************************************************************************/
 //!	@brief
-//!	get_pwm_ctrl_handler | int16_t
+//!	get_pwm_ctrl_handler | uint8_t, int16_t, int16_t, int16_t
 /***************************************************************************/
-//! @param slew_rate | int16_t | platform PWM slew rate settings
+//! @param index | uint8_t | PWM channel
+//! @param max | int16_t | PWM limit of the channel
+//! @param accel | int16_t | maximum PWM change per control tick moving away from zero
+//! @param decel | int16_t | maximum PWM change per control tick moving toward zero
 //! @return void |
 //! @details
-//! PWM slew rate limiter handler
+//! PWM slew rate limiter handler. Board answers with the parameters in use after a PWM_PARAM command
 /***************************************************************************/
 
-void get_pwm_ctrl_handler( int16_t slew_rate )
+void get_pwm_ctrl_handler( uint8_t index, int16_t max, int16_t accel, int16_t decel )
 {
 	//Trace Enter
-	DENTER_ARG("OrangeBot pwm slew rate: %d\n", slew_rate);
+	DENTER_ARG("index: %d | max: %d | accel: %d | decel: %d\n", index, max, accel, decel);
 
 	//----------------------------------------------------------------
 	//	VARS
@@ -900,17 +1639,60 @@ void get_pwm_ctrl_handler( int16_t slew_rate )
 	//	INIT
 	//----------------------------------------------------------------
 
+	//If: bad number of channels
+	if (index >= NUM_VNH7040PWM)
+	{
+		DRETURN_ARG("ERR: bad number of channel: %d\n", index);
+		return; //FAIL
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Save slew rate limiter parameters
+	g_orangebot_platform.pwm_max( index ) = max;
+	g_orangebot_platform.pwm_accel( index ) = accel;
+	g_orangebot_platform.pwm_decel( index ) = decel;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	DRETURN();
+	return;
+}	//end function:	get_pwm_ctrl_handler | uint8_t, int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief
+//!	get_ctrl_tick_handler | uint16_t
+/***************************************************************************/
+//! @param period_us | uint16_t | period of the control system [us]
+//! @return void |
+//! @details
+//! Board answers a TICK command with the period in use
+//!	Encoder speed and the tick counts of the board scale with it
+/***************************************************************************/
+
+void get_ctrl_tick_handler( uint16_t period_us )
+{
+	//Trace Enter
+	DENTER_ARG("period: %d us\n", period_us);
+
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
+	//Save the period of the control system
+	g_orangebot_platform.ctrl_tick_us() = period_us;
+
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 
 	DRETURN();
 	return;
-}	//end function:	get_pwm_ctrl_handler | int16_t
+}	//end function:	get_ctrl_tick_handler | uint16_t
 
 /***************************************************************************/
 //!	@brief
@@ -1,3 +1,9 @@
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <string>
+
 /****************************************************************************
 **	DEFINES
 ****************************************************************************/
@@ -9,6 +15,13 @@
 namespace Orangebot
 {
 
+//Defined in status_snapshot.h
+class Status_snapshot;
+//Defined in telemetry_stats.h
+class Telemetry_stats;
+//Defined in clock_sync.h
+class Clock_sync;
+
 /****************************************************************************
 **	GLOBAL VARIABLE PROTOTYPES
 ****************************************************************************/
@@ -21,5 +34,27 @@ namespace Orangebot
 void orangebot_node_cpp_init( void );
 //Parse string char by char
 void orangebot_parse( std::string str );
+//Parse a buffer of bytes. No echo, meant for the serial thread
+void orangebot_parse( const char *data, int length );
+//Lock free copies of the robot status for NODE.JS
+Status_snapshot &get_status_snapshot( void );
+//Odometry pose back to the origin
+void odometry_reset( void );
+//Odometry geometry. Encoder counts per mm and track width [mm]. false = OK
+bool odometry_config( double cnt_per_mm, double track_mm );
+//Copy of the telemetry latency statistics
+void get_telemetry_stats( Telemetry_stats &stats );
+//Clear the telemetry latency statistics
+void telemetry_stats_reset( void );
+//Build the next clock synchronization PING. Return the bytes to send. -1 = FAIL
+int clock_sync_request( char *msg, int size );
+//Consistent copy of the clock synchronization
+void get_clock_sync( Clock_sync &sync );
+//Baud rate of the serial link, to remove the UART time from the round trips. false = OK
+bool clock_sync_set_baud( int baud );
+//Oldest undelivered log message of the motor board. Arrival [ms] and text. false = OK | true = none
+bool firmware_log_pop( double &time_ms, std::string &text );
+//Log messages of the motor board overwritten before NODE.JS read them
+uint32_t firmware_log_lost( void );
 
 } //End namespace: Orangebot
@@ -0,0 +1,402 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Odometry
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Differential drive odometry from the encoder counts
+**	Default counts per mm come from the README geometry:
+**	6300 cnt per turn, 127mm wheel -> 6300 / (pi * 127) = 15.79 cnt/mm
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cmath>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_OTHER
+#include "debug.h"
+//Platform configuration. NUM_ENC, LAYOUT_ENC_*
+#include "../../orangebot_config.h"
+//Class Header
+#include "odometry.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Index of the sides
+#define ODOMETRY_LEFT		0
+#define ODOMETRY_RIGHT		1
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Odometry | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Odometry::Odometry( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Setter
+//!	set_geometry | double, double
+/***************************************************************************/
+//! @param cnt_per_mm | encoder counts per mm of wheel travel
+//! @param track_mm | distance between left and right wheels [mm]
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//!	Accumulated counts and pose are kept. The heading is rebased on the current pose
+//!	Motion from now on is computed with the new geometry, the heading does not jump
+/***************************************************************************/
+
+bool Odometry::set_geometry( double cnt_per_mm, double track_mm )
+{
+	//Trace Enter
+	DENTER_ARG( "cnt_per_mm: %f | track_mm: %f\n", cnt_per_mm, track_mm );
+
+	//If: bad geometry
+	if ((cnt_per_mm <= 0.0) || (track_mm <= 0.0))
+	{
+		DRETURN_ARG("ERR: bad geometry\n");
+		return true;	//FAIL
+	}
+	//Rebase the heading. Counts up to here keep the heading of the old geometry
+	this -> g_cnt_base[ODOMETRY_LEFT] = this -> g_cnt[ODOMETRY_LEFT];
+	this -> g_cnt_base[ODOMETRY_RIGHT] = this -> g_cnt[ODOMETRY_RIGHT];
+	this -> g_heading_base = this -> g_heading;
+	this -> g_cnt_per_mm = cnt_per_mm;
+	this -> g_track_mm = track_mm;
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end setter: set_geometry | double, double
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	x | void
+/***************************************************************************/
+//! @return double | x position [mm]
+/***************************************************************************/
+
+double Odometry::x( void )
+{
+	return this -> g_x;
+}	//end getter: x | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	y | void
+/***************************************************************************/
+//! @return double | y position [mm]
+/***************************************************************************/
+
+double Odometry::y( void )
+{
+	return this -> g_y;
+}	//end getter: y | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	heading | void
+/***************************************************************************/
+//! @return double | heading [rad]
+/***************************************************************************/
+
+double Odometry::heading( void )
+{
+	return this -> g_heading;
+}	//end getter: heading | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	cnt | int
+/***************************************************************************/
+//! @param side | 0 = left | 1 = right
+//! @return int64_t | accumulated counts of the side. 0 for a bad side
+/***************************************************************************/
+
+int64_t Odometry::cnt( int side )
+{
+	//If: bad side
+	if ((side < ODOMETRY_LEFT) || (side > ODOMETRY_RIGHT))
+	{
+		return 0;	//FAIL
+	}
+	return this -> g_cnt[ side ];
+}	//end getter: cnt | int
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Pose and accumulated counts back to zero. Geometry is kept
+/***************************************************************************/
+
+void Odometry::reset( void )
+{
+	//Trace Enter
+	DENTER();
+
+	this -> g_f_init = false;
+	this -> g_cnt[ODOMETRY_LEFT] = 0;
+	this -> g_cnt[ODOMETRY_RIGHT] = 0;
+	this -> g_cnt_base[ODOMETRY_LEFT] = 0;
+	this -> g_cnt_base[ODOMETRY_RIGHT] = 0;
+	this -> g_heading_base = 0.0;
+	this -> g_x = 0.0;
+	this -> g_y = 0.0;
+	this -> g_heading = 0.0;
+
+	//Trace Return
+	DRETURN();
+	return;	//OK
+}	//end method: reset | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	update | const int *
+/***************************************************************************/
+//! @param enc_pos | absolute counts of the NUM_ENC encoder channels
+//! @return bool | true = pose changed
+//!	@details
+//!	Algorithm:
+//!	>Difference with the last counts. Computed modulo 2^32 so a wrapping counter is handled
+//!	>Accumulate the differences of each side as integer, with the sign of the layout
+//!	>Distance of each side is the average of its encoders
+//!	>Heading from the accumulated counts. Exact, no integration
+//!	>Integrate the position along the heading at the middle of the step
+/***************************************************************************/
+
+bool Odometry::update( const int *enc_pos )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Counter
+	int t;
+	//Side of the encoder
+	int side;
+	//Count change of one encoder
+	int32_t delta;
+	//Count change of each side in this step
+	int64_t delta_side[2] = { 0, 0 };
+	//Distance travelled by the center of the platform in this step [mm]
+	double distance;
+	//Heading before the step
+	double heading_old;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: first counts since reset
+	if (this -> g_f_init == false)
+	{
+		//Record counts, no motion
+		for (t = 0;t < NUM_ENC;t++)
+		{
+			this -> g_enc_last[t] = enc_pos[t];
+		}
+		this -> g_f_init = true;
+		DRETURN_ARG("init\n");
+		return false;	//OK
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each encoder
+	for (t = 0;t < NUM_ENC;t++)
+	{
+		//Change since last update. Unsigned difference survives the counter wrapping
+		delta = (int32_t)((uint32_t)enc_pos[t] -(uint32_t)this -> g_enc_last[t]);
+		this -> g_enc_last[t] = enc_pos[t];
+		//Forward is positive
+		if ((LAYOUT_ENC_REVERSE & (1 << t)) != 0)
+		{
+			delta = -delta;
+		}
+		side = ((LAYOUT_ENC_RIGHT & (1 << t)) != 0) ? (ODOMETRY_RIGHT) : (ODOMETRY_LEFT);
+		delta_side[ side ] += delta;
+	}
+	//If: no motion
+	if ((delta_side[ODOMETRY_LEFT] == 0) && (delta_side[ODOMETRY_RIGHT] == 0))
+	{
+		DRETURN();
+		return false;	//OK
+	}
+	//Accumulate exactly
+	this -> g_cnt[ODOMETRY_LEFT] += delta_side[ODOMETRY_LEFT];
+	this -> g_cnt[ODOMETRY_RIGHT] += delta_side[ODOMETRY_RIGHT];
+	//Distance of the center. Average of the sides, each side average of its encoders
+	distance = 0.5 *((double)delta_side[ODOMETRY_LEFT] /this -> g_num_enc_side[ODOMETRY_LEFT] +(double)delta_side[ODOMETRY_RIGHT] /this -> g_num_enc_side[ODOMETRY_RIGHT]) /this -> g_cnt_per_mm;
+	//New heading from the total counts
+	heading_old = this -> g_heading;
+	this -> g_heading = this -> compute_heading();
+	//Integrate along the middle heading
+	this -> g_x += distance *cos( 0.5 *(heading_old +this -> g_heading) );
+	this -> g_y += distance *sin( 0.5 *(heading_old +this -> g_heading) );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN_ARG("x: %f | y: %f | heading: %f\n", this -> g_x, this -> g_y, this -> g_heading);
+	return true;	//OK
+}	//end method: update | const int *
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables. Geometry from orangebot_config.h and ODOMETRY_TRACK_UM
+/***************************************************************************/
+
+void Odometry::init( void )
+{
+	//Counter
+	int t;
+
+	//Count encoders of each side
+	this -> g_num_enc_side[ODOMETRY_LEFT] = 0;
+	this -> g_num_enc_side[ODOMETRY_RIGHT] = 0;
+	for (t = 0;t < NUM_ENC;t++)
+	{
+		this -> g_num_enc_side[ ((LAYOUT_ENC_RIGHT & (1 << t)) != 0) ? (ODOMETRY_RIGHT) : (ODOMETRY_LEFT) ]++;
+	}
+	//Default geometry
+	this -> g_cnt_per_mm = ENC_CNT_PER_TURN /(M_PI *WHEEL_DIAMETER_UM /1000.0);
+	this -> g_track_mm = ODOMETRY_TRACK_UM /1000.0;
+	//Pose at zero
+	this -> reset();
+
+	return;	//OK
+}	//end method: init | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	compute_heading | void
+/***************************************************************************/
+//! @return double | heading [rad]
+//!	@details
+//!	Heading at the last geometry change +(right distance -left distance) /track
+//!	Computed from the integer totals, so rounding does not accumulate step after step
+/***************************************************************************/
+
+double Odometry::compute_heading( void )
+{
+	//Distance of each side since the last geometry change [mm]
+	double left = (double)(this -> g_cnt[ODOMETRY_LEFT] -this -> g_cnt_base[ODOMETRY_LEFT]) /this -> g_num_enc_side[ODOMETRY_LEFT] /this -> g_cnt_per_mm;
+	double right = (double)(this -> g_cnt[ODOMETRY_RIGHT] -this -> g_cnt_base[ODOMETRY_RIGHT]) /this -> g_num_enc_side[ODOMETRY_RIGHT] /this -> g_cnt_per_mm;
+
+	return this -> g_heading_base +(right -left) /this -> g_track_mm;
+}	//end method: compute_heading | void
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
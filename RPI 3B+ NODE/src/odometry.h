@@ -0,0 +1,187 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef ODOMETRY_H_
+	#define ODOMETRY_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+//Requires orangebot_config.h (through panopticon.h) to be included before. NUM_ENC, LAYOUT_ENC_*
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Distance between the left and right wheel contact points [um]. Default until set_geometry is called
+#define ODOMETRY_TRACK_UM			250000
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Odometry
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Differential drive pose from the encoder counts
+//! @details
+//!	Fed with the absolute encoder counts after each encoder message \n
+//!	Encoder changes are accumulated per side as 64 bit integer counts. Nothing is lost to rounding \n
+//!	Heading is computed from the integer counts each time, it does not drift over long runs \n
+//!	Position integrates the distance along the heading at the middle of each step \n
+//!	Side of each encoder and counting direction come from LAYOUT_ENC_RIGHT and LAYOUT_ENC_REVERSE
+//! @bug		None
+//! @warning	Track width is a default until measured on the platform
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Odometry
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Odometry( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set encoder counts per mm of wheel travel and track width [mm]. false = OK
+		bool set_geometry( double cnt_per_mm, double track_mm );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Position [mm] in the frame of the reset pose. x is forward at reset
+		double x( void );
+		double y( void );
+		//Heading [rad], counter clockwise positive. Not wrapped, counts full turns
+		double heading( void );
+		//Accumulated counts of a side, summed over the encoders of that side. 0 = left, 1 = right
+		int64_t cnt( int side );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Pose back to zero. The next update only records the encoder counts
+		void reset( void );
+		//Feed the absolute counts of all the encoder channels. true = pose changed
+		bool update( const int *enc_pos );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+		//Heading [rad] from the accumulated counts
+		double compute_heading( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Encoder counts have been recorded at least once since reset
+		bool g_f_init;
+		//Last absolute count of each encoder
+		int g_enc_last[ NUM_ENC ];
+		//Number of encoders of each side. 0 = left, 1 = right
+		int g_num_enc_side[2];
+		//Accumulated counts of each side. Forward positive
+		int64_t g_cnt[2];
+		//Counts and heading when the geometry last changed. Heading is computed from there on
+		int64_t g_cnt_base[2];
+		double g_heading_base;
+		//Encoder counts per mm of wheel travel
+		double g_cnt_per_mm;
+		//Track width [mm]
+		double g_track_mm;
+		//Pose
+		double g_x;
+		double g_y;
+		double g_heading;
+
+};	//End Class: Odometry
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -16,6 +16,10 @@
 **
 **		OrangeBot Motor Board -> RPI 3B+ message decoding
 **	Decode messages coming from the motor board
+**
+**		Serial thread
+**	The module owns the serial port on a dedicated thread
+**	Received bytes are parsed on that thread, JS is notified through a thread safe function
 ****************************************************************/
 
 /****************************************************************************
@@ -23,12 +27,41 @@
 ****************************************************************************/
 
 #include <iostream>
+#include <atomic>
+#include <chrono>
 //NODE bindings
 #include <napi.h>
 //C++ implementation of high performance methods
 #include "ob.h"
 ////Stores robot status variables
 #include "panopticon.h"
+//Serial port owned by a dedicated thread
+#include "serial_thread.h"
+//Lock free copies of the robot status variables
+#include "status_snapshot.h"
+//Latency and inter arrival of the telemetry
+#include "telemetry_stats.h"
+//Clock synchronization with the motor board
+#include "clock_sync.h"
+//Record and replay of the serial traffic
+#include "session_log.h"
+#include "session_replay.h"
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_BINDINGS
+#include "debug.h"
+//Binary trace rings. Already included by debug.h with ENABLE_TRACE
+#ifndef TRACE_H_
+	#include "trace.h"
+#endif
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Default minimum time between two status events sent to JS. 100Hz
+#define SERIAL_EVENT_PERIOD_US		10000
 
 /****************************************************************************
 **	NAMESPACE
@@ -43,6 +76,33 @@ using std::cout;
 //Stores the robot staus variabiles
 extern Orangebot::Panopticon g_orangebot_platform;
 
+/****************************************************************************
+**	GLOBAL VARS
+****************************************************************************/
+
+//Serial port to the motor board
+Orangebot::Serial_thread g_serial_thread;
+//Recorder of the bytes exchanged with the motor board
+Orangebot::Session_log g_session_log;
+//Stand in for the serial thread that feeds a recorded session
+Orangebot::Session_replay g_session_replay;
+//JS callback that receives the robot status after the serial thread parsed new data
+Napi::ThreadSafeFunction g_serial_tsfn;
+//The thread safe function is acquired and has to be released by serial_close. Shared by the serial port and the replay
+bool g_f_serial_tsfn = false;
+//A call to the JS callback is queued and not yet executed. Coalesce the notifications
+std::atomic<bool> g_f_serial_update_pending( false );
+//Minimum time between two status events. 0 = an event for every completed message
+std::atomic<int> g_serial_event_period_us( SERIAL_EVENT_PERIOD_US );
+//Serial thread only. Status changed and JS has not been told yet
+bool g_f_serial_event_dirty = false;
+//Serial thread only. When the last status event was sent
+std::chrono::steady_clock::time_point g_serial_event_last;
+//Addon owned memory behind the status Int32Array. Layout STATUS_ARRAY_*
+int32_t g_status_array[ STATUS_ARRAY_SIZE ];
+//The status Int32Array is created once and handed to JS again on each call
+Napi::ObjectReference g_status_array_ref;
+
 /****************************************************************************
 **	FUNCTION PROTOTYPES
 ****************************************************************************/
@@ -56,6 +116,62 @@ extern Napi::Object init(Napi::Env env, Napi::Object exports);
 extern Napi::Number parse_wrap( const Napi::CallbackInfo& info );
 //Return a C++ object with all the robot status variables
 extern Napi::Object get_status_wrap( const Napi::CallbackInfo& info );
+//Construct the JS object with all the robot status variables
+extern Napi::Object construct_status( Napi::Env env );
+//Return the generation of the latest robot status
+extern Napi::Value get_generation_wrap( const Napi::CallbackInfo& info );
+//Return the persistent Int32Array with the numeric robot status
+extern Napi::Value get_status_array_wrap( const Napi::CallbackInfo& info );
+//Return the index of each field inside the status Int32Array
+extern Napi::Value get_status_layout_wrap( const Napi::CallbackInfo& info );
+//Return the robot status serialized in a binary frame
+extern Napi::Value get_status_frame_wrap( const Napi::CallbackInfo& info );
+//Refresh the status Int32Array in place and return it
+extern Napi::Int32Array get_status_array( Napi::Env env );
+//Return true if the robot status changed since a given generation
+extern Napi::Value changed_since_wrap( const Napi::CallbackInfo& info );
+//Open the serial port and start the serial thread
+extern Napi::Value serial_open_wrap( const Napi::CallbackInfo& info );
+//Send a message through the serial port
+extern Napi::Value serial_write_wrap( const Napi::CallbackInfo& info );
+//Stop the serial thread and close the serial port
+extern Napi::Value serial_close_wrap( const Napi::CallbackInfo& info );
+//Set the maximum rate of status events
+extern Napi::Value set_event_rate_wrap( const Napi::CallbackInfo& info );
+//Reset the odometry pose to the origin
+extern Napi::Value odometry_reset_wrap( const Napi::CallbackInfo& info );
+//Set the odometry geometry
+extern Napi::Value odometry_config_wrap( const Napi::CallbackInfo& info );
+//Return the telemetry latency and inter arrival statistics
+extern Napi::Value get_stats_wrap( const Napi::CallbackInfo& info );
+//Clear the telemetry statistics
+extern Napi::Value reset_stats_wrap( const Napi::CallbackInfo& info );
+//Send a clock synchronization ping to the motor board
+extern Napi::Value serial_sync_wrap( const Napi::CallbackInfo& info );
+//Start recording the serial traffic to a file
+extern Napi::Value session_log_open_wrap( const Napi::CallbackInfo& info );
+//Stop recording the serial traffic
+extern Napi::Value session_log_close_wrap( const Napi::CallbackInfo& info );
+//Feed a recorded session to the parser instead of the serial port
+extern Napi::Value session_replay_wrap( const Napi::CallbackInfo& info );
+//Progress and parser time of the replay
+extern Napi::Value session_replay_stats_wrap( const Napi::CallbackInfo& info );
+//Write the trace rings to a file
+extern Napi::Value trace_dump_wrap( const Napi::CallbackInfo& info );
+//Log messages of the motor board
+extern Napi::Value firmware_log_wrap( const Napi::CallbackInfo& info );
+//Set the trace level of a module
+extern Napi::Value trace_set_level_wrap( const Napi::CallbackInfo& info );
+//Trace level of each module
+extern Napi::Value trace_get_levels_wrap( const Napi::CallbackInfo& info );
+//Construct the JS object with the statistics of one sample series
+extern Napi::Object construct_series( Napi::Env env, uint32_t count, int64_t min_us, int64_t max_us, int64_t sum_us, const uint32_t *hist );
+//Executed by the serial thread with the received bytes
+extern int serial_rx_handler( const char *data, int length );
+//Executed by the NODE.JS thread when the serial thread has new data
+extern void serial_update_js( Napi::Env env, Napi::Function callback );
+//Executed by the NODE.JS thread when the serial port hung up
+extern void serial_hangup_js( Napi::Env env, Napi::Function callback );
 //Prototypes to be declard inside the Orangebot namespace
 namespace Orangebot
 {
@@ -114,6 +230,28 @@ Napi::Object init(Napi::Env env, Napi::Object exports)
 	//Register methods accessible from the outside in the NODE.JS environment
 	exports.Set( "parse", Napi::Function::New(env, parse_wrap) );
 	exports.Set( "get_status", Napi::Function::New(env, get_status_wrap) );
+	exports.Set( "get_generation", Napi::Function::New(env, get_generation_wrap) );
+	exports.Set( "get_status_array", Napi::Function::New(env, get_status_array_wrap) );
+	exports.Set( "get_status_layout", Napi::Function::New(env, get_status_layout_wrap) );
+	exports.Set( "get_status_frame", Napi::Function::New(env, get_status_frame_wrap) );
+	exports.Set( "changed_since", Napi::Function::New(env, changed_since_wrap) );
+	exports.Set( "serial_open", Napi::Function::New(env, serial_open_wrap) );
+	exports.Set( "serial_write", Napi::Function::New(env, serial_write_wrap) );
+	exports.Set( "serial_close", Napi::Function::New(env, serial_close_wrap) );
+	exports.Set( "set_event_rate", Napi::Function::New(env, set_event_rate_wrap) );
+	exports.Set( "odometry_reset", Napi::Function::New(env, odometry_reset_wrap) );
+	exports.Set( "odometry_config", Napi::Function::New(env, odometry_config_wrap) );
+	exports.Set( "get_stats", Napi::Function::New(env, get_stats_wrap) );
+	exports.Set( "reset_stats", Napi::Function::New(env, reset_stats_wrap) );
+	exports.Set( "serial_sync", Napi::Function::New(env, serial_sync_wrap) );
+	exports.Set( "session_log_open", Napi::Function::New(env, session_log_open_wrap) );
+	exports.Set( "session_log_close", Napi::Function::New(env, session_log_close_wrap) );
+	exports.Set( "session_replay", Napi::Function::New(env, session_replay_wrap) );
+	exports.Set( "session_replay_stats", Napi::Function::New(env, session_replay_stats_wrap) );
+	exports.Set( "firmware_log", Napi::Function::New(env, firmware_log_wrap) );
+	exports.Set( "trace_dump", Napi::Function::New(env, trace_dump_wrap) );
+	exports.Set( "trace_set_level", Napi::Function::New(env, trace_set_level_wrap) );
+	exports.Set( "trace_get_levels", Napi::Function::New(env, trace_get_levels_wrap) );
 
     return exports;
 }	//End function: Init | Napi::Env | Napi::Object
@@ -164,22 +302,920 @@ Napi::Object get_status_wrap( const Napi::CallbackInfo& info )
 	{
 		Napi::TypeError::New(env, "ERR: Expecting no arguments").ThrowAsJavaScriptException();
 	}
+	//Return a NODE.JS Object
+	return construct_status( env );
+}	//End Function: get_status_wrap | Napi::CallbackInfo&
 
-	//Get reference to robot status vars
-	Orangebot::Panopticon &robot_status = Orangebot::get_robot_status();
+/****************************************************************************
+**	@brief Function
+**	construct_status | Napi::Env
+****************************************************************************/
+//! @param env | NODE.JS environment
+//! @return Napi::Object |
+//! @details
+//! Construct a JS object with all the robot status variables
+//!	Read from the latest published snapshot. No lock, the serial thread may be parsing meanwhile
+/***************************************************************************/
+
+Napi::Object construct_status( Napi::Env env )
+{
+	//Get consistent copy of robot status vars
+	const Orangebot::Panopticon_snapshot &robot_status = Orangebot::get_status_snapshot().read();
 	//Construct empty return object in the NODE.JS environment
 	Napi::Object ret_tmp = Napi::Object::New( env );
 		//!Manually create and fill the fields of the return object
+	//Snapshot generation
+	ret_tmp.Set("generation", Napi::Number::New( env, robot_status.generation ) );
 	//Platform Firmware Signature
-	ret_tmp.Set("signature", (Napi::String)Napi::String::New( env, (std::string)robot_status.signature() ) );
+	ret_tmp.Set("signature", (Napi::String)Napi::String::New( env, robot_status.signature ) );
 	//Platform PWM setting
-	ret_tmp.Set("pwm", (Napi::Array)construct_array<int>( env, (int *)&robot_status.pwm( 0 ), NUM_VNH7040PWM) );
+	ret_tmp.Set("pwm", (Napi::Array)construct_array<const int>( env, robot_status.pwm, NUM_VNH7040PWM) );
 	//Encoder absolute position
-	ret_tmp.Set("enc_pos", (Napi::Array)construct_array<int>( env, (int *)&robot_status.enc_pos( 0 ), NUM_ENC) );
+	ret_tmp.Set("enc_pos", (Napi::Array)construct_array<const int>( env, robot_status.enc_pos, NUM_ENC) );
 	//Encoder speed
-	ret_tmp.Set("enc_spd", (Napi::Array)construct_array<int>( env, (int *)&robot_status.enc_spd( 0 ), NUM_ENC) );
+	ret_tmp.Set("enc_spd", (Napi::Array)construct_array<const int>( env, robot_status.enc_spd, NUM_ENC) );
+	//When the encoder readings were sampled. RPI CLOCK_MONOTONIC [ms]
+	ret_tmp.Set("enc_pos_time", (Napi::Array)construct_array<const double>( env, robot_status.enc_pos_time, NUM_ENC) );
+	ret_tmp.Set("enc_spd_time", Napi::Number::New( env, robot_status.enc_spd_time ) );
+	//PWM slew rate limiter parameters
+	ret_tmp.Set("pwm_max", (Napi::Array)construct_array<const int>( env, robot_status.pwm_max, NUM_VNH7040PWM) );
+	ret_tmp.Set("pwm_accel", (Napi::Array)construct_array<const int>( env, robot_status.pwm_accel, NUM_VNH7040PWM) );
+	ret_tmp.Set("pwm_decel", (Napi::Array)construct_array<const int>( env, robot_status.pwm_decel, NUM_VNH7040PWM) );
+	//Filtered motor current [mA] and when it was sampled
+	ret_tmp.Set("current", (Napi::Array)construct_array<const int>( env, robot_status.current, NUM_VNH7040PWM) );
+	ret_tmp.Set("current_time", Napi::Number::New( env, robot_status.current_time ) );
+	//Current limiter and stall detector parameters. [mA], [mA], [control ticks]
+	ret_tmp.Set("current_limit", Napi::Number::New( env, robot_status.current_limit ) );
+	ret_tmp.Set("stall_current", Napi::Number::New( env, robot_status.stall_current ) );
+	ret_tmp.Set("stall_ticks", Napi::Number::New( env, robot_status.stall_ticks ) );
+	//Period of the control system [us]. Encoder speed is counts per period
+	ret_tmp.Set("ctrl_tick_us", Napi::Number::New( env, robot_status.ctrl_tick_us ) );
+	//Fault code of the motor drivers. DIAG_* bit field
+	ret_tmp.Set("diag", (Napi::Array)construct_array<const int>( env, robot_status.diag, NUM_VNH7040PWM) );
+	//Configuration parameters of the board by CFG_* id and CRC16 of the last save. -1 = none
+	ret_tmp.Set("config", (Napi::Array)construct_array<const int>( env, robot_status.config, CFG_NUM_ID) );
+	ret_tmp.Set("config_crc", Napi::Number::New( env, robot_status.config_crc ) );
+	//Odometry pose. x, y [mm], heading [rad]
+	Napi::Object odometry = Napi::Object::New( env );
+	odometry.Set("x", Napi::Number::New( env, robot_status.odom_x ) );
+	odometry.Set("y", Napi::Number::New( env, robot_status.odom_y ) );
+	odometry.Set("heading", Napi::Number::New( env, robot_status.odom_heading ) );
+	ret_tmp.Set("odometry", odometry );
 	//Return a NODE.JS Object
 	return (Napi::Object)ret_tmp;
-}	//End Function: get_status_wrap | Napi::CallbackInfo&
+}	//End Function: construct_status | Napi::Env
+
+/****************************************************************************
+**	@brief Function
+**	get_status_array | Napi::Env
+****************************************************************************/
+//! @param env | NODE.JS environment
+//! @return Napi::Int32Array | status array
+//! @details
+//!	The Int32Array is backed by g_status_array through an external ArrayBuffer
+//!	It is created on the first call and returned again on the following ones
+//!	Contents are refreshed in place on the NODE.JS thread when the generation changed
+//!	JS can keep the array and index it with get_status_layout. No allocation, no copy on the JS side
+/***************************************************************************/
+
+Napi::Int32Array get_status_array( Napi::Env env )
+{
+	//If: first call
+	if (g_status_array_ref.IsEmpty() == true)
+	{
+		//Fill before handing to JS
+		Orangebot::Status_snapshot::to_array( Orangebot::get_status_snapshot().read(), g_status_array );
+		//Memory is static, nothing to free when JS drops the buffer
+		Napi::ArrayBuffer buf = Napi::ArrayBuffer::New( env, (void *)g_status_array, sizeof(g_status_array) );
+		Napi::Int32Array array = Napi::Int32Array::New( env, STATUS_ARRAY_SIZE, buf, 0 );
+		//Keep the array alive for the life of the module
+		g_status_array_ref = Napi::Persistent( (Napi::Object)array );
+		g_status_array_ref.SuppressDestruct();
+	}
+	//Else If: published status is newer than the array
+	else if ((uint32_t)g_status_array[STATUS_ARRAY_GENERATION] != Orangebot::get_status_snapshot().generation())
+	{
+		//Refresh in place
+		Orangebot::Status_snapshot::to_array( Orangebot::get_status_snapshot().read(), g_status_array );
+	}
+
+	return g_status_array_ref.Value().As<Napi::Int32Array>();
+}	//End Function: get_status_array | Napi::Env
+
+/****************************************************************************
+**	@brief Function
+**	get_status_array_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @return Napi::Int32Array | status array, refreshed
+//! @details
+//!	Always the same Int32Array object. Index it with get_status_layout
+/***************************************************************************/
+
+Napi::Value get_status_array_wrap( const Napi::CallbackInfo& info )
+{
+	return get_status_array( info.Env() );
+}	//End Function: get_status_array_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	get_status_layout_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @return Napi::Object | index of the first element of each field and number of channels
+//! @details
+//!	Meant to be called once at start up
+/***************************************************************************/
+
+Napi::Value get_status_layout_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Construct layout object
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	ret_tmp.Set("generation", Napi::Number::New( env, STATUS_ARRAY_GENERATION ) );
+	ret_tmp.Set("pwm", Napi::Number::New( env, STATUS_ARRAY_PWM ) );
+	ret_tmp.Set("enc_pos", Napi::Number::New( env, STATUS_ARRAY_ENC_POS ) );
+	ret_tmp.Set("enc_spd", Napi::Number::New( env, STATUS_ARRAY_ENC_SPD ) );
+	ret_tmp.Set("pwm_max", Napi::Number::New( env, STATUS_ARRAY_PWM_MAX ) );
+	ret_tmp.Set("pwm_accel", Napi::Number::New( env, STATUS_ARRAY_PWM_ACCEL ) );
+	ret_tmp.Set("pwm_decel", Napi::Number::New( env, STATUS_ARRAY_PWM_DECEL ) );
+	ret_tmp.Set("current", Napi::Number::New( env, STATUS_ARRAY_CURRENT ) );
+	ret_tmp.Set("diag", Napi::Number::New( env, STATUS_ARRAY_DIAG ) );
+	ret_tmp.Set("length", Napi::Number::New( env, STATUS_ARRAY_SIZE ) );
+	//Number of channels
+	ret_tmp.Set("num_pwm", Napi::Number::New( env, NUM_VNH7040PWM ) );
+	ret_tmp.Set("num_enc", Napi::Number::New( env, NUM_ENC ) );
+	//Binary frame
+	ret_tmp.Set("frame_size", Napi::Number::New( env, STATUS_FRAME_SIZE ) );
+	//Return
+	return ret_tmp;
+}	//End Function: get_status_layout_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	get_status_frame_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @return Napi::Buffer | binary frame with the STATUS_FRAME layout
+//! @details
+//!	Meant to be sent as is to the browsers. A new Buffer for each call,
+//!	the websocket may still be sending the previous one
+/***************************************************************************/
+
+Napi::Value get_status_frame_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Frame sequence number. NODE.JS thread only
+	static uint32_t sequence = 0;
+	//Frame under construction
+	uint8_t frame[ STATUS_FRAME_SIZE ];
+	//Server time [ms]
+	double timestamp = (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count() / 1000.0;
+	//Serialize the latest snapshot
+	Orangebot::Status_snapshot::to_frame( Orangebot::get_status_snapshot().read(), sequence, timestamp, frame );
+	sequence++;
+	//Return
+	return Napi::Buffer<uint8_t>::Copy( env, frame, STATUS_FRAME_SIZE );
+}	//End Function: get_status_frame_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	get_generation_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @return Napi::Number | generation of the latest robot status
+//! @details
+//! Generation is incremented each time the parser publishes a status with different content
+/***************************************************************************/
+
+Napi::Value get_generation_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Return
+	return Napi::Number::New( env, Orangebot::get_status_snapshot().generation() );
+}	//End Function: get_generation_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	changed_since_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (Number generation) as returned by get_generation or get_status().generation
+//! @return Napi::Boolean | true = robot status changed since that generation
+//! @details
+//!	Cheap test before calling get_status
+/***************************************************************************/
+
+Napi::Value changed_since_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 1) || (!info[0].IsNumber()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting one argument of type Number").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//Generation known by the caller
+	uint32_t generation = info[0].As<Napi::Number>().Uint32Value();
+	//Return
+	return Napi::Boolean::New( env, Orangebot::get_status_snapshot().generation() != generation );
+}	//End Function: changed_since_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	SERIAL THREAD
+****************************************************************************/
+
+/****************************************************************************
+**	@brief Function
+**	serial_open_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (String port, Number baud, Function callback)
+//! @return Napi::Boolean | false = OK | true = FAIL
+//! @details
+//! Open the serial port and start the serial thread
+//!	callback( status_array ) is called on the NODE.JS thread when a message from the motor board changed the status
+//!	status_array is the persistent Int32Array of get_status_array, already refreshed
+//!	Events are coalesced: at most one call is queued and calls are at least set_event_rate apart
+//!	callback( status_array, true ) when the port hung up. The serial thread is gone, call serial_close and reopen
+/***************************************************************************/
+
+Napi::Value serial_open_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 3) || (!info[0].IsString()) || (!info[1].IsNumber()) || (!info[2].IsFunction()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting arguments (String port, Number baud, Function callback)").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//If: port already open, or hung up and not closed yet
+	if (g_f_serial_tsfn == true)
+	{
+		return Napi::Boolean::New( env, true );	//FAIL
+	}
+	//Thread safe function used by the serial thread to reach JS
+	g_serial_tsfn = Napi::ThreadSafeFunction::New( env, info[2].As<Napi::Function>(), "serial_rx", 0, 1 );
+	g_f_serial_update_pending = false;
+	g_f_serial_event_dirty = false;
+	//Open port and launch the serial thread
+	std::string port = info[0].As<Napi::String>();
+	DENTER_ARG( "baud: %d\n", info[1].As<Napi::Number>().Int32Value() );
+	//Round trips of the clock synchronization depend on the baud rate
+	Orangebot::clock_sync_set_baud( info[1].As<Napi::Number>().Int32Value() );
+	bool f_ret = g_serial_thread.open( port.c_str(), info[1].As<Napi::Number>().Int32Value(), serial_rx_handler );
+	//If: failed to open the port
+	if (f_ret == true)
+	{
+		DPRINT("ERR: failed to open the serial port\n");
+		//Release the thread safe function, else it keeps the event loop alive
+		g_serial_tsfn.Release();
+	}
+	else
+	{
+		g_f_serial_tsfn = true;
+	}
+	//Return
+	DRETURN_ARG("fail: %d\n", f_ret);
+	return Napi::Boolean::New( env, f_ret );
+}	//End Function: serial_open_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	serial_write_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (String message) or (Buffer message)
+//! @return Napi::Number | number of bytes written | -1 = FAIL
+//! @details
+//! Messages hold '\0' terminators. Strings are sent with their full length
+/***************************************************************************/
+
+Napi::Value serial_write_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Bytes written
+	int ret;
+	//If: string message
+	if ((info.Length() == 1) && (info[0].IsString()))
+	{
+		std::string str = info[0].As<Napi::String>();
+		ret = g_serial_thread.write( str.data(), (int)str.length() );
+	}
+	//If: binary message
+	else if ((info.Length() == 1) && (info[0].IsBuffer()))
+	{
+		Napi::Buffer<char> buf = info[0].As<Napi::Buffer<char>>();
+		ret = g_serial_thread.write( buf.Data(), (int)buf.Length() );
+	}
+	else
+	{
+		Napi::TypeError::New(env, "ERR: Expecting one argument of type String or Buffer").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//Return
+	return Napi::Number::New( env, ret );
+}	//End Function: serial_write_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	serial_close_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @return Napi::Value | undefined
+//! @details
+//! Stop the serial thread, close the port and release the JS callback
+//!	Also stops a session replay, it shares the JS callback
+/***************************************************************************/
+
+Napi::Value serial_close_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	DENTER();
+	//Join the serial thread first, it is the only user of the thread safe function. Also handles a port that hung up
+	g_serial_thread.close();
+	//Same for the replay thread
+	g_session_replay.close();
+	//If: thread safe function is acquired
+	if (g_f_serial_tsfn == true)
+	{
+		g_serial_tsfn.Release();
+		g_f_serial_tsfn = false;
+	}
+	DRETURN();
+	return env.Undefined();
+}	//End Function: serial_close_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	set_event_rate_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (Number rate) maximum status events per second. 0 = no limit
+//! @return Napi::Value | undefined
+//! @details
+//!	Bursts of messages closer than the period are merged into one event
+/***************************************************************************/
+
+Napi::Value set_event_rate_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 1) || (!info[0].IsNumber()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting one argument of type Number").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	double rate = info[0].As<Napi::Number>().DoubleValue();
+	//Period in microseconds. No limit for zero or negative rates
+	g_serial_event_period_us = (rate > 0.0) ? ((int)(1000000.0 / rate)) : (0);
+	return env.Undefined();
+}	//End Function: set_event_rate_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	odometry_reset_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Value | undefined
+//! @details
+//!	Pose back to the origin. Current encoder counts become the reference
+/***************************************************************************/
+
+Napi::Value odometry_reset_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if (info.Length() != 0)
+	{
+		Napi::TypeError::New(env, "ERR: Expecting no arguments").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	Orangebot::odometry_reset();
+	return env.Undefined();
+}	//End Function: odometry_reset_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	odometry_config_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (Number cnt_per_mm, Number track_mm) encoder counts per mm of travel, wheel track [mm]
+//! @return Napi::Value | undefined
+//! @details
+//!	Replace the default geometry from orangebot_config.h
+/***************************************************************************/
+
+Napi::Value odometry_config_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 2) || (!info[0].IsNumber()) || (!info[1].IsNumber()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting two arguments of type Number").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//If: geometry rejected
+	if (Orangebot::odometry_config( info[0].As<Napi::Number>().DoubleValue(), info[1].As<Napi::Number>().DoubleValue() ) == true)
+	{
+		Napi::RangeError::New(env, "ERR: Geometry must be positive").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	return env.Undefined();
+}	//End Function: odometry_config_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	get_stats_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Value | telemetry statistics
+//! @details
+//!	{ timestamps, lost, offset_ns, clock, types: { enc_abs, enc_rel, enc_spd, current } }
+//!	clock: { synced, samples, skew_ppm, error_us, rtt_min_us }. Latency is absolute when synced
+//!	Each type: { count, count_stamped, latency, interarrival }
+//!	Each series: { min_us, max_us, mean_us, hist }. hist[n] counts samples in [2^n, 2^(n+1)) us
+/***************************************************************************/
+
+Napi::Value get_stats_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if (info.Length() != 0)
+	{
+		Napi::TypeError::New(env, "ERR: Expecting no arguments").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//Names of the Telemetry_type
+	static const char *type_name[ Orangebot::TELEMETRY_NUM_TYPES ] = { "enc_abs", "enc_rel", "enc_spd", "current" };
+	//Consistent copy of the statistics
+	Orangebot::Telemetry_stats stats;
+	Orangebot::get_telemetry_stats( stats );
+	//Construct return object
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	ret_tmp.Set("timestamps", Napi::Number::New( env, stats.timestamps() ) );
+	ret_tmp.Set("lost", Napi::Number::New( env, stats.lost() ) );
+	ret_tmp.Set("offset_ns", Napi::Number::New( env, (double)stats.offset_ns() ) );
+	//Clock synchronization
+	Orangebot::Clock_sync sync;
+	Orangebot::get_clock_sync( sync );
+	Napi::Object clock = Napi::Object::New( env );
+	clock.Set("synced", Napi::Boolean::New( env, sync.is_synced() ) );
+	clock.Set("samples", Napi::Number::New( env, sync.samples() ) );
+	clock.Set("skew_ppm", Napi::Number::New( env, sync.skew_ppm() ) );
+	clock.Set("error_us", (sync.is_synced() == true) ? ((Napi::Value)Napi::Number::New( env, sync.error_ns() /1000.0 )) : (env.Null()) );
+	clock.Set("rtt_min_us", (sync.rtt_min_ns() >= 0) ? ((Napi::Value)Napi::Number::New( env, sync.rtt_min_ns() /1000.0 )) : (env.Null()) );
+	ret_tmp.Set("clock", clock );
+	Napi::Object types = Napi::Object::New( env );
+	//For: each message type
+	for (int t = 0;t < Orangebot::TELEMETRY_NUM_TYPES;t++)
+	{
+		const Orangebot::Telemetry_type_stats *type_stats = stats.type_stats( t );
+		Napi::Object type_tmp = Napi::Object::New( env );
+		type_tmp.Set("count", Napi::Number::New( env, type_stats -> count ) );
+		type_tmp.Set("count_stamped", Napi::Number::New( env, type_stats -> count_stamped ) );
+		type_tmp.Set("latency", construct_series( env, type_stats -> count_stamped, type_stats -> latency_min_us, type_stats -> latency_max_us, type_stats -> latency_sum_us, type_stats -> latency_hist ) );
+		//First message has no inter arrival time
+		type_tmp.Set("interarrival", construct_series( env, (type_stats -> count > 0) ? (type_stats -> count -1) : (0), type_stats -> interarrival_min_us, type_stats -> interarrival_max_us, type_stats -> interarrival_sum_us, type_stats -> interarrival_hist ) );
+		types.Set( type_name[t], type_tmp );
+	}
+	ret_tmp.Set("types", types );
+	return ret_tmp;
+}	//End Function: get_stats_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	construct_series | Napi::Env, uint32_t, int64_t, int64_t, int64_t, const uint32_t *
+****************************************************************************/
+//! @param count | number of samples
+//! @param min_us, max_us, sum_us | minimum, maximum and sum of the samples
+//! @param hist | TELEMETRY_HIST_SIZE log2 bins
+//! @return Napi::Object | { min_us, max_us, mean_us, hist }. Times are null with no samples
+/***************************************************************************/
+
+Napi::Object construct_series( Napi::Env env, uint32_t count, int64_t min_us, int64_t max_us, int64_t sum_us, const uint32_t *hist )
+{
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	ret_tmp.Set("min_us", (count > 0) ? ((Napi::Value)Napi::Number::New( env, (double)min_us )) : (env.Null()) );
+	ret_tmp.Set("max_us", (count > 0) ? ((Napi::Value)Napi::Number::New( env, (double)max_us )) : (env.Null()) );
+	ret_tmp.Set("mean_us", (count > 0) ? ((Napi::Value)Napi::Number::New( env, (double)sum_us /count )) : (env.Null()) );
+	ret_tmp.Set("hist", (Napi::Array)construct_array<const uint32_t>( env, hist, TELEMETRY_HIST_SIZE ) );
+	return ret_tmp;
+}	//End Function: construct_series | Napi::Env, uint32_t, int64_t, int64_t, int64_t, const uint32_t *
+
+/****************************************************************************
+**	@brief Function
+**	reset_stats_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Value | undefined
+//! @details
+//!	Clear the telemetry statistics. Meant to measure one scenario at a time
+/***************************************************************************/
+
+Napi::Value reset_stats_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if (info.Length() != 0)
+	{
+		Napi::TypeError::New(env, "ERR: Expecting no arguments").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	Orangebot::telemetry_stats_reset();
+	return env.Undefined();
+}	//End Function: reset_stats_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	serial_sync_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Number | number of bytes written | -1 = FAIL
+//! @details
+//!	Send PING<token>. The PONG reply adds a round trip to the clock synchronization
+//!	Meant to be called periodically. The send time is taken right before the write
+/***************************************************************************/
+
+Napi::Value serial_sync_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if (info.Length() != 0)
+	{
+		Napi::TypeError::New(env, "ERR: Expecting no arguments").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//PING message
+	char msg[16];
+	int length = Orangebot::clock_sync_request( msg, sizeof(msg) );
+	//If: could not build the message
+	if (length < 0)
+	{
+		return Napi::Number::New( env, -1 );	//FAIL
+	}
+	return Napi::Number::New( env, g_serial_thread.write( msg, length ) );
+}	//End Function: serial_sync_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	session_log_open_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (String path)
+//! @return Napi::Boolean | false = OK | true = FAIL
+//! @details
+//!	Record every read and write of the serial port with its timestamp. An existing log is appended
+/***************************************************************************/
+
+Napi::Value session_log_open_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 1) || (!info[0].IsString()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting one argument of type String").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	std::string path = info[0].As<Napi::String>();
+	bool f_ret = g_session_log.open( path.c_str() );
+	//If: recording
+	if (f_ret == false)
+	{
+		g_serial_thread.set_log( &g_session_log );
+	}
+	return Napi::Boolean::New( env, f_ret );
+}	//End Function: session_log_open_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	session_log_close_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Value | { records, bytes } written since open
+//! @details
+//!	Stop recording and flush the log
+/***************************************************************************/
+
+Napi::Value session_log_close_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Detach first. A write already in progress completes under the log lock
+	g_serial_thread.set_log( nullptr );
+	g_session_log.close();
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	ret_tmp.Set("records", Napi::Number::New( env, g_session_log.records() ) );
+	ret_tmp.Set("bytes", Napi::Number::New( env, (double)g_session_log.bytes() ) );
+	return ret_tmp;
+}	//End Function: session_log_close_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	session_replay_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (String path, Boolean realtime, Function callback)
+//! @return Napi::Boolean | false = OK | true = FAIL
+//! @details
+//!	Stand in for serial_open. The recorded RX bytes go through the same handler and the same status events
+//!	realtime = true paces the bytes like the recording. false feeds them at max speed
+//!	The replay ends by itself. serial_close releases it. Refused while the serial port is open
+/***************************************************************************/
+
+Napi::Value session_replay_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 3) || (!info[0].IsString()) || (!info[1].IsBoolean()) || (!info[2].IsFunction()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting arguments (String path, Boolean realtime, Function callback)").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//If: port or replay already open
+	if (g_f_serial_tsfn == true)
+	{
+		return Napi::Boolean::New( env, true );	//FAIL
+	}
+	//Thread safe function used by the replay thread to reach JS
+	g_serial_tsfn = Napi::ThreadSafeFunction::New( env, info[2].As<Napi::Function>(), "session_replay", 0, 1 );
+	g_f_serial_update_pending = false;
+	g_f_serial_event_dirty = false;
+	//Launch the replay thread
+	std::string path = info[0].As<Napi::String>();
+	bool f_ret = g_session_replay.open( path.c_str(), info[1].As<Napi::Boolean>().Value(), serial_rx_handler );
+	//If: failed to open the log
+	if (f_ret == true)
+	{
+		DPRINT("ERR: failed to open the session log\n");
+		//Release the thread safe function, else it keeps the event loop alive
+		g_serial_tsfn.Release();
+	}
+	else
+	{
+		g_f_serial_tsfn = true;
+	}
+	return Napi::Boolean::New( env, f_ret );
+}	//End Function: session_replay_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	session_replay_stats_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Value | { running, records, bytes, elapsed_ms, handler_ms }
+//! @details
+//!	handler_ms is the time spent parsing the replayed bytes. At max speed bytes /handler_ms is the parser throughput
+/***************************************************************************/
+
+Napi::Value session_replay_stats_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	ret_tmp.Set("running", Napi::Boolean::New( env, g_session_replay.is_running() ) );
+	ret_tmp.Set("records", Napi::Number::New( env, g_session_replay.records() ) );
+	ret_tmp.Set("bytes", Napi::Number::New( env, (double)g_session_replay.bytes() ) );
+	ret_tmp.Set("elapsed_ms", Napi::Number::New( env, g_session_replay.elapsed_ns() /1000000.0 ) );
+	ret_tmp.Set("handler_ms", Napi::Number::New( env, g_session_replay.handler_ns() /1000000.0 ) );
+	return ret_tmp;
+}	//End Function: session_replay_stats_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	firmware_log_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Value | { lost, messages: [ { time, text } ] }
+//! @details
+//!	Hand the undelivered log messages of the motor board to JS. Each message is delivered once
+//!	time is the arrival, CLOCK_MONOTONIC [ms]. lost counts the messages overwritten before JS read them
+/***************************************************************************/
+
+Napi::Value firmware_log_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	Napi::Array messages = Napi::Array::New( env );
+	//Message
+	double time_ms;
+	std::string text;
+	uint32_t num = 0;
+	//While: messages to deliver
+	while (Orangebot::firmware_log_pop( time_ms, text ) == false)
+	{
+		Napi::Object msg = Napi::Object::New( env );
+		msg.Set("time", Napi::Number::New( env, time_ms ) );
+		msg.Set("text", Napi::String::New( env, text ) );
+		messages[ num++ ] = msg;
+	}
+	ret_tmp.Set("lost", Napi::Number::New( env, Orangebot::firmware_log_lost() ) );
+	ret_tmp.Set("messages", messages );
+	return ret_tmp;
+}	//End Function: firmware_log_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	serial_rx_handler | const char *, int
+****************************************************************************/
+//! @param data | bytes received from the motor board
+//! @param length | number of bytes. 0 when called by the timeout. SERIAL_THREAD_HANGUP when the port hung up
+//! @return int | ms to wait before calling again with no data | -1 = no pending event
+//! @details
+//! Executed by the serial thread. Parse the bytes, then notify JS if the status changed
+//!	A hang up is always forwarded to JS, it has to reopen the port
+//!	The parser publishes the status as soon as a message completes
+//!	If the last event is too recent, ask the serial thread to come back when the period expires
+//!	If a notification is already queued JS will read the latest status anyway
+/***************************************************************************/
+
+int serial_rx_handler( const char *data, int length )
+{
+	DENTER_ARG("length: %d\n", length);
+	//If: port hung up. Last call of the serial thread
+	if (length == SERIAL_THREAD_HANGUP)
+	{
+		//If: queue refused the call (shutting down)
+		if (g_serial_tsfn.NonBlockingCall( serial_hangup_js ) != napi_ok)
+		{
+			DPRINT("ERR: hang up event refused\n");
+		}
+		DRETURN_ARG("hang up\n");
+		return -1;
+	}
+	//If: bytes received
+	if (length > 0)
+	{
+		//Generation before parsing
+		uint32_t generation = Orangebot::get_status_snapshot().generation();
+		//Parse on the serial thread
+		Orangebot::orangebot_parse( data, length );
+		//Status changed
+		g_f_serial_event_dirty |= (Orangebot::get_status_snapshot().generation() != generation);
+	}
+	//If: nothing to tell JS
+	if (g_f_serial_event_dirty == false)
+	{
+		DRETURN();
+		return -1;
+	}
+	//If: last event is too recent
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	int64_t wait_us = g_serial_event_period_us -std::chrono::duration_cast<std::chrono::microseconds>( now -g_serial_event_last ).count();
+	if (wait_us > 0)
+	{
+		//Come back when the period expires. Round up to the ms
+		DRETURN_ARG("wait us: %lld\n", (long long)wait_us);
+		return (int)((wait_us +999) /1000);
+	}
+	//Event sent or already queued
+	g_f_serial_event_dirty = false;
+	g_serial_event_last = now;
+	//If: no notification queued
+	if (g_f_serial_update_pending.exchange( true ) == false)
+	{
+		//If: queue refused the call (shutting down)
+		if (g_serial_tsfn.NonBlockingCall( serial_update_js ) != napi_ok)
+		{
+			DPRINT("ERR: status event refused\n");
+			g_f_serial_update_pending = false;
+		}
+	}
+	DRETURN_ARG("event\n");
+	return -1;
+}	//End Function: serial_rx_handler | const char *, int
+
+/****************************************************************************
+**	@brief Function
+**	serial_update_js | Napi::Env, Napi::Function
+****************************************************************************/
+//! @param env | NODE.JS environment
+//! @param callback | JS callback registered by serial_open
+//! @return void
+//! @details
+//! Executed by the NODE.JS thread. Hand the latest robot status to the JS callback
+//!	Refresh the persistent status array in place, no object is constructed
+/***************************************************************************/
+
+void serial_update_js( Napi::Env env, Napi::Function callback )
+{
+	DENTER();
+	//Clear first. Data parsed from now on queues a new notification
+	g_f_serial_update_pending = false;
+	//Call JS with the latest robot status
+	callback.Call( { get_status_array( env ) } );
+	DRETURN();
+	return;
+}	//End Function: serial_update_js | Napi::Env, Napi::Function
+
+/****************************************************************************
+**	@brief Function
+**	serial_hangup_js | Napi::Env, Napi::Function
+****************************************************************************/
+//! @param env | NODE.JS environment
+//! @param callback | JS callback registered by serial_open
+//! @return void
+//! @details
+//! Executed by the NODE.JS thread. The serial port hung up and the serial thread exited
+//!	Call JS with the latest robot status and true. JS calls serial_close, then serial_open to recover
+/***************************************************************************/
+
+void serial_hangup_js( Napi::Env env, Napi::Function callback )
+{
+	DENTER();
+	callback.Call( { get_status_array( env ), Napi::Boolean::New( env, true ) } );
+	DRETURN();
+	return;
+}	//End Function: serial_hangup_js | Napi::Env, Napi::Function
+
+/****************************************************************************
+**	@brief Function
+**	trace_dump_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (String path)
+//! @return Napi::Boolean | false = OK | true = FAIL
+//! @details
+//!	Write the last TRACE_RING_SIZE records of each thread. Decode with tools/trace_decode
+//!	Tracing goes on during the dump. Empty dump if the addon was built without ENABLE_TRACE
+/***************************************************************************/
+
+Napi::Value trace_dump_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Check arguments
+	if ((info.Length() != 1) || (!info[0].IsString()))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting one argument of type String").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	std::string path = info[0].As<Napi::String>();
+	return Napi::Boolean::New( env, Orangebot::trace_dump( path.c_str() ) );
+}	//End Function: trace_dump_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	trace_set_level_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | (String module, String level) or (String module, Number level)
+//! @return Napi::Boolean | false = OK | true = FAIL
+//! @details
+//!	module is a name of TRACE_MODULE_NAMES or "all". level is a name of TRACE_LEVEL_NAMES or its index
+//!	Takes effect at once on all threads. No effect if the addon was built without ENABLE_TRACE
+/***************************************************************************/
+
+Napi::Value trace_set_level_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Names of the modules and of the levels
+	static const char *module_name[ TRACE_NUM_MODULES ] = TRACE_MODULE_NAMES;
+	static const char *level_name[ TRACE_NUM_LEVELS ] = TRACE_LEVEL_NAMES;
+	//Check arguments
+	if ((info.Length() != 2) || (!info[0].IsString()) || ((!info[1].IsString()) && (!info[1].IsNumber())))
+	{
+		Napi::TypeError::New(env, "ERR: Expecting arguments (String module, String level)").ThrowAsJavaScriptException();
+		return env.Null();
+	}
+	//Module. TRACE_NUM_MODULES = all
+	std::string str = info[0].As<Napi::String>();
+	int module = -1;
+	if (str == "all")
+	{
+		module = TRACE_NUM_MODULES;
+	}
+	for (int t = 0;t < TRACE_NUM_MODULES;t++)
+	{
+		if (str == module_name[t])
+		{
+			module = t;
+		}
+	}
+	//Level
+	int level = -1;
+	if (info[1].IsNumber())
+	{
+		level = info[1].As<Napi::Number>().Int32Value();
+	}
+	else
+	{
+		str = info[1].As<Napi::String>();
+		for (int t = 0;t < TRACE_NUM_LEVELS;t++)
+		{
+			if (str == level_name[t])
+			{
+				level = t;
+			}
+		}
+	}
+	DPRINT("module: %d level: %d\n", module, level);
+	return Napi::Boolean::New( env, Orangebot::trace_set_level( module, level ) );
+}	//End Function: trace_set_level_wrap | Napi::CallbackInfo&
+
+/****************************************************************************
+**	@brief Function
+**	trace_get_levels_wrap | Napi::CallbackInfo&
+****************************************************************************/
+//! @param info | no arguments
+//! @return Napi::Object | { module name: level name }
+/***************************************************************************/
+
+Napi::Value trace_get_levels_wrap( const Napi::CallbackInfo& info )
+{
+	Napi::Env env = info.Env();
+	//Names of the modules and of the levels
+	static const char *module_name[ TRACE_NUM_MODULES ] = TRACE_MODULE_NAMES;
+	static const char *level_name[ TRACE_NUM_LEVELS ] = TRACE_LEVEL_NAMES;
+	Napi::Object ret_tmp = Napi::Object::New( env );
+	for (int t = 0;t < TRACE_NUM_MODULES;t++)
+	{
+		ret_tmp.Set( module_name[t], Napi::String::New( env, level_name[ Orangebot::trace_get_level( t ) ] ) );
+	}
+	return ret_tmp;
+}	//End Function: trace_get_levels_wrap | Napi::CallbackInfo&
 
 NODE_API_MODULE( OrangebotNodeCpp, init )
@@ -43,6 +43,8 @@
 #include <iostream>
 //Debug trace log
 //#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_PANOPTICON
 #include "debug.h"
 //Class Header
 #include "panopticon.h"
@@ -258,6 +260,354 @@ int &Panopticon::enc_spd( int index )
 	return this -> g_enc_spd[ index ];	//OK
 }	//end method: enc_abs | int
 
+/***************************************************************************/
+//!	@brief Public Reference
+//!	pwm_max | int
+/***************************************************************************/
+//! @param index | uint8_t | index of the PWM channel to be addressed
+//! @return int& reference to slew rate limiter PWM limit of the PWM channel
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::pwm_max( int index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad number of channels
+	if (index >= NUM_VNH7040PWM)
+	{
+		DPRINT("ERR: <%s> | bad index: %d\n", __FUNCTION__, index);
+        //Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+        return this -> g_dummy; //FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pwm_max[ index ];	//OK
+}	//end method: pwm_max | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	pwm_accel | int
+/***************************************************************************/
+//! @param index | uint8_t | index of the PWM channel to be addressed
+//! @return int& reference to slew rate limiter acceleration slope of the PWM channel
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::pwm_accel( int index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad number of channels
+	if (index >= NUM_VNH7040PWM)
+	{
+		DPRINT("ERR: <%s> | bad index: %d\n", __FUNCTION__, index);
+        //Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+        return this -> g_dummy; //FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pwm_accel[ index ];	//OK
+}	//end method: pwm_accel | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	pwm_decel | int
+/***************************************************************************/
+//! @param index | uint8_t | index of the PWM channel to be addressed
+//! @return int& reference to slew rate limiter deceleration slope of the PWM channel
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::pwm_decel( int index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad number of channels
+	if (index >= NUM_VNH7040PWM)
+	{
+		DPRINT("ERR: <%s> | bad index: %d\n", __FUNCTION__, index);
+        //Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+        return this -> g_dummy; //FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pwm_decel[ index ];	//OK
+}	//end method: pwm_decel | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	current | int
+/***************************************************************************/
+//! @param index | uint8_t | index of the VNH7040 channel to be addressed
+//! @return int& reference to filtered motor current of the channel [mA]
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::current( int index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad number of channels
+	if ((index < 0) || (index >= NUM_VNH7040PWM))
+	{
+		DPRINT("ERR: <%s> | bad index: %d\n", __FUNCTION__, index);
+		//Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+		return this -> g_dummy; //FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_current[ index ];	//OK
+}	//end method: current | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	current_limit | void
+/***************************************************************************/
+//! @return int& reference to the current limit of the firmware [mA]
+//!	@details
+//! Above it the firmware scales down the PWM of the channel
+/***************************************************************************/
+
+int &Panopticon::current_limit( void )
+{
+	return this -> g_current_limit;	//OK
+}	//end method: current_limit | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	stall_current | void
+/***************************************************************************/
+//! @return int& reference to the stall current of the firmware [mA]
+//!	@details
+//! A channel above it that does not move is stalled
+/***************************************************************************/
+
+int &Panopticon::stall_current( void )
+{
+	return this -> g_stall_current;	//OK
+}	//end method: stall_current | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	stall_ticks | void
+/***************************************************************************/
+//! @return int& reference to the stall duration of the firmware [control ticks]
+//!	@details
+//! A channel stalled for this long stops the platform
+/***************************************************************************/
+
+int &Panopticon::stall_ticks( void )
+{
+	return this -> g_stall_ticks;	//OK
+}	//end method: stall_ticks | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	ctrl_tick_us | void
+/***************************************************************************/
+//! @return int& reference to the period of the control system of the firmware [us]
+//!	@details
+//! Encoder speed is in counts per period. Tick counts of the firmware scale with it
+/***************************************************************************/
+
+int &Panopticon::ctrl_tick_us( void )
+{
+	return this -> g_ctrl_tick_us;	//OK
+}	//end method: ctrl_tick_us | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	diag | int
+/***************************************************************************/
+//! @param index | uint8_t | index of the VNH7040 channel to be addressed
+//! @return int& reference to the fault code of the channel. DIAG_* bit field
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::diag( int index )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad number of channels
+	if ((index < 0) || (index >= NUM_VNH7040PWM))
+	{
+		DPRINT("ERR: <%s> | bad index: %d\n", __FUNCTION__, index);
+		//Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+		return this -> g_dummy; //FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_diag[ index ];	//OK
+}	//end method: diag | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	config | int
+/***************************************************************************/
+//! @param id | int | CFG_* id of orangebot_config.h
+//! @return int& reference to the configuration parameter
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::config( int id )
+{
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad id
+	if ((id < 0) || (id >= CFG_NUM_ID))
+	{
+		DPRINT("ERR: <%s> | bad id: %d\n", __FUNCTION__, id);
+		//Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+		return this -> g_dummy; //FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_config[ id ];	//OK
+}	//end method: config | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	config_crc | void
+/***************************************************************************/
+//! @return int& reference to the CRC16 of the last configuration saved in EEPROM
+//!	@details
+//! Directly address a private var from the outside
+/***************************************************************************/
+
+int &Panopticon::config_crc( void )
+{
+	return this -> g_config_crc;	//OK
+}	//end method: config_crc | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	odom_x | void
+/***************************************************************************/
+//! @return double& reference to odometry x position [mm]
+//!	@details
+//! Written by the parser after each encoder message
+/***************************************************************************/
+
+double &Panopticon::odom_x( void )
+{
+	return this -> g_odom_x;	//OK
+}	//end method: odom_x | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	odom_y | void
+/***************************************************************************/
+//! @return double& reference to odometry y position [mm]
+//!	@details
+//! Written by the parser after each encoder message
+/***************************************************************************/
+
+double &Panopticon::odom_y( void )
+{
+	return this -> g_odom_y;	//OK
+}	//end method: odom_y | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	odom_heading | void
+/***************************************************************************/
+//! @return double& reference to odometry heading [rad]
+//!	@details
+//! Written by the parser after each encoder message
+/***************************************************************************/
+
+double &Panopticon::odom_heading( void )
+{
+	return this -> g_odom_heading;	//OK
+}	//end method: odom_heading | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	enc_pos_time | int
+/***************************************************************************/
+//! @param index | index of the encoder
+//! @return double& reference to the sampling time of the encoder count [ms]
+//!	@details
+//! RPI CLOCK_MONOTONIC. Firmware timestamp mapped by the clock synchronization
+/***************************************************************************/
+
+double &Panopticon::enc_pos_time( int index )
+{
+	//If: bad number of channels
+	if ((index < 0) || (index >= NUM_ENC))
+	{
+		DPRINT("ERR: <%s> | bad index: %d\n", __FUNCTION__, index);
+		//Address a dummy variable so not to dirty actual useful fields and not cause memory violation access
+		return this -> g_dummy_time; //FAIL
+	}
+	return this -> g_enc_pos_time[ index ];	//OK
+}	//end method: enc_pos_time | int
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	enc_spd_time | void
+/***************************************************************************/
+//! @return double& reference to the sampling time of the encoder speeds [ms]
+//!	@details
+//! RPI CLOCK_MONOTONIC. Firmware timestamp mapped by the clock synchronization
+/***************************************************************************/
+
+double &Panopticon::enc_spd_time( void )
+{
+	return this -> g_enc_spd_time;	//OK
+}	//end method: enc_spd_time | void
+
+/***************************************************************************/
+//!	@brief Public Reference
+//!	current_time | void
+/***************************************************************************/
+//! @return double& reference to the sampling time of the motor currents [ms]
+//!	@details
+//! RPI CLOCK_MONOTONIC. Firmware timestamp mapped by the clock synchronization
+/***************************************************************************/
+
+double &Panopticon::current_time( void )
+{
+	return this -> g_current_time;	//OK
+}	//end method: current_time | void
+
 /***************************************************************************/
 //!	@brief Public Reference
 //!	signature | void
@@ -334,7 +684,22 @@ void Panopticon::init( void )
 	{
 		//Initialize PWM
 		this -> g_pwm[t] = 0;
+		//Slew rate limiter parameters are unknown until the board reports them
+		this -> g_pwm_max[t] = 0;
+		this -> g_pwm_accel[t] = 0;
+		this -> g_pwm_decel[t] = 0;
+		//No current until the board reports it
+		this -> g_current[t] = 0;
+		//No fault until the board reports it
+		this -> g_diag[t] = DIAG_OK;
+	}
+	//Configuration is unknown until the board reports it
+	for (t = 0;t < CFG_NUM_ID;t++)
+	{
+		this -> g_config[t] = 0;
 	}
+	//No save yet
+	this -> g_config_crc = -1;
 
 	//For each Encoder channel
 	for (t = 0; t< NUM_ENC;t++)
@@ -342,7 +707,22 @@ void Panopticon::init( void )
 		//Initialize encoder count
 		this -> g_enc_pos[t] = 0;
 		this -> g_enc_spd[t] = 0;
+		//Never sampled
+		this -> g_enc_pos_time[t] = 0.0;
 	}
+	this -> g_enc_spd_time = 0.0;
+	this -> g_current_time = 0.0;
+	//Current limiter parameters are unknown until the board reports them
+	this -> g_current_limit = 0;
+	this -> g_stall_current = 0;
+	this -> g_stall_ticks = 0;
+	//Period of the control system is unknown until the board reports it
+	this -> g_ctrl_tick_us = 0;
+
+	//Odometry pose at the origin
+	this -> g_odom_x = 0.0;
+	this -> g_odom_y = 0.0;
+	this -> g_odom_heading = 0.0;
 
 	//For each PID parameter channel
 	for (t = 0; t< NUM_ENC;t++)
@@ -9,16 +9,15 @@
 **	GLOBAL INCLUDES
 **********************************************************************************/
 
+//Platform configuration shared with the AT4809 firmware. NUM_VNH7040, NUM_ENC, MAX_SIGNATURE_LENGTH
+#include "../../orangebot_config.h"
+
 /**********************************************************************************
 **	DEFINES
 **********************************************************************************/
 
-//maximum number of character of the board signature
-#define MAX_SIGNATURE_LENGTH	32
 //Number of VNH7040 Motor driver channels attached to the client board
-#define NUM_VNH7040PWM			4
-//Number of encoder channels attached to the client board
-#define NUM_ENC					2
+#define NUM_VNH7040PWM			NUM_VNH7040
 //Number of numeric parameters in a PID controller
 #define NUM_PID_PARAMS			3
 
@@ -108,6 +107,35 @@ class Panopticon
 		int &enc_pos( int index );
 		//Reference to encoder speed field
 		int &enc_spd( int index );
+		//Reference to PWM limit of the slew rate limiter
+		int &pwm_max( int index );
+		//Reference to PWM acceleration slope of the slew rate limiter
+		int &pwm_accel( int index );
+		//Reference to PWM deceleration slope of the slew rate limiter
+		int &pwm_decel( int index );
+		//Reference to filtered motor current [mA]
+		int &current( int index );
+		//Reference to the current limiter and stall detector parameters. [mA], [mA], [control ticks]
+		int &current_limit( void );
+		int &stall_current( void );
+		int &stall_ticks( void );
+		//Reference to the period of the control system of the firmware [us]. Encoder speed is counts per period
+		int &ctrl_tick_us( void );
+		//Reference to fault code of a VNH7040. DIAG_* bit field
+		int &diag( int index );
+		//Reference to a configuration parameter of the board. CFG_* id
+		int &config( int id );
+		//Reference to the CRC16 of the last configuration saved in EEPROM. -1 = none
+		int &config_crc( void );
+		//Reference to odometry pose. x, y [mm], heading [rad]
+		double &odom_x( void );
+		double &odom_y( void );
+		double &odom_heading( void );
+		//Reference to the sampling time of the encoder readings. RPI CLOCK_MONOTONIC [ms]
+		double &enc_pos_time( int index );
+		double &enc_spd_time( void );
+		//Reference to the sampling time of the motor currents. RPI CLOCK_MONOTONIC [ms]
+		double &current_time( void );
 
 		//--------------------------------------------------------------------------
 		//	TESTERS
@@ -163,6 +191,33 @@ class Panopticon
 		int g_enc_pos[ NUM_ENC ];
 		//Encoder speed reading
 		int g_enc_spd[ NUM_ENC ];
+		//PWM slew rate limiter parameters
+		int g_pwm_max[ NUM_VNH7040PWM ];
+		int g_pwm_accel[ NUM_VNH7040PWM ];
+		int g_pwm_decel[ NUM_VNH7040PWM ];
+		//Filtered motor current reading [mA]
+		int g_current[ NUM_VNH7040PWM ];
+		//Current limiter and stall detector parameters
+		int g_current_limit;
+		int g_stall_current;
+		int g_stall_ticks;
+		//Period of the control system [us]
+		int g_ctrl_tick_us;
+		//Fault code of each VNH7040
+		int g_diag[ NUM_VNH7040PWM ];
+		//Configuration parameters of the board
+		int g_config[ CFG_NUM_ID ];
+		int g_config_crc;
+		//Odometry pose computed from the encoder counts
+		double g_odom_x;
+		double g_odom_y;
+		double g_odom_heading;
+		//Dummy for the check of the time reference access methods
+		double g_dummy_time;
+		//When the firmware sampled the encoder readings. RPI CLOCK_MONOTONIC [ms]. 0 = never
+		double g_enc_pos_time[ NUM_ENC ];
+		double g_enc_spd_time;
+		double g_current_time;
 
 };	//End Class: Panopticon
 
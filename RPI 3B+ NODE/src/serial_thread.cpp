@@ -0,0 +1,613 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Serial_thread
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Own the serial port to the motor board on a dedicated thread
+**	Serial latency no longer depends on the NODE.JS event loop
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cerrno>
+//open
+#include <fcntl.h>
+//read, write, close, pipe
+#include <unistd.h>
+//poll
+#include <poll.h>
+//ioctl
+#include <sys/ioctl.h>
+//termios2, BOTHER. Can't be included together with <termios.h>
+#include <asm/termbits.h>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_SERIAL
+#include "debug.h"
+//Class Header
+#include "serial_thread.h"
+//Recorder of the session
+#include "session_log.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Serial_thread | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Serial_thread::Serial_thread( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+	//No recording
+	this -> g_log = nullptr;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Destructor
+//!	Serial_thread | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! A running std::thread can't be destroyed. Stop it before
+/***************************************************************************/
+
+Serial_thread::~Serial_thread( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Stop the thread and release the port
+	this -> close();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Setter
+//!	set_log | Session_log *
+/***************************************************************************/
+//! @param log | recorder of the session. nullptr = stop recording
+//! @return void
+//!	@details
+//!	Can be changed while the serial thread runs. The log must outlive its use
+/***************************************************************************/
+
+void Serial_thread::set_log( Session_log *log )
+{
+	this -> g_log = log;
+	return;
+}	//end setter: set_log | Session_log *
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_open | void
+/***************************************************************************/
+//! @return bool | true = port is open and serial thread is running
+//!	@details
+/***************************************************************************/
+
+bool Serial_thread::is_open( void )
+{
+	return (this -> g_f_running == true);
+}	//end tester: is_open | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	open | const char *, int, Serial_rx_handler
+/***************************************************************************/
+//! @param port | name of the serial port. E.g. /dev/ttyS0 or the slave side of a pty
+//! @param baud | baud rate. Any rate the UART can generate
+//! @param rx_handler | function called by the serial thread with the received bytes
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//! Open the port in raw 8N1 mode and start the serial thread
+/***************************************************************************/
+
+bool Serial_thread::open( const char *port, int baud, Serial_rx_handler rx_handler )
+{
+	//Trace Enter
+	DENTER_ARG( "port: %s | baud: %d\n", port, baud );
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: port is already open or bad arguments
+	if ((this -> g_fd >= 0) || (port == nullptr) || (baud <= 0) || (rx_handler == nullptr))
+	{
+		DRETURN_ARG("ERR: port already open or bad arguments\n");
+		return true;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Open the port. Not the controlling terminal of the process
+	this -> g_fd = ::open( port, O_RDWR | O_NOCTTY | O_CLOEXEC );
+	//If: failed to open
+	if (this -> g_fd < 0)
+	{
+		DRETURN_ARG("ERR: failed to open %s | errno: %d\n", port, errno);
+		return true;	//FAIL
+	}
+	//If: failed to configure the port or to create the wake pipe
+	if ((this -> configure( baud ) == true) || (::pipe2( this -> g_wake_fd, O_CLOEXEC ) != 0))
+	{
+		::close( this -> g_fd );
+		this -> init();
+		DRETURN_ARG("ERR: failed to configure %s | errno: %d\n", port, errno);
+		return true;	//FAIL
+	}
+	//Register handler
+	this -> g_rx_handler = rx_handler;
+	//Launch the serial thread
+	this -> g_f_running = true;
+	this -> g_thread = std::thread( &Serial_thread::worker, this );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end method: open | const char *, int, Serial_rx_handler
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	close | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Wake the serial thread, join it, then release the port
+//!	After close returns the RX handler is no longer called
+/***************************************************************************/
+
+void Serial_thread::close( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Wake byte
+	char wake = 0;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: port is not open
+	if (this -> g_fd < 0)
+	{
+		DRETURN();
+		return;	//OK
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Ask the thread to stop and wake it from poll
+	this -> g_f_running = false;
+	if (::write( this -> g_wake_fd[1], &wake, 1 ) < 0)
+	{
+		DPRINT("ERR: failed to wake serial thread | errno: %d\n", errno);
+	}
+	//If: thread was started
+	if (this -> g_thread.joinable() == true)
+	{
+		//Wait for the serial thread to exit
+		this -> g_thread.join();
+	}
+	//Release port and pipe
+	::close( this -> g_fd );
+	::close( this -> g_wake_fd[0] );
+	::close( this -> g_wake_fd[1] );
+	this -> init();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return;	//OK
+}	//end method: close | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	write | const char *, int
+/***************************************************************************/
+//! @param data | bytes to be sent. Messages hold '\0' terminators, this is not a string
+//! @param length | number of bytes to be sent
+//! @return int | number of bytes written | -1 = FAIL
+//!	@details
+//! Called by the NODE.JS thread. The port is blocking, write returns when all bytes are queued in the driver
+/***************************************************************************/
+
+int Serial_thread::write( const char *data, int length )
+{
+	//Trace Enter
+	DENTER_ARG( "length: %d\n", length );
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Bytes written so far
+	int cnt = 0;
+	//Return of a single write
+	ssize_t ret;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: port is not open
+	if ((this -> g_fd < 0) || (data == nullptr) || (length < 0))
+	{
+		DRETURN_ARG("ERR: port is not open\n");
+		return -1;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: bytes left to send
+	while (cnt < length)
+	{
+		ret = ::write( this -> g_fd, &data[cnt], length -cnt );
+		//If: interrupted by a signal
+		if ((ret < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+		//If: write failed
+		else if (ret < 0)
+		{
+			DRETURN_ARG("ERR: write failed | errno: %d\n", errno);
+			return -1;	//FAIL
+		}
+		cnt += (int)ret;
+	}
+	//If: recording the session
+	Session_log *log = this -> g_log;
+	if (log != nullptr)
+	{
+		log -> write( SESSION_LOG_TX, data, cnt );
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return cnt;	//OK
+}	//end method: write | const char *, int
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables to closed port
+/***************************************************************************/
+
+void Serial_thread::init( void )
+{
+	//Port closed
+	this -> g_fd = -1;
+	this -> g_wake_fd[0] = -1;
+	this -> g_wake_fd[1] = -1;
+	//Thread not running
+	this -> g_f_running = false;
+	//No handler
+	this -> g_rx_handler = nullptr;
+
+	return;	//OK
+}	//end method: init | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	configure | int
+/***************************************************************************/
+//! @param baud | baud rate
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//!	termios only knows Bxxx constants and 256000 is not one of them
+//!	termios2 with BOTHER takes the baud rate as a number
+//!	Raw mode, 8N1, no flow control. read returns as soon as a byte is available
+/***************************************************************************/
+
+bool Serial_thread::configure( int baud )
+{
+	//Trace Enter
+	DENTER_ARG( "baud: %d\n", baud );
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Port configuration
+	struct termios2 tio;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Fetch current configuration
+	if (ioctl( this -> g_fd, TCGETS2, &tio ) != 0)
+	{
+		DRETURN_ARG("ERR: TCGETS2 failed | errno: %d\n", errno);
+		return true;	//FAIL
+	}
+	//Raw mode. No input or output processing, no echo, no signals
+	tio.c_iflag = 0;
+	tio.c_oflag = 0;
+	tio.c_lflag = 0;
+	//8N1, receiver enabled, ignore modem lines, baud rate given as number
+	tio.c_cflag = CS8 | CREAD | CLOCAL | BOTHER;
+	tio.c_ispeed = baud;
+	tio.c_ospeed = baud;
+	//read blocks until at least one byte is available. poll is used to wait anyway
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	//Apply configuration
+	if (ioctl( this -> g_fd, TCSETS2, &tio ) != 0)
+	{
+		DRETURN_ARG("ERR: TCSETS2 failed | errno: %d\n", errno);
+		return true;	//FAIL
+	}
+	//Discard stale bytes
+	ioctl( this -> g_fd, TCFLSH, TCIOFLUSH );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end method: configure | int
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	worker | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Body of the serial thread
+//!	Wait on the port and on the wake pipe. Feed the received bytes to the RX handler
+//!	When the handler asked for a timeout and no data arrived, call it with no data
+//!	Exit when woken by close() or when the port hangs up
+//!	A hung up tty polls POLLIN|POLLERR|POLLHUP and reads 0 bytes. The handler is told with SERIAL_THREAD_HANGUP
+/***************************************************************************/
+
+void Serial_thread::worker( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Wait on port and wake pipe
+	struct pollfd fds[2];
+	//Receive buffer
+	char buf[SERIAL_THREAD_RX_BUF_SIZE];
+	//Return of poll and read
+	int ret;
+	//Poll timeout requested by the RX handler. -1 = wait forever
+	int timeout = -1;
+	//The port hung up, the thread did not exit because of close()
+	bool f_hangup = false;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	fds[0].fd = this -> g_fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = this -> g_wake_fd[0];
+	fds[1].events = POLLIN;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: thread is allowed to run
+	while (this -> g_f_running == true)
+	{
+		//Wait for data, for the wake byte or for the timeout requested by the handler
+		ret = poll( fds, 2, timeout );
+		//If: interrupted by a signal
+		if ((ret < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+		//If: poll failed or close() woke the thread
+		else if ((ret < 0) || (fds[1].revents != 0))
+		{
+			break;
+		}
+		//If: timeout expired
+		else if (ret == 0)
+		{
+			//Call the handler with no data
+			timeout = this -> g_rx_handler( buf, 0 );
+			continue;
+		}
+		//If: data available
+		if ((fds[0].revents & POLLIN) != 0)
+		{
+			ret = (int)::read( this -> g_fd, buf, SERIAL_THREAD_RX_BUF_SIZE );
+			//If: received bytes
+			if (ret > 0)
+			{
+				//If: recording the session
+				Session_log *log = this -> g_log;
+				if (log != nullptr)
+				{
+					log -> write( SESSION_LOG_RX, buf, ret );
+				}
+				//Process bytes on this thread
+				timeout = this -> g_rx_handler( buf, ret );
+			}
+			//If: end of file or read failed. A tty that hung up reads 0 bytes forever
+			else if ((ret == 0) || ((errno != EINTR) && (errno != EAGAIN)))
+			{
+				DPRINT("ERR: serial port read failed | ret: %d | errno: %d\n", ret, errno);
+				f_hangup = true;
+				break;
+			}
+		}
+		//If: port hung up or was closed under the thread. POLLIN may be raised as well
+		if ((fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+		{
+			DPRINT("ERR: serial port hung up | revents: %x\n", fds[0].revents);
+			f_hangup = true;
+			break;
+		}
+	}	//End While: thread is allowed to run
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Serial thread is no longer running. Port stays open until close()
+	this -> g_f_running = false;
+	//If: the port hung up. Tell the handler, the owner has to reopen the port
+	if (f_hangup == true)
+	{
+		this -> g_rx_handler( nullptr, SERIAL_THREAD_HANGUP );
+	}
+
+	//Trace Return
+	DRETURN();
+	return;	//OK
+}	//end method: worker | void
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,193 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef SERIAL_THREAD_H_
+	#define SERIAL_THREAD_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <atomic>
+#include <thread>
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Size of the buffer used by a single read from the serial port
+#define SERIAL_THREAD_RX_BUF_SIZE	256
+//Length passed to the RX handler when the port hung up. Last call of the thread
+#define SERIAL_THREAD_HANGUP		-1
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//Function called by the serial thread with the bytes received from the serial port
+//length = 0 when called because the timeout expired. Return the timeout in ms before the next call with no data. -1 = no timeout
+//length = SERIAL_THREAD_HANGUP when the port hung up. The thread exits after the call, close() and open() to recover
+typedef int (*Serial_rx_handler)( const char *data, int length );
+//Defined in session_log.h
+class Session_log;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Serial_thread
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Own a serial port and process received bytes on a dedicated thread
+//! @details
+//!	Open and configure a serial port with termios2. Any baud rate is allowed (BOTHER) \n
+//!	A dedicated thread waits on the port with poll and calls the RX handler with the received bytes \n
+//!	The handler executes on the serial thread. It has to protect the data it shares with other threads \n
+//!	The handler returns a timeout. If no data arrives in that time the handler is called with no data \n
+//!	close() wakes the thread with a pipe and joins it \n
+//!	A pty pair can stand in for the serial port: socat -d -d pty,raw,echo=0 pty,raw,echo=0 \n
+//!	An optional Session_log records every read and write with its timestamp
+//! @bug		None
+//! @warning	Linux only
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Serial_thread
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Serial_thread( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor. Close the port and join the thread
+		~Serial_thread( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Record the bytes read and written. nullptr = no recording
+		void set_log( Session_log *log );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = port is open and the serial thread is running
+		bool is_open( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Open the port with the given baud rate and start the serial thread. false = OK
+		bool open( const char *port, int baud, Serial_rx_handler rx_handler );
+		//Stop the serial thread and close the port
+		void close( void );
+		//Write bytes to the port. Return number of bytes written or -1
+		int write( const char *data, int length );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+		//Configure raw 8N1 mode and baud rate of the port. false = OK
+		bool configure( int baud );
+		//Body of the serial thread
+		void worker( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//File descriptor of the serial port. -1 when closed
+		int g_fd;
+		//Pipe used to wake the serial thread. [0] read end, [1] write end
+		int g_wake_fd[2];
+		//Serial thread is running
+		std::atomic<bool> g_f_running;
+		//Function that processes the received bytes
+		Serial_rx_handler g_rx_handler;
+		//Recorder of the session. nullptr = none. Kept across open and close
+		std::atomic<Session_log *> g_log;
+		//Serial thread
+		std::thread g_thread;
+
+};	//End Class: Serial_thread
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
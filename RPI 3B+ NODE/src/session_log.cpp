@@ -0,0 +1,520 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Session_log
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Record the raw bytes exchanged with the motor board
+**	A recorded session can be replayed offline through the parser
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+//ftruncate
+#include <unistd.h>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_SERIAL
+#include "debug.h"
+//Class Header
+#include "session_log.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	LOCAL FUNCTIONS
+****************************************************************************/
+
+//Store an integer little endian
+static inline void put_le( uint8_t *dst, uint64_t value, int size )
+{
+	for (int t = 0;t < size;t++)
+	{
+		dst[t] = (uint8_t)(value >> (8 *t));
+	}
+}
+
+//Load an integer little endian
+static inline uint64_t get_le( const uint8_t *src, int size )
+{
+	uint64_t value = 0;
+	for (int t = 0;t < size;t++)
+	{
+		value |= (uint64_t)src[t] << (8 *t);
+	}
+	return value;
+}
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Session_log | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Session_log::Session_log( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Destructor
+//!	Session_log | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Flush what is still buffered
+/***************************************************************************/
+
+Session_log::~Session_log( void )
+{
+	this -> close();
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	records | void
+/***************************************************************************/
+//! @return uint32_t | records written since open
+/***************************************************************************/
+
+uint32_t Session_log::records( void )
+{
+	std::lock_guard<std::mutex> lock( this -> g_mutex );
+	return this -> g_records;
+}	//end getter: records | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	bytes | void
+/***************************************************************************/
+//! @return uint64_t | bytes of data written since open
+/***************************************************************************/
+
+uint64_t Session_log::bytes( void )
+{
+	std::lock_guard<std::mutex> lock( this -> g_mutex );
+	return this -> g_bytes;
+}	//end getter: bytes | void
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_open | void
+/***************************************************************************/
+//! @return bool | true = recording
+/***************************************************************************/
+
+bool Session_log::is_open( void )
+{
+	std::lock_guard<std::mutex> lock( this -> g_mutex );
+	return (this -> g_file != nullptr);
+}	//end tester: is_open | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	open | const char *
+/***************************************************************************/
+//! @param path | name of the log file
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//!	A new file gets the header. An existing file must be a log of the same version, the session is appended
+//!	A crash may have left a truncated record at the end. It is cut away, or the new session would be read as its bytes
+/***************************************************************************/
+
+bool Session_log::open( const char *path )
+{
+	//Trace Enter
+	DENTER_ARG( "path: %s\n", (path != nullptr) ? (path) : ("null") );
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Log file
+	FILE *file;
+	//File header
+	uint8_t header[ SESSION_LOG_HEADER_SIZE ];
+	//Record of the old sessions
+	Session_log_record record;
+	//Size of the file and end of the last complete record
+	long size, end;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	std::lock_guard<std::mutex> lock( this -> g_mutex );
+	//If: already recording or bad path
+	if ((this -> g_file != nullptr) || (path == nullptr))
+	{
+		DRETURN_ARG("ERR: already recording or bad path\n");
+		return true;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Append. Writes always go to the end
+	file = fopen( path, "ab+" );
+	//If: failed to open
+	if (file == nullptr)
+	{
+		DRETURN_ARG("ERR: failed to open %s\n", path);
+		return true;	//FAIL
+	}
+	//If: empty file
+	size = ((fseek( file, 0, SEEK_END ) == 0) ? (ftell( file )) : (-1));
+	if (size == 0)
+	{
+		memcpy( header, SESSION_LOG_MAGIC, 4 );
+		put_le( &header[4], SESSION_LOG_VERSION, 2 );
+		put_le( &header[6], 0, 2 );
+		//If: failed to write the header
+		if (fwrite( header, 1, SESSION_LOG_HEADER_SIZE, file ) != SESSION_LOG_HEADER_SIZE)
+		{
+			fclose( file );
+			DRETURN_ARG("ERR: failed to write header\n");
+			return true;	//FAIL
+		}
+	}
+	//If: not a log or a different version. Don't append to it
+	else if ((fseek( file, 0, SEEK_SET ) != 0) || (Session_log::read_header( file ) == true))
+	{
+		fclose( file );
+		DRETURN_ARG("ERR: %s is not a session log\n", path);
+		return true;	//FAIL
+	}
+	//Else: log of the same version. Find the end of the last complete record
+	else
+	{
+		end = SESSION_LOG_HEADER_SIZE;
+		//While: the header and the bytes of the next record are in the file
+		while ((Session_log::read_record( file, record ) == false) && (end +SESSION_LOG_RECORD_SIZE +record.length <= size) && (fseek( file, record.length, SEEK_CUR ) == 0))
+		{
+			end += SESSION_LOG_RECORD_SIZE +record.length;
+		}
+		//If: the old session ends with a truncated or corrupt record. Cut it
+		if (end < size)
+		{
+			DPRINT("truncated record | cut %ld bytes\n", size -end);
+			//If: failed to cut. Appending would misalign every record after it
+			if ((fflush( file ) != 0) || (ftruncate( fileno( file ), end ) != 0))
+			{
+				fclose( file );
+				DRETURN_ARG("ERR: failed to cut the truncated record of %s\n", path);
+				return true;	//FAIL
+			}
+		}
+		//Switch from reading to writing. Append mode writes at the end anyway
+		fseek( file, 0, SEEK_END );
+	}
+	this -> g_file = file;
+	this -> g_records = 0;
+	this -> g_bytes = 0;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end method: open | const char *
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	close | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Flush and close. Writes after close are dropped
+/***************************************************************************/
+
+void Session_log::close( void )
+{
+	std::lock_guard<std::mutex> lock( this -> g_mutex );
+	//If: recording
+	if (this -> g_file != nullptr)
+	{
+		fclose( this -> g_file );
+		this -> g_file = nullptr;
+	}
+	return;	//OK
+}	//end method: close | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	write | int, const char *, int
+/***************************************************************************/
+//! @param direction | Session_log_direction
+//! @param data | raw bytes
+//! @param length | number of bytes
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//!	Timestamp taken here, right after the caller read or wrote the port
+//!	Writes longer than SESSION_LOG_MAX_LENGTH become more records with the same timestamp
+/***************************************************************************/
+
+bool Session_log::write( int direction, const char *data, int length )
+{
+	//Trace Enter
+	DENTER_ARG( "direction: %d | length: %d\n", direction, length );
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Time of the bytes
+	int64_t time_ns = Session_log::now_ns();
+	//Header of a record
+	uint8_t record[ SESSION_LOG_RECORD_SIZE ];
+	//Bytes of the current record
+	int chunk;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad arguments
+	if ((direction < 0) || (direction >= SESSION_LOG_NUM_DIRECTIONS) || (data == nullptr) || (length < 0))
+	{
+		DRETURN_ARG("ERR: bad arguments\n");
+		return true;	//FAIL
+	}
+	std::lock_guard<std::mutex> lock( this -> g_mutex );
+	//If: not recording
+	if (this -> g_file == nullptr)
+	{
+		DRETURN();
+		return false;	//OK
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: bytes left
+	while (length > 0)
+	{
+		chunk = (length > SESSION_LOG_MAX_LENGTH) ? (SESSION_LOG_MAX_LENGTH) : (length);
+		record[0] = (uint8_t)direction;
+		put_le( &record[1], chunk, 2 );
+		put_le( &record[3], (uint64_t)time_ns, 8 );
+		//If: failed to write. Disk full. Stop recording rather than leave holes
+		if ((fwrite( record, 1, SESSION_LOG_RECORD_SIZE, this -> g_file ) != SESSION_LOG_RECORD_SIZE) || (fwrite( data, 1, chunk, this -> g_file ) != (size_t)chunk))
+		{
+			fclose( this -> g_file );
+			this -> g_file = nullptr;
+			DRETURN_ARG("ERR: write failed. Recording stopped\n");
+			return true;	//FAIL
+		}
+		this -> g_records++;
+		this -> g_bytes += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end method: write | int, const char *, int
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	now_ns | void
+/***************************************************************************/
+//! @return int64_t | CLOCK_MONOTONIC [ns]
+/***************************************************************************/
+
+int64_t Session_log::now_ns( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec *1000000000LL +ts.tv_nsec;
+}	//end static method: now_ns | void
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	read_header | FILE *
+/***************************************************************************/
+//! @param file | log positioned at the start
+//! @return bool | false = OK | true = not a log or different version
+/***************************************************************************/
+
+bool Session_log::read_header( FILE *file )
+{
+	//File header
+	uint8_t header[ SESSION_LOG_HEADER_SIZE ];
+
+	//If: too short
+	if (fread( header, 1, SESSION_LOG_HEADER_SIZE, file ) != SESSION_LOG_HEADER_SIZE)
+	{
+		return true;	//FAIL
+	}
+	//If: not a log or a different version
+	if ((memcmp( header, SESSION_LOG_MAGIC, 4 ) != 0) || (get_le( &header[4], 2 ) != SESSION_LOG_VERSION))
+	{
+		return true;	//FAIL
+	}
+	return false;	//OK
+}	//end static method: read_header | FILE *
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	read_record | FILE *, Session_log_record &
+/***************************************************************************/
+//! @param file | log positioned at the start of a record
+//! @param record | decoded header of the record. The bytes follow in the file
+//! @return bool | false = OK | true = end of file, truncated or corrupt record
+/***************************************************************************/
+
+bool Session_log::read_record( FILE *file, Session_log_record &record )
+{
+	//Header of a record
+	uint8_t raw[ SESSION_LOG_RECORD_SIZE ];
+
+	//If: end of file or truncated header
+	if (fread( raw, 1, SESSION_LOG_RECORD_SIZE, file ) != SESSION_LOG_RECORD_SIZE)
+	{
+		return true;	//FAIL
+	}
+	record.direction = raw[0];
+	record.length = (uint16_t)get_le( &raw[1], 2 );
+	record.time_ns = (int64_t)get_le( &raw[3], 8 );
+	//If: corrupt record
+	if ((record.direction >= SESSION_LOG_NUM_DIRECTIONS) || (record.length > SESSION_LOG_MAX_LENGTH))
+	{
+		return true;	//FAIL
+	}
+	return false;	//OK
+}	//end static method: read_record | FILE *, Session_log_record &
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables to not recording
+/***************************************************************************/
+
+void Session_log::init( void )
+{
+	this -> g_file = nullptr;
+	this -> g_records = 0;
+	this -> g_bytes = 0;
+
+	return;	//OK
+}	//end method: init | void
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
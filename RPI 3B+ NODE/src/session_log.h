@@ -0,0 +1,210 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef SESSION_LOG_H_
+	#define SESSION_LOG_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+#include <cstdio>
+#include <mutex>
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//File starts with the magic and the version
+#define SESSION_LOG_MAGIC			"OBSL"
+#define SESSION_LOG_VERSION			1
+//Bytes of the file header. Magic, version U16, reserved U16
+#define SESSION_LOG_HEADER_SIZE		8
+//Bytes of the header of a record. Direction U8, length U16, CLOCK_MONOTONIC S64 [ns]. Little endian
+#define SESSION_LOG_RECORD_SIZE		11
+//Longer writes are split in more records
+#define SESSION_LOG_MAX_LENGTH		4096
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//! Direction of the bytes of a record
+typedef enum _Session_log_direction
+{
+	SESSION_LOG_RX,			//Motor board -> RPI
+	SESSION_LOG_TX,			//RPI -> Motor board
+	SESSION_LOG_NUM_DIRECTIONS
+} Session_log_direction;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//! Header of one record. The bytes follow it in the file
+typedef struct _Session_log_record
+{
+	//Session_log_direction
+	uint8_t direction;
+	//Bytes of the record
+	uint16_t length;
+	//CLOCK_MONOTONIC when the bytes were read or written [ns]
+	int64_t time_ns;
+} Session_log_record;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Session_log
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Record the raw bytes exchanged with the motor board
+//! @details
+//!	Append only file. Header, then one record per read or write of the serial port \n
+//!	Record: direction, length, CLOCK_MONOTONIC timestamp, raw bytes. Messages keep their '\0' terminators \n
+//!	Opening an existing log appends a new session to it. Timestamps jump between sessions \n
+//!	Writes are buffered by stdio. A crash loses the tail of the buffer. The next open() cuts the truncated record before appending \n
+//!	Session_replay feeds a recorded log back to the parser
+//! @bug		None
+//! @warning	Thread safe. Serial thread writes RX, NODE.JS thread writes TX
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Session_log
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Session_log( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor. Flush and close the file
+		~Session_log( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Records written since open
+		uint32_t records( void );
+		//Bytes of data written since open, headers excluded
+		uint64_t bytes( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = recording
+		bool is_open( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Open a log for append. Create it if missing. false = OK
+		bool open( const char *path );
+		//Flush and close the log
+		void close( void );
+		//Record bytes with the current time. Does nothing if closed. false = OK
+		bool write( int direction, const char *data, int length );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//CLOCK_MONOTONIC [ns]
+		static int64_t now_ns( void );
+		//Check the header of a log. false = OK
+		static bool read_header( FILE *file );
+		//Read the header of the next record. false = OK | true = end of file or truncated record
+		static bool read_record( FILE *file, Session_log_record &record );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Serializes writers from the serial thread and from the NODE.JS thread
+		std::mutex g_mutex;
+		//Log file. nullptr = not recording
+		FILE *g_file;
+		//Records written
+		uint32_t g_records;
+		//Bytes of data written
+		uint64_t g_bytes;
+
+};	//End Class: Session_log
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,508 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Session_replay
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Replay a recorded session through the RX handler
+**	Reproduce a run offline and benchmark the parser on production traffic
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <chrono>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_SERIAL
+#include "debug.h"
+//Serial_rx_handler
+#include "serial_thread.h"
+//Record format
+#include "session_log.h"
+//Class Header
+#include "session_replay.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Nanoseconds in a millisecond
+#define NS_PER_MS			1000000LL
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Session_replay | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Session_replay::Session_replay( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+	this -> g_records = 0;
+	this -> g_bytes = 0;
+	this -> g_start_ns = 0;
+	this -> g_end_ns = 0;
+	this -> g_handler_ns = 0;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Destructor
+//!	Session_replay | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! A running std::thread can't be destroyed. Stop it before
+/***************************************************************************/
+
+Session_replay::~Session_replay( void )
+{
+	this -> close();
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	records | void
+/***************************************************************************/
+//! @return uint32_t | RX records fed to the handler
+/***************************************************************************/
+
+uint32_t Session_replay::records( void )
+{
+	return this -> g_records;
+}	//end getter: records | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	bytes | void
+/***************************************************************************/
+//! @return uint64_t | RX bytes fed to the handler
+/***************************************************************************/
+
+uint64_t Session_replay::bytes( void )
+{
+	return this -> g_bytes;
+}	//end getter: bytes | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	elapsed_ns | void
+/***************************************************************************/
+//! @return int64_t | duration of the replay so far, or of the whole replay once it ended [ns]
+/***************************************************************************/
+
+int64_t Session_replay::elapsed_ns( void )
+{
+	//Snapshot of the times
+	int64_t start_ns = this -> g_start_ns;
+	int64_t end_ns = this -> g_end_ns;
+
+	//If: never started
+	if (start_ns == 0)
+	{
+		return 0;
+	}
+	return ((end_ns != 0) ? (end_ns) : (Session_log::now_ns())) -start_ns;
+}	//end getter: elapsed_ns | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	handler_ns | void
+/***************************************************************************/
+//! @return int64_t | time spent inside the handler [ns]
+/***************************************************************************/
+
+int64_t Session_replay::handler_ns( void )
+{
+	return this -> g_handler_ns;
+}	//end getter: handler_ns | void
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_running | void
+/***************************************************************************/
+//! @return bool | true = replay thread is feeding the handler
+/***************************************************************************/
+
+bool Session_replay::is_running( void )
+{
+	return (this -> g_f_running == true);
+}	//end tester: is_running | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	open | const char *, bool, Serial_rx_handler
+/***************************************************************************/
+//! @param path | name of the recorded session
+//! @param f_realtime | true = pace like the recording | false = max speed
+//! @param rx_handler | function called by the replay thread with the recorded bytes
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//!	Check the log and start the replay thread. Statistics restart
+//!	The thread stops by itself at the end of the log. close() is still needed to release it
+/***************************************************************************/
+
+bool Session_replay::open( const char *path, bool f_realtime, Serial_rx_handler rx_handler )
+{
+	//Trace Enter
+	DENTER_ARG( "path: %s | realtime: %d\n", (path != nullptr) ? (path) : ("null"), f_realtime );
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: replay already open or bad arguments
+	if ((this -> g_file != nullptr) || (path == nullptr) || (rx_handler == nullptr))
+	{
+		DRETURN_ARG("ERR: replay already open or bad arguments\n");
+		return true;	//FAIL
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_file = fopen( path, "rb" );
+	//If: failed to open
+	if (this -> g_file == nullptr)
+	{
+		DRETURN_ARG("ERR: failed to open %s\n", path);
+		return true;	//FAIL
+	}
+	//If: not a session log
+	if (Session_log::read_header( this -> g_file ) == true)
+	{
+		fclose( this -> g_file );
+		this -> init();
+		DRETURN_ARG("ERR: %s is not a session log\n", path);
+		return true;	//FAIL
+	}
+	this -> g_f_realtime = f_realtime;
+	this -> g_rx_handler = rx_handler;
+	//Restart statistics
+	this -> g_records = 0;
+	this -> g_bytes = 0;
+	this -> g_handler_ns = 0;
+	this -> g_end_ns = 0;
+	this -> g_start_ns = Session_log::now_ns();
+	//Launch the replay thread
+	this -> g_f_running = true;
+	this -> g_thread = std::thread( &Session_replay::worker, this );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end method: open | const char *, bool, Serial_rx_handler
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	close | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Wake the replay thread, join it, then release the log. Statistics are kept
+//!	After close returns the RX handler is no longer called
+/***************************************************************************/
+
+void Session_replay::close( void )
+{
+	//Trace Enter
+	DENTER();
+
+	//If: replay is not open
+	if (this -> g_file == nullptr)
+	{
+		DRETURN();
+		return;	//OK
+	}
+	//Ask the thread to stop and wake it from a wait
+	{
+		std::lock_guard<std::mutex> lock( this -> g_wake_mutex );
+		this -> g_f_running = false;
+	}
+	this -> g_wake.notify_all();
+	//If: thread was started
+	if (this -> g_thread.joinable() == true)
+	{
+		this -> g_thread.join();
+	}
+	fclose( this -> g_file );
+	this -> init();
+
+	//Trace Return
+	DRETURN();
+	return;	//OK
+}	//end method: close | void
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables to closed replay. Statistics are not touched
+/***************************************************************************/
+
+void Session_replay::init( void )
+{
+	this -> g_file = nullptr;
+	this -> g_f_realtime = false;
+	this -> g_rx_handler = nullptr;
+	this -> g_f_running = false;
+
+	return;	//OK
+}	//end method: init | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	worker | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Body of the replay thread
+//!	Algorithm:
+//!	>Read the next record. Stop at the end of the log or at a truncated record
+//!	>Real time: the record is due after the same gap as in the recording, gaps capped to SESSION_REPLAY_MAX_GAP_NS
+//!	>Real time: while waiting, call the handler with no data when its timeout expires, like Serial_thread
+//!	>Feed RX records to the handler
+//!	>At the end, honour the timeouts until the handler has nothing left to flush
+/***************************************************************************/
+
+void Session_replay::worker( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Bytes of a record
+	char buf[ SESSION_LOG_MAX_LENGTH ];
+	//Header of a record
+	Session_log_record record;
+	//Timestamp of the previous record in the log. -1 = none
+	int64_t record_prev_ns = -1;
+	//Gap from the previous record
+	int64_t gap_ns;
+	//When the current record is due
+	int64_t due_ns = this -> g_start_ns;
+	//Last call to the handler
+	int64_t call_ns = this -> g_start_ns;
+	//Timeout requested by the handler [ms]. -1 = none
+	int timeout = -1;
+	//Woken by close()
+	bool f_stop = false;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: thread is allowed to run and records are left
+	while ((f_stop == false) && (this -> g_f_running == true) && (Session_log::read_record( this -> g_file, record ) == false))
+	{
+		//If: truncated record. A crash during recording
+		if (fread( buf, 1, record.length, this -> g_file ) != record.length)
+		{
+			DPRINT("ERR: truncated record\n");
+			break;
+		}
+		//Gap in the recording. Cap silences and the jumps between appended sessions
+		gap_ns = (record_prev_ns < 0) ? (0) : (record.time_ns -record_prev_ns);
+		gap_ns = (gap_ns < 0) ? (0) : ((gap_ns > SESSION_REPLAY_MAX_GAP_NS) ? (SESSION_REPLAY_MAX_GAP_NS) : (gap_ns));
+		record_prev_ns = record.time_ns;
+		due_ns += gap_ns;
+		//If: bytes sent by the RPI. Only used for the pacing
+		if (record.direction != SESSION_LOG_RX)
+		{
+			continue;
+		}
+		//If: pace like the recording
+		if (this -> g_f_realtime == true)
+		{
+			//While: the handler timeout expires before the record is due
+			while ((f_stop == false) && (timeout >= 0) && (call_ns +timeout *NS_PER_MS < due_ns))
+			{
+				f_stop = this -> wait_until( call_ns +timeout *NS_PER_MS );
+				call_ns = Session_log::now_ns();
+				timeout = (f_stop == false) ? (this -> call_handler( buf, 0 )) : (-1);
+			}
+			f_stop |= this -> wait_until( due_ns );
+			//If: woken by close()
+			if (f_stop == true)
+			{
+				break;
+			}
+		}
+		//Feed the recorded read
+		call_ns = Session_log::now_ns();
+		timeout = this -> call_handler( buf, record.length );
+		this -> g_records++;
+		this -> g_bytes += record.length;
+	}	//End While: thread is allowed to run and records are left
+	//While: handler has events to flush
+	while ((f_stop == false) && (timeout >= 0))
+	{
+		f_stop = this -> wait_until( Session_log::now_ns() +timeout *NS_PER_MS );
+		timeout = (f_stop == false) ? (this -> call_handler( buf, 0 )) : (-1);
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Replay is over. Log stays open until close()
+	this -> g_end_ns = Session_log::now_ns();
+	this -> g_f_running = false;
+
+	//Trace Return
+	DRETURN_ARG("records: %u\n", (unsigned int)this -> g_records);
+	return;	//OK
+}	//end method: worker | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	wait_until | int64_t
+/***************************************************************************/
+//! @param deadline_ns | CLOCK_MONOTONIC deadline [ns]
+//! @return bool | false = deadline reached | true = woken by close()
+/***************************************************************************/
+
+bool Session_replay::wait_until( int64_t deadline_ns )
+{
+	//Time left
+	int64_t wait_ns = deadline_ns -Session_log::now_ns();
+
+	std::unique_lock<std::mutex> lock( this -> g_wake_mutex );
+	//If: time left. Return early if close() clears the flag
+	if (wait_ns > 0)
+	{
+		this -> g_wake.wait_for( lock, std::chrono::nanoseconds( wait_ns ), [this]{ return (this -> g_f_running == false); } );
+	}
+	return (this -> g_f_running == false);
+}	//end method: wait_until | int64_t
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	call_handler | const char *, int
+/***************************************************************************/
+//! @param data | bytes to feed
+//! @param length | number of bytes. 0 = timeout expired
+//! @return int | timeout requested by the handler [ms]. -1 = none
+/***************************************************************************/
+
+int Session_replay::call_handler( const char *data, int length )
+{
+	//Start of the call
+	int64_t start_ns = Session_log::now_ns();
+	//Timeout requested by the handler
+	int timeout = this -> g_rx_handler( data, length );
+
+	this -> g_handler_ns += Session_log::now_ns() -start_ns;
+	return timeout;
+}	//end method: call_handler | const char *, int
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
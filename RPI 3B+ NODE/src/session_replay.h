@@ -0,0 +1,201 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef SESSION_REPLAY_H_
+	#define SESSION_REPLAY_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+//Requires serial_thread.h to be included before. Serial_rx_handler
+//Requires session_log.h to be included before. Record format
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Longer silences of the recording are shortened to this in real time replay. Also bridges the jump between appended sessions [ns]
+#define SESSION_REPLAY_MAX_GAP_NS	1000000000LL
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Session_replay
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Feed a recorded session to the RX handler as if it came from the serial port
+//! @details
+//!	Stand in for Serial_thread. A dedicated thread reads the log and calls the same Serial_rx_handler \n
+//!	RX records are fed with the read sizes of the recording. TX records are skipped \n
+//!	Real time: records are paced like the recording and the handler timeouts are honoured \n
+//!	Max speed: records are fed back to back. Benchmark of the parser on production traffic \n
+//!	Time spent inside the handler is measured apart from the file reading
+//! @bug		None
+//! @warning	Linux only
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Session_replay
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Session_replay( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor. Stop the replay and join the thread
+		~Session_replay( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//RX records fed to the handler
+		uint32_t records( void );
+		//RX bytes fed to the handler
+		uint64_t bytes( void );
+		//Time since the replay started, until it ended [ns]
+		int64_t elapsed_ns( void );
+		//Time spent inside the handler [ns]
+		int64_t handler_ns( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = replay thread is feeding the handler
+		bool is_running( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Open a log and start the replay thread. false = OK
+		bool open( const char *path, bool f_realtime, Serial_rx_handler rx_handler );
+		//Stop the replay thread and close the log
+		void close( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+		//Body of the replay thread
+		void worker( void );
+		//Sleep until a CLOCK_MONOTONIC deadline. true = woken by close()
+		bool wait_until( int64_t deadline_ns );
+		//Call the handler and account the time spent in it
+		int call_handler( const char *data, int length );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Recorded session. nullptr = closed
+		FILE *g_file;
+		//Pace the records like the recording
+		bool g_f_realtime;
+		//Function that processes the replayed bytes
+		Serial_rx_handler g_rx_handler;
+		//Replay thread is running
+		std::atomic<bool> g_f_running;
+		//Wakes the replay thread from a wait
+		std::mutex g_wake_mutex;
+		std::condition_variable g_wake;
+		//Statistics. Written by the replay thread
+		std::atomic<uint32_t> g_records;
+		std::atomic<uint64_t> g_bytes;
+		std::atomic<int64_t> g_start_ns;
+		std::atomic<int64_t> g_end_ns;
+		std::atomic<int64_t> g_handler_ns;
+		//Replay thread
+		std::thread g_thread;
+
+};	//End Class: Session_replay
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,387 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Status_snapshot
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Triple buffer of platform status snapshots
+**	The parser publishes, get_status reads. No locks on either side
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_PANOPTICON
+#include "debug.h"
+//Platform status vars
+#include "panopticon.h"
+//Class Header
+#include "status_snapshot.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Middle buffer holds a snapshot the reader has not taken yet
+#define SNAPSHOT_FRESH_BIT		0x80
+//Index field of the middle buffer
+#define SNAPSHOT_INDEX_MASK		0x03
+
+/****************************************************************************
+**	LOCAL FUNCTIONS
+****************************************************************************/
+
+//Write a 32 bit value little endian
+static inline void put_u32_le( uint8_t *dst, uint32_t data )
+{
+	dst[0] = (uint8_t)(data >> 0);
+	dst[1] = (uint8_t)(data >> 8);
+	dst[2] = (uint8_t)(data >> 16);
+	dst[3] = (uint8_t)(data >> 24);
+}
+
+//Write a 64 bit floating point value little endian
+static inline void put_f64_le( uint8_t *dst, double data )
+{
+	uint64_t u64_tmp;
+	memcpy( &u64_tmp, &data, sizeof(u64_tmp) );
+	put_u32_le( &dst[0], (uint32_t)(u64_tmp >> 0) );
+	put_u32_le( &dst[4], (uint32_t)(u64_tmp >> 32) );
+}
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Status_snapshot | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Status_snapshot::Status_snapshot( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	generation | void
+/***************************************************************************/
+//! @return uint32_t | generation of the latest published snapshot
+//!	@details
+//!	Any thread. Meant to test for changes without reading the snapshot
+/***************************************************************************/
+
+uint32_t Status_snapshot::generation( void )
+{
+	return this -> g_generation.load( std::memory_order_acquire );
+}	//end getter: generation | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	publish | Panopticon &
+/***************************************************************************/
+//! @param platform | status vars updated by the parser handlers
+//! @return bool | true = content changed and a new generation was published
+//!	@details
+//!	Writer thread only. The caller must keep the status vars still during the copy
+//!	Nothing is published if the content is the same as the latest snapshot
+/***************************************************************************/
+
+bool Status_snapshot::publish( Panopticon &platform )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Counter
+	int t;
+	//Back buffer
+	Panopticon_snapshot &back = this -> g_buf[ this -> g_back ];
+	//Previous middle buffer
+	uint8_t prev;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//! Fill the back buffer
+	//Clear padding and unused signature bytes, so memcmp works
+	memset( &back, 0, sizeof(Panopticon_snapshot) );
+	strncpy( back.signature, platform.signature().c_str(), MAX_SIGNATURE_LENGTH );
+	for (t = 0;t < NUM_VNH7040PWM;t++)
+	{
+		back.pwm[t] = platform.pwm( t );
+		back.pwm_max[t] = platform.pwm_max( t );
+		back.pwm_accel[t] = platform.pwm_accel( t );
+		back.pwm_decel[t] = platform.pwm_decel( t );
+		back.current[t] = platform.current( t );
+		back.diag[t] = platform.diag( t );
+	}
+	for (t = 0;t < CFG_NUM_ID;t++)
+	{
+		back.config[t] = platform.config( t );
+	}
+	back.config_crc = platform.config_crc();
+	for (t = 0;t < NUM_ENC;t++)
+	{
+		back.enc_pos[t] = platform.enc_pos( t );
+		back.enc_spd[t] = platform.enc_spd( t );
+		back.enc_pos_time[t] = platform.enc_pos_time( t );
+	}
+	back.enc_spd_time = platform.enc_spd_time();
+	back.current_time = platform.current_time();
+	back.current_limit = platform.current_limit();
+	back.stall_current = platform.stall_current();
+	back.stall_ticks = platform.stall_ticks();
+	back.ctrl_tick_us = platform.ctrl_tick_us();
+	back.odom_x = platform.odom_x();
+	back.odom_y = platform.odom_y();
+	back.odom_heading = platform.odom_heading();
+	//If: same content as the latest snapshot
+	back.generation = this -> g_last.generation;
+	if (memcmp( &back, &this -> g_last, sizeof(Panopticon_snapshot) ) == 0)
+	{
+		DRETURN_ARG("unchanged\n");
+		return false;	//OK
+	}
+
+	//! Publish
+	back.generation++;
+	memcpy( &this -> g_last, &back, sizeof(Panopticon_snapshot) );
+	//Hand the back buffer to the reader and take the old middle buffer as new back buffer
+	prev = this -> g_middle.exchange( this -> g_back | SNAPSHOT_FRESH_BIT, std::memory_order_acq_rel );
+	this -> g_back = prev & SNAPSHOT_INDEX_MASK;
+	//Advertise the new generation
+	this -> g_generation.store( this -> g_last.generation, std::memory_order_release );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN_ARG("generation: %d\n", this -> g_last.generation);
+	return true;	//OK
+}	//end method: publish | Panopticon &
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	read | void
+/***************************************************************************/
+//! @return const Panopticon_snapshot & | latest published snapshot
+//!	@details
+//!	Reader thread only. If the writer left a fresh buffer in the middle, take it
+/***************************************************************************/
+
+const Panopticon_snapshot &Status_snapshot::read( void )
+{
+	//Previous middle buffer
+	uint8_t prev;
+	//If: a fresh snapshot is waiting
+	if ((this -> g_middle.load( std::memory_order_relaxed ) & SNAPSHOT_FRESH_BIT) != 0)
+	{
+		//Give the old front buffer to the writer and take the fresh one
+		prev = this -> g_middle.exchange( this -> g_front, std::memory_order_acq_rel );
+		this -> g_front = prev & SNAPSHOT_INDEX_MASK;
+	}
+
+	return this -> g_buf[ this -> g_front ];
+}	//end method: read | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	to_array | const Panopticon_snapshot &, int32_t *
+/***************************************************************************/
+//! @param snapshot | source snapshot
+//! @param array | destination. At least STATUS_ARRAY_SIZE elements
+//! @return void
+//!	@details
+//!	Flatten the numeric fields. The signature is not copied
+/***************************************************************************/
+
+void Status_snapshot::to_array( const Panopticon_snapshot &snapshot, int32_t *array )
+{
+	//Counter
+	int t;
+
+	array[STATUS_ARRAY_GENERATION] = (int32_t)snapshot.generation;
+	for (t = 0;t < NUM_VNH7040PWM;t++)
+	{
+		array[STATUS_ARRAY_PWM +t] = snapshot.pwm[t];
+		array[STATUS_ARRAY_PWM_MAX +t] = snapshot.pwm_max[t];
+		array[STATUS_ARRAY_PWM_ACCEL +t] = snapshot.pwm_accel[t];
+		array[STATUS_ARRAY_PWM_DECEL +t] = snapshot.pwm_decel[t];
+		array[STATUS_ARRAY_CURRENT +t] = snapshot.current[t];
+		array[STATUS_ARRAY_DIAG +t] = snapshot.diag[t];
+	}
+	for (t = 0;t < NUM_ENC;t++)
+	{
+		array[STATUS_ARRAY_ENC_POS +t] = snapshot.enc_pos[t];
+		array[STATUS_ARRAY_ENC_SPD +t] = snapshot.enc_spd[t];
+	}
+
+	return;
+}	//end method: to_array | const Panopticon_snapshot &, int32_t *
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	to_frame | const Panopticon_snapshot &, uint32_t, double, uint8_t *
+/***************************************************************************/
+//! @param snapshot | source snapshot
+//! @param sequence | frame sequence number
+//! @param timestamp | ms since 1970-01-01
+//! @param frame | destination. At least STATUS_FRAME_SIZE bytes
+//! @return void
+//!	@details
+//!	Fixed little endian layout described in status_snapshot.h
+//!	The browser decodes it with a DataView
+/***************************************************************************/
+
+void Status_snapshot::to_frame( const Panopticon_snapshot &snapshot, uint32_t sequence, double timestamp, uint8_t *frame )
+{
+	//Counter
+	int t;
+	//Numeric fields in STATUS_ARRAY layout
+	int32_t array[ STATUS_ARRAY_SIZE ];
+
+	//! Header
+	put_u32_le( &frame[0], sequence );
+	put_u32_le( &frame[4], snapshot.generation );
+	put_f64_le( &frame[8], timestamp );
+	frame[16] = STATUS_FRAME_VERSION;
+	frame[17] = NUM_VNH7040PWM;
+	frame[18] = NUM_ENC;
+	frame[19] = (uint8_t)strnlen( snapshot.signature, MAX_SIGNATURE_LENGTH );
+	//! Numeric fields. Skip the generation, already in the header
+	to_array( snapshot, array );
+	for (t = 1;t < STATUS_ARRAY_SIZE;t++)
+	{
+		put_u32_le( &frame[ STATUS_FRAME_HEADER_SIZE +4*(t -1) ], (uint32_t)array[t] );
+	}
+	//! Signature. Snapshot is '\0' padded
+	memcpy( &frame[ STATUS_FRAME_SIGNATURE ], snapshot.signature, MAX_SIGNATURE_LENGTH );
+
+	return;
+}	//end method: to_frame | const Panopticon_snapshot &, uint32_t, double, uint8_t *
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables. All buffers empty, generation 0
+/***************************************************************************/
+
+void Status_snapshot::init( void )
+{
+	//Clear buffers
+	memset( this -> g_buf, 0, sizeof(this -> g_buf) );
+	memset( &this -> g_last, 0, sizeof(this -> g_last) );
+	//Buffer 0 front, 1 middle, 2 back
+	this -> g_front = 0;
+	this -> g_middle = 1;
+	this -> g_back = 2;
+	//Never published
+	this -> g_generation = 0;
+
+	return;	//OK
+}	//end method: init | void
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,254 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef STATUS_SNAPSHOT_H_
+	#define STATUS_SNAPSHOT_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+#include <atomic>
+//Requires panopticon.h to be included before. NUM_ENC, NUM_VNH7040PWM, Panopticon
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+	//! Layout of the status Int32Array shared with NODE.JS. Index of the first element of each field
+//Snapshot generation. Read it as (array[0] >>> 0) in JS
+#define STATUS_ARRAY_GENERATION		0
+//PWM of each motor channel
+#define STATUS_ARRAY_PWM			(STATUS_ARRAY_GENERATION +1)
+//Encoder absolute position
+#define STATUS_ARRAY_ENC_POS		(STATUS_ARRAY_PWM +NUM_VNH7040PWM)
+//Encoder speed
+#define STATUS_ARRAY_ENC_SPD		(STATUS_ARRAY_ENC_POS +NUM_ENC)
+//PWM slew rate limiter parameters
+#define STATUS_ARRAY_PWM_MAX		(STATUS_ARRAY_ENC_SPD +NUM_ENC)
+#define STATUS_ARRAY_PWM_ACCEL		(STATUS_ARRAY_PWM_MAX +NUM_VNH7040PWM)
+#define STATUS_ARRAY_PWM_DECEL		(STATUS_ARRAY_PWM_ACCEL +NUM_VNH7040PWM)
+//Filtered motor current [mA]
+#define STATUS_ARRAY_CURRENT		(STATUS_ARRAY_PWM_DECEL +NUM_VNH7040PWM)
+//Fault code of the motor drivers. DIAG_* bit field
+#define STATUS_ARRAY_DIAG			(STATUS_ARRAY_CURRENT +NUM_VNH7040PWM)
+//Number of elements
+#define STATUS_ARRAY_SIZE			(STATUS_ARRAY_DIAG +NUM_VNH7040PWM)
+
+	//! Layout of the binary status frame sent to the browsers. All fields little endian
+	//	| 0		| u32	| sequence. Incremented for each frame
+	//	| 4		| u32	| generation of the snapshot
+	//	| 8		| f64	| timestamp [ms] since 1970-01-01. Server clock when the frame was built
+	//	| 16	| u8	| STATUS_FRAME_VERSION
+	//	| 17	| u8	| number of pwm channels
+	//	| 18	| u8	| number of encoder channels
+	//	| 19	| u8	| length of the signature
+	//	| 20	| s32[]	| status array without generation. Same order as the STATUS_ARRAY layout
+	//	| ...	| char[]| signature, MAX_SIGNATURE_LENGTH bytes, '\0' padded
+//Version of the layout. Raise when the layout changes
+#define STATUS_FRAME_VERSION		3
+//Size of the header
+#define STATUS_FRAME_HEADER_SIZE	20
+//Offset of the signature
+#define STATUS_FRAME_SIGNATURE		(STATUS_FRAME_HEADER_SIZE +4*(STATUS_ARRAY_SIZE -1))
+//Size of the frame
+#define STATUS_FRAME_SIZE			(STATUS_FRAME_SIGNATURE +MAX_SIGNATURE_LENGTH)
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//! Plain copy of the Panopticon status vars. Can be copied with memcpy and compared with memcmp
+typedef struct _Panopticon_snapshot
+{
+	//Incremented each time a snapshot with different content is published. 0 = never published
+	uint32_t generation;
+	//Board signature. Always '\0' terminated
+	char signature[ MAX_SIGNATURE_LENGTH +1 ];
+	//Latest PWM packet reading
+	int pwm[ NUM_VNH7040PWM ];
+	//Encoder channel readings
+	int enc_pos[ NUM_ENC ];
+	//Encoder speed reading
+	int enc_spd[ NUM_ENC ];
+	//PWM slew rate limiter parameters
+	int pwm_max[ NUM_VNH7040PWM ];
+	int pwm_accel[ NUM_VNH7040PWM ];
+	int pwm_decel[ NUM_VNH7040PWM ];
+	//Filtered motor current [mA]
+	int current[ NUM_VNH7040PWM ];
+	//Current limiter and stall detector parameters. [mA], [mA], [control ticks]
+	int current_limit;
+	int stall_current;
+	int stall_ticks;
+	//Period of the control system [us]. 0 = not reported yet
+	int ctrl_tick_us;
+	//Fault code of the motor drivers. DIAG_* bit field
+	int diag[ NUM_VNH7040PWM ];
+	//Configuration parameters of the board. CFG_* id
+	int config[ CFG_NUM_ID ];
+	//CRC16 of the last configuration saved in EEPROM. -1 = none
+	int config_crc;
+	//Odometry pose. x, y [mm], heading [rad]
+	double odom_x;
+	double odom_y;
+	double odom_heading;
+	//Sampling time of the encoder readings. RPI CLOCK_MONOTONIC [ms]. 0 = never
+	double enc_pos_time[ NUM_ENC ];
+	double enc_spd_time;
+	//Sampling time of the motor currents. RPI CLOCK_MONOTONIC [ms]. 0 = never
+	double current_time;
+} Panopticon_snapshot;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Status_snapshot
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Hand consistent copies of the platform status from the parser to NODE.JS
+//! @details
+//!	Triple buffer. One writer (parser) and one reader (NODE.JS thread) \n
+//!	Writer fills the back buffer, then swaps it with the middle buffer \n
+//!	Reader swaps the middle buffer with the front buffer if a fresh one is waiting \n
+//!	Neither side waits and the reader never sees a half written snapshot \n
+//!	generation() can be read from any thread to test for changes without copying
+//! @bug		None
+//! @warning	Exactly one writer and one reader thread
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Status_snapshot
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Status_snapshot( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Generation of the latest published snapshot
+		uint32_t generation( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Writer: copy the status vars and publish them if they changed. true = published
+		bool publish( Panopticon &platform );
+		//Reader: latest published snapshot. Valid until the next call to read
+		const Panopticon_snapshot &read( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Copy the numeric fields of a snapshot into an array with the STATUS_ARRAY layout
+		static void to_array( const Panopticon_snapshot &snapshot, int32_t *array );
+		//Serialize a snapshot into a binary frame with the STATUS_FRAME layout
+		static void to_frame( const Panopticon_snapshot &snapshot, uint32_t sequence, double timestamp, uint8_t *frame );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Three buffers. Back is owned by the writer, front by the reader, middle is exchanged
+		Panopticon_snapshot g_buf[3];
+		//Writer side copy of the latest published content. Used to detect changes
+		Panopticon_snapshot g_last;
+		//Index of the middle buffer. Bit 7 is raised when the writer left a fresh buffer there
+		std::atomic<uint8_t> g_middle;
+		//Index of the back buffer. Writer only
+		uint8_t g_back;
+		//Index of the front buffer. Reader only
+		uint8_t g_front;
+		//Generation of the latest published snapshot
+		std::atomic<uint32_t> g_generation;
+
+};	//End Class: Status_snapshot
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,437 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Telemetry_stats
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Freshness of the telemetry from the motor board
+**	Per message type log2 histograms of latency and inter arrival time
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+//Debug trace log
+//#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_OTHER
+#include "debug.h"
+//Platform configuration. TIMESTAMP_HZ
+#include "../../orangebot_config.h"
+//Class Header
+#include "telemetry_stats.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Nanoseconds in a second
+#define NS_PER_S			1000000000LL
+
+/****************************************************************************
+**	LOCAL FUNCTIONS
+****************************************************************************/
+
+//Add a time [us] to minimum, maximum, sum and histogram. count is the number of samples before this one
+static inline void add_sample( int64_t time_us, uint32_t count, int64_t &min_us, int64_t &max_us, int64_t &sum_us, uint32_t *hist )
+{
+	min_us = ((count == 0) || (time_us < min_us)) ? (time_us) : (min_us);
+	max_us = ((count == 0) || (time_us > max_us)) ? (time_us) : (max_us);
+	sum_us += time_us;
+	hist[ Telemetry_stats::hist_bin( time_us ) ]++;
+}
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Telemetry_stats | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Telemetry_stats::Telemetry_stats( void )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Initialize class variables
+	this -> init();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	type_stats | int
+/***************************************************************************/
+//! @param type | Telemetry_type
+//! @return const Telemetry_type_stats * | statistics of the type. NULL for a bad type
+/***************************************************************************/
+
+const Telemetry_type_stats *Telemetry_stats::type_stats( int type ) const
+{
+	//If: bad type
+	if ((type < 0) || (type >= TELEMETRY_NUM_TYPES))
+	{
+		return nullptr;	//FAIL
+	}
+	return &this -> g_type[ type ];
+}	//end getter: type_stats | int
+
+/***************************************************************************/
+//!	@brief Getter
+//!	lost | void
+/***************************************************************************/
+//! @return uint32_t | messages lost according to the sequence numbers
+/***************************************************************************/
+
+uint32_t Telemetry_stats::lost( void ) const
+{
+	return this -> g_lost;
+}	//end getter: lost | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	timestamps | void
+/***************************************************************************/
+//! @return uint32_t | TIME messages received
+/***************************************************************************/
+
+uint32_t Telemetry_stats::timestamps( void ) const
+{
+	return this -> g_timestamps;
+}	//end getter: timestamps | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	offset_ns | void
+/***************************************************************************/
+//! @return int64_t | RPI time -firmware time [ns] of the fastest recent message
+/***************************************************************************/
+
+int64_t Telemetry_stats::offset_ns( void ) const
+{
+	return (this -> g_offset_min_cur < this -> g_offset_min_prev) ? (this -> g_offset_min_cur) : (this -> g_offset_min_prev);
+}	//end getter: offset_ns | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	Clear all statistics and restart the clock offset filter
+/***************************************************************************/
+
+void Telemetry_stats::reset( void )
+{
+	this -> init();
+	return;
+}	//end method: reset | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	timestamp | uint32_t, uint8_t
+/***************************************************************************/
+//! @param timestamp | firmware RTC tick when the data of the next message was sampled
+//! @param sequence | sequence number of the next message
+//! @return void
+//!	@details
+//!	Unwrap the 32 bit timestamp and count the gaps in the sequence
+/***************************************************************************/
+
+void Telemetry_stats::timestamp( uint32_t timestamp, uint8_t sequence )
+{
+	//Trace Enter
+	DENTER_ARG("timestamp: %u | sequence: %u\n", timestamp, sequence);
+
+	//! Unwrap. Difference modulo 2^32 survives the counter wrapping
+	if (this -> g_timestamps == 0)
+	{
+		this -> g_stamp = timestamp;
+	}
+	else
+	{
+		this -> g_stamp += (int32_t)(timestamp -this -> g_stamp_last);
+	}
+	this -> g_stamp_last = timestamp;
+	this -> g_f_stamp_pending = true;
+	this -> g_timestamps++;
+
+	//! Lost messages
+	//If: not the expected sequence number
+	if ((this -> g_sequence_next >= 0) && (sequence != this -> g_sequence_next))
+	{
+		this -> g_lost += (uint8_t)(sequence -this -> g_sequence_next);
+	}
+	this -> g_sequence_next = (uint8_t)(sequence +1);
+
+	//Trace Return
+	DRETURN();
+	return;
+}	//end method: timestamp | uint32_t, uint8_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	record | int, int64_t, int64_t
+/***************************************************************************/
+//! @param type | Telemetry_type of the message
+//! @param arrival_ns | CLOCK_MONOTONIC when the bytes were read from the serial port
+//! @param sample_ns | CLOCK_MONOTONIC when the firmware sampled the data. -1 = clocks not synchronized
+//! @return bool | false = OK | true = bad type
+//!	@details
+//!	Inter arrival is always recorded
+//!	Latency only if a TIME message came just before this message
+/***************************************************************************/
+
+bool Telemetry_stats::record( int type, int64_t arrival_ns, int64_t sample_ns )
+{
+	//Trace Enter
+	DENTER_ARG("type: %d\n", type);
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Firmware sampling time [ns] on the firmware clock
+	int64_t stamp_ns;
+	//Arrival -sampling [ns]
+	int64_t delta_ns;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//If: bad type
+	if ((type < 0) || (type >= TELEMETRY_NUM_TYPES))
+	{
+		DRETURN_ARG("ERR: bad type\n");
+		return true;	//FAIL
+	}
+	Telemetry_type_stats &stats = this -> g_type[ type ];
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//! Inter arrival
+	//If: not the first message of this type
+	if (stats.last_arrival_ns != 0)
+	{
+		add_sample( (arrival_ns -stats.last_arrival_ns) /1000, stats.count -1, stats.interarrival_min_us, stats.interarrival_max_us, stats.interarrival_sum_us, stats.interarrival_hist );
+	}
+	stats.last_arrival_ns = arrival_ns;
+	stats.count++;
+
+	//! Latency
+	//If: message was stamped
+	if (this -> g_f_stamp_pending == true)
+	{
+		this -> g_f_stamp_pending = false;
+		//Ticks to ns. Split to stay inside 64 bit for any uptime
+		stamp_ns = (this -> g_stamp /TIMESTAMP_HZ) *NS_PER_S +(this -> g_stamp %TIMESTAMP_HZ) *NS_PER_S /TIMESTAMP_HZ;
+		delta_ns = arrival_ns -stamp_ns;
+		//Keep the offset filter running, it is the fallback if the synchronization is lost
+		delta_ns -= this -> update_offset( delta_ns, arrival_ns );
+		//If: clocks are synchronized. Absolute latency. Mapping error can make it slightly negative
+		if (sample_ns >= 0)
+		{
+			delta_ns = (arrival_ns > sample_ns) ? (arrival_ns -sample_ns) : (0);
+		}
+		add_sample( delta_ns /1000, stats.count_stamped, stats.latency_min_us, stats.latency_max_us, stats.latency_sum_us, stats.latency_hist );
+		stats.count_stamped++;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+	return false;	//OK
+}	//end method: record | int, int64_t, int64_t
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	now_ns | void
+/***************************************************************************/
+//! @return int64_t | CLOCK_MONOTONIC [ns]
+/***************************************************************************/
+
+int64_t Telemetry_stats::now_ns( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec *NS_PER_S +ts.tv_nsec;
+}	//end method: now_ns | void
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	hist_bin | int64_t
+/***************************************************************************/
+//! @param time_us | time [us]
+//! @return int | histogram bin. Floor of log2, clipped to the histogram
+/***************************************************************************/
+
+int Telemetry_stats::hist_bin( int64_t time_us )
+{
+	//Bin
+	int bin = 0;
+	//Shift out one bit per bin
+	while ((time_us > 1) && (bin < TELEMETRY_HIST_SIZE -1))
+	{
+		time_us >>= 1;
+		bin++;
+	}
+	return bin;
+}	//end method: hist_bin | int64_t
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Initialize class variables
+/***************************************************************************/
+
+void Telemetry_stats::init( void )
+{
+	//Clear the per type statistics
+	memset( this -> g_type, 0, sizeof(this -> g_type) );
+	this -> g_f_stamp_pending = false;
+	this -> g_stamp = 0;
+	this -> g_stamp_last = 0;
+	this -> g_sequence_next = -1;
+	this -> g_lost = 0;
+	this -> g_timestamps = 0;
+	this -> g_offset_min_cur = 0;
+	this -> g_offset_min_prev = 0;
+	this -> g_offset_window_start = 0;
+
+	return;	//OK
+}	//end method: init | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	update_offset | int64_t, int64_t
+/***************************************************************************/
+//! @param delta_ns | arrival -firmware sampling time of this message [ns]
+//! @param arrival_ns | arrival of this message [ns]
+//! @return int64_t | offset between the clocks [ns]
+//!	@details
+//!	Minimum over the current and previous window. Two windows so the estimate never starts from a single sample
+//!	Windows are short so the drift of the RTC oscillator moves the offset little within one
+/***************************************************************************/
+
+int64_t Telemetry_stats::update_offset( int64_t delta_ns, int64_t arrival_ns )
+{
+	//If: filter is empty
+	if (this -> g_offset_window_start == 0)
+	{
+		this -> g_offset_min_cur = delta_ns;
+		this -> g_offset_min_prev = delta_ns;
+		this -> g_offset_window_start = arrival_ns;
+	}
+	//If: current window is over
+	else if (arrival_ns -this -> g_offset_window_start >= TELEMETRY_OFFSET_WINDOW_NS)
+	{
+		this -> g_offset_min_prev = this -> g_offset_min_cur;
+		this -> g_offset_min_cur = delta_ns;
+		this -> g_offset_window_start = arrival_ns;
+	}
+	//If: faster message in this window
+	else if (delta_ns < this -> g_offset_min_cur)
+	{
+		this -> g_offset_min_cur = delta_ns;
+	}
+
+	return this -> offset_ns();
+}	//end method: update_offset | int64_t, int64_t
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
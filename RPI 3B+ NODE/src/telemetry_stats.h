@@ -0,0 +1,227 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef TELEMETRY_STATS_H_
+	#define TELEMETRY_STATS_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+//Requires orangebot_config.h (through panopticon.h) to be included before. TIMESTAMP_HZ
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Number of log2 histogram bins. Bin 0 holds [0, 2us), bin n holds [2^n, 2^(n+1)) us. Last bin holds everything above 8s
+#define TELEMETRY_HIST_SIZE			24
+//Length of one window of the minimum filter that estimates the clock offset [ns]
+#define TELEMETRY_OFFSET_WINDOW_NS	1000000000LL
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//! Telemetry messages tracked by the statistics
+typedef enum _Telemetry_type
+{
+	TELEMETRY_ENC_ABS,		//ENC_ABS single encoder position
+	TELEMETRY_ENC_REL,		//ENC_REL encoder position change
+	TELEMETRY_ENC_SPD,		//ENC_SPD and ENC_SPD_DUAL encoder speed
+	TELEMETRY_CURRENT,		//CUR motor current
+	TELEMETRY_NUM_TYPES
+} Telemetry_type;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//! Statistics of one telemetry message type. Times in microseconds
+typedef struct _Telemetry_type_stats
+{
+	//Messages received
+	uint32_t count;
+	//Messages received with a firmware timestamp
+	uint32_t count_stamped;
+	//Latency from firmware sampling to arrival on the RPI
+	int64_t latency_min_us;
+	int64_t latency_max_us;
+	int64_t latency_sum_us;
+	uint32_t latency_hist[ TELEMETRY_HIST_SIZE ];
+	//Time between two messages of the same type, measured on the RPI
+	int64_t interarrival_min_us;
+	int64_t interarrival_max_us;
+	int64_t interarrival_sum_us;
+	uint32_t interarrival_hist[ TELEMETRY_HIST_SIZE ];
+	//Arrival of the last message [ns] CLOCK_MONOTONIC. 0 = none yet
+	int64_t last_arrival_ns;
+} Telemetry_type_stats;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Telemetry_stats
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2020-02-01
+//! @brief		Latency and inter arrival histograms of the telemetry from the motor board
+//! @details
+//!	The firmware sends TIME<timestamp>:<sequence> before each telemetry message \n
+//!	Timestamp is the RTC tick when the data was sampled, arrival is CLOCK_MONOTONIC on the RPI \n
+//!	With the clocks synchronized the caller passes the sampling time on the RPI clock and latency is absolute \n
+//!	Otherwise the offset is the smallest (arrival -timestamp) seen in the last one to two windows \n
+//!	and latency is measured from the fastest recent message: queueing in the firmware, UART, kernel and parser \n
+//!	Gaps in the sequence count the messages lost on the way \n
+//!	Plain data. Can be copied to hand a consistent view to another thread
+//! @bug		None
+//! @warning	Not thread safe. Owner serializes access
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Telemetry_stats
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Telemetry_stats( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Statistics of a message type. NULL for a bad type
+		const Telemetry_type_stats *type_stats( int type ) const;
+		//Messages lost according to the sequence numbers
+		uint32_t lost( void ) const;
+		//TIME messages received
+		uint32_t timestamps( void ) const;
+		//Current estimate of the offset between the clocks [ns]. RPI time = firmware time +offset
+		int64_t offset_ns( void ) const;
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Clear all statistics
+		void reset( void );
+		//A TIME message arrived. The next telemetry message carries this timestamp
+		void timestamp( uint32_t timestamp, uint8_t sequence );
+		//A telemetry message arrived. sample_ns = RPI time of the firmware sampling, -1 = unknown. false = OK | true = bad type
+		bool record( int type, int64_t arrival_ns, int64_t sample_ns = -1 );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//CLOCK_MONOTONIC [ns]
+		static int64_t now_ns( void );
+		//Histogram bin of a time [us]
+		static int hist_bin( int64_t time_us );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Initialize class variables
+		void init( void );
+		//Feed the clock offset filter. Return the offset to use for this sample
+		int64_t update_offset( int64_t delta_ns, int64_t arrival_ns );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Statistics of each message type
+		Telemetry_type_stats g_type[ TELEMETRY_NUM_TYPES ];
+		//A TIME message is waiting for its telemetry message
+		bool g_f_stamp_pending;
+		//Pending timestamp unwrapped to 64 bit [ticks]
+		int64_t g_stamp;
+		//Last raw timestamp, to unwrap the 32 bit counter
+		uint32_t g_stamp_last;
+		//Sequence number expected next. -1 = none received yet
+		int g_sequence_next;
+		//Messages lost
+		uint32_t g_lost;
+		//TIME messages received
+		uint32_t g_timestamps;
+		//Minimum (arrival -timestamp) of the current and of the previous window [ns]
+		int64_t g_offset_min_cur;
+		int64_t g_offset_min_prev;
+		//Start of the current window [ns]. 0 = filter empty
+		int64_t g_offset_window_start;
+
+};	//End Class: Telemetry_stats
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,385 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	Trace
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Binary trace backend of debug.h. Compiled in with ENABLE_TRACE
+**	Each thread owns a ring of fixed size records: point id, timestamp, raw arguments
+**	Nothing is formatted at run time. tools/trace_decode resolves the dump offline
+**	Each module has a level set at run time. Points above it are skipped before touching the ring
+**	Dump format, native little endian:
+**	>"OBTR", version U16, reserved U16
+**	>points U32, then for each point: id U16, kind U8, module U8, line U32, file, function, format
+**	>each string: length U16, then the chars. No terminator
+**	>records U32, then the Trace_record structures in ring order
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <vector>
+//gettid
+#include <unistd.h>
+#include <sys/syscall.h>
+//No debug.h. The trace backend can't trace itself
+#include "trace.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace Orangebot
+{
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//! Records of one thread. Written by its owner only, read by the dump
+typedef struct _Trace_ring
+{
+	//Records written so far. Slot = head % TRACE_RING_SIZE. Published with release after the record
+	std::atomic<uint32_t> head;
+	//A live thread owns the ring
+	std::atomic<bool> f_owned;
+	//Records
+	Trace_record record[ TRACE_RING_SIZE ];
+} Trace_ring;
+
+//! Ring owned by the calling thread. Released when the thread exits
+class Trace_thread
+{
+	public:
+		//Ring of the thread. nullptr = not claimed yet or none available
+		Trace_ring *ring = nullptr;
+		//Linux thread id
+		uint32_t tid = 0;
+		//Thread exit. Another thread can reuse the ring, its records are kept
+		~Trace_thread( void )
+		{
+			if (this -> ring != nullptr)
+			{
+				this -> ring -> f_owned.store( false, std::memory_order_release );
+			}
+		}
+};
+
+/****************************************************************************
+**	GLOBAL VARIABILE
+****************************************************************************/
+
+//Rings. Allocated on first claim, never freed
+std::atomic<Trace_ring *> g_trace_ring[ TRACE_MAX_RINGS ];
+//Registered points. Index is the id
+Trace_point *g_trace_point[ TRACE_MAX_POINTS ];
+//Next free id. 0 is TRACE_ID_NONE
+uint16_t g_trace_num_points = 1;
+//Held to register a point, claim a ring or dump
+std::mutex g_trace_mutex;
+//Records lost because all rings were taken
+std::atomic<uint32_t> g_trace_dropped( 0 );
+//Ring of the calling thread
+thread_local Trace_thread g_trace_thread;
+//Level of each module
+std::atomic<uint8_t> g_trace_level[ TRACE_NUM_MODULES ] = { {TRACE_LEVEL_DEFAULT}, {TRACE_LEVEL_DEFAULT}, {TRACE_LEVEL_DEFAULT}, {TRACE_LEVEL_DEFAULT}, {TRACE_LEVEL_DEFAULT}, {TRACE_LEVEL_DEFAULT} };
+
+/****************************************************************************
+**	LOCAL FUNCTIONS
+****************************************************************************/
+
+//Claim a free ring for the calling thread. nullptr = none left
+static Trace_ring *trace_claim_ring( void )
+{
+	std::lock_guard<std::mutex> lock( g_trace_mutex );
+	//For: each ring slot
+	for (int t = 0;t < TRACE_MAX_RINGS;t++)
+	{
+		Trace_ring *ring = g_trace_ring[t].load( std::memory_order_acquire );
+		//If: empty slot. Allocate
+		if (ring == nullptr)
+		{
+			ring = new Trace_ring;
+			ring -> head.store( 0, std::memory_order_relaxed );
+			ring -> f_owned.store( true, std::memory_order_relaxed );
+			g_trace_ring[t].store( ring, std::memory_order_release );
+			return ring;
+		}
+		//If: ring of a thread that exited. Keep appending, records of both threads stay in the dump
+		else if (ring -> f_owned.load( std::memory_order_acquire ) == false)
+		{
+			ring -> f_owned.store( true, std::memory_order_relaxed );
+			return ring;
+		}
+	}
+	return nullptr;
+}
+
+//Give an id to a point on its first record
+static void trace_register( Trace_point &point, const char *format )
+{
+	std::lock_guard<std::mutex> lock( g_trace_mutex );
+	//If: another thread registered it meanwhile
+	if (point.id.load( std::memory_order_relaxed ) != TRACE_ID_NONE)
+	{
+		return;
+	}
+	//Literal of the call site, same at every call
+	point.format = format;
+	//If: table is full
+	if (g_trace_num_points >= TRACE_MAX_POINTS)
+	{
+		point.id.store( TRACE_ID_OVERFLOW, std::memory_order_release );
+		return;
+	}
+	g_trace_point[ g_trace_num_points ] = &point;
+	point.id.store( g_trace_num_points, std::memory_order_release );
+	g_trace_num_points++;
+	return;
+}
+
+//Write a string as length and chars
+static bool trace_put_string( FILE *file, const char *str )
+{
+	uint16_t length = (str != nullptr) ? ((uint16_t)strlen( str )) : (0);
+	return ((fwrite( &length, sizeof(length), 1, file ) != 1) || (fwrite( str, 1, length, file ) != length));
+}
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	trace_write | Trace_point &, const char *, const uint64_t *, int
+/***************************************************************************/
+//! @param point | static descriptor of the call site
+//! @param format | printf format of the arguments. nullptr = none
+//! @param arg | raw arguments
+//! @param num_args | number of arguments
+//! @return void
+//!	@details
+//!	Hot path: one relaxed load of the id, clock read, record copy, release store of the head
+//!	Mutex only on the first record of a point and on the first record of a thread
+/***************************************************************************/
+
+void trace_write( Trace_point &point, const char *format, const uint64_t *arg, int num_args )
+{
+	//Id of the point
+	uint16_t id = point.id.load( std::memory_order_acquire );
+	//Ring of this thread
+	Trace_ring *ring = g_trace_thread.ring;
+
+	//If: first record of the point
+	if (id == TRACE_ID_NONE)
+	{
+		trace_register( point, format );
+		id = point.id.load( std::memory_order_acquire );
+	}
+	//If: first record of the thread
+	if (ring == nullptr)
+	{
+		ring = trace_claim_ring();
+		g_trace_thread.ring = ring;
+		g_trace_thread.tid = (uint32_t)syscall( SYS_gettid );
+	}
+	//If: no ring or no id left
+	if ((ring == nullptr) || (id == TRACE_ID_OVERFLOW))
+	{
+		g_trace_dropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+	//Fill the next slot. Only this thread writes the ring
+	uint32_t head = ring -> head.load( std::memory_order_relaxed );
+	Trace_record &record = ring -> record[ head & (TRACE_RING_SIZE -1) ];
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	record.point = id;
+	record.num_args = (uint8_t)((num_args > TRACE_MAX_ARGS) ? (TRACE_MAX_ARGS) : (num_args));
+	record.reserved = 0;
+	record.tid = g_trace_thread.tid;
+	record.time_ns = (int64_t)ts.tv_sec *1000000000LL +ts.tv_nsec;
+	for (int t = 0;t < record.num_args;t++)
+	{
+		record.arg[t] = arg[t];
+	}
+	//Publish
+	ring -> head.store( head +1, std::memory_order_release );
+
+	return;
+}	//end function: trace_write | Trace_point &, const char *, const uint64_t *, int
+
+/***************************************************************************/
+//!	@brief Function
+//!	trace_dump | const char *
+/***************************************************************************/
+//! @param path | name of the dump file
+//! @return bool | false = OK | true = FAIL
+//!	@details
+//!	Threads keep tracing while the dump runs
+//!	A ring is copied, then its head is read again. Slots overwritten during the copy are discarded
+/***************************************************************************/
+
+bool trace_dump( const char *path )
+{
+	//Dump file
+	FILE *file;
+	//Copy of the records
+	std::vector<Trace_record> records;
+	//File header
+	uint16_t header[2] = { TRACE_VERSION, 0 };
+	//Failure
+	bool f_ret = false;
+
+	//If: bad path or failed to open
+	if ((path == nullptr) || ((file = fopen( path, "wb" )) == nullptr))
+	{
+		return true;	//FAIL
+	}
+	std::lock_guard<std::mutex> lock( g_trace_mutex );
+	//Header
+	f_ret |= (fwrite( TRACE_MAGIC, 1, 4, file ) != 4);
+	f_ret |= (fwrite( header, sizeof(header), 1, file ) != 1);
+	//Points
+	uint32_t num_points = g_trace_num_points -1;
+	f_ret |= (fwrite( &num_points, sizeof(num_points), 1, file ) != 1);
+	for (uint16_t t = 1;t < g_trace_num_points;t++)
+	{
+		const Trace_point &point = *g_trace_point[t];
+		uint8_t kind[2] = { (uint8_t)point.kind, (uint8_t)point.module };
+		uint32_t line = (uint32_t)point.line;
+		f_ret |= (fwrite( &t, sizeof(t), 1, file ) != 1);
+		f_ret |= (fwrite( kind, sizeof(kind), 1, file ) != 1);
+		f_ret |= (fwrite( &line, sizeof(line), 1, file ) != 1);
+		f_ret |= trace_put_string( file, point.file );
+		f_ret |= trace_put_string( file, point.function );
+		f_ret |= trace_put_string( file, point.format );
+	}
+	//Records of each ring
+	for (int t = 0;t < TRACE_MAX_RINGS;t++)
+	{
+		Trace_ring *ring = g_trace_ring[t].load( std::memory_order_acquire );
+		//If: slot never used
+		if (ring == nullptr)
+		{
+			continue;
+		}
+		uint32_t head = ring -> head.load( std::memory_order_acquire );
+		uint32_t first = (head > TRACE_RING_SIZE) ? (head -TRACE_RING_SIZE) : (0);
+		size_t start = records.size();
+		for (uint32_t index = first;index < head;index++)
+		{
+			records.push_back( ring -> record[ index & (TRACE_RING_SIZE -1) ] );
+		}
+		//The owner may have lapped the copy. Slot of head_now -TRACE_RING_SIZE and older were being overwritten
+		uint32_t head_now = ring -> head.load( std::memory_order_acquire );
+		uint32_t valid = (head_now +1 > TRACE_RING_SIZE) ? (head_now +1 -TRACE_RING_SIZE) : (0);
+		//If: some copied records are not reliable
+		if (valid > first)
+		{
+			size_t discard = ((valid -first) < (head -first)) ? (valid -first) : (head -first);
+			records.erase( records.begin() +start, records.begin() +start +discard );
+		}
+	}
+	uint32_t num_records = (uint32_t)records.size();
+	f_ret |= (fwrite( &num_records, sizeof(num_records), 1, file ) != 1);
+	f_ret |= (fwrite( records.data(), sizeof(Trace_record), num_records, file ) != num_records);
+	f_ret |= (fclose( file ) != 0);
+
+	return f_ret;
+}	//end function: trace_dump | const char *
+
+/***************************************************************************/
+//!	@brief Function
+//!	trace_set_level | int, int
+/***************************************************************************/
+//! @param module | TRACE_MODULE_*. TRACE_NUM_MODULES = all modules
+//! @param level | TRACE_LEVEL_*. Points up to this level are recorded
+//! @return bool | false = OK | true = bad module or level
+//!	@details
+//!	Takes effect on the next call of each point. Points already registered keep their id
+/***************************************************************************/
+
+bool trace_set_level( int module, int level )
+{
+	//If: bad arguments
+	if ((module < 0) || (module > TRACE_NUM_MODULES) || (level < TRACE_LEVEL_OFF) || (level >= TRACE_NUM_LEVELS))
+	{
+		return true;	//FAIL
+	}
+	//For: the selected modules
+	for (int t = ((module == TRACE_NUM_MODULES) ? (0) : (module));t < ((module == TRACE_NUM_MODULES) ? (TRACE_NUM_MODULES) : (module +1));t++)
+	{
+		g_trace_level[t].store( (uint8_t)level, std::memory_order_relaxed );
+	}
+	return false;	//OK
+}	//end function: trace_set_level | int, int
+
+/***************************************************************************/
+//!	@brief Function
+//!	trace_get_level | int
+/***************************************************************************/
+//! @param module | TRACE_MODULE_*
+//! @return int | TRACE_LEVEL_* of the module. -1 = bad module
+/***************************************************************************/
+
+int trace_get_level( int module )
+{
+	//If: bad module
+	if ((module < 0) || (module >= TRACE_NUM_MODULES))
+	{
+		return -1;	//FAIL
+	}
+	return g_trace_level[ module ].load( std::memory_order_relaxed );
+}	//end function: trace_get_level | int
+
+/***************************************************************************/
+//!	@brief Function
+//!	trace_dropped | void
+/***************************************************************************/
+//! @return uint32_t | records lost because all rings were taken or the point table was full
+/***************************************************************************/
+
+uint32_t trace_dropped( void )
+{
+	return g_trace_dropped.load( std::memory_order_relaxed );
+}	//end function: trace_dropped | void
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,240 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef TRACE_H_
+	#define TRACE_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Records kept by each thread. Power of two. The oldest records are overwritten
+#define TRACE_RING_SIZE			4096
+//Threads that can trace at the same time. A ring is reused when its thread exits
+#define TRACE_MAX_RINGS			16
+//Trace points that can be registered. Points beyond it are not recorded
+#define TRACE_MAX_POINTS		2048
+//Arguments stored by a record. Further arguments are dropped
+#define TRACE_MAX_ARGS			4
+//Dump file starts with the magic and the version
+#define TRACE_MAGIC				"OBTR"
+#define TRACE_VERSION			2
+//Id of a trace point not registered yet
+#define TRACE_ID_NONE			0
+//Id of a trace point that did not fit in the table
+#define TRACE_ID_OVERFLOW		0xffff
+
+//Modules. A file selects its module with #define TRACE_MODULE before using the macros
+#define TRACE_MODULE_PARSER		0
+#define TRACE_MODULE_PANOPTICON	1
+#define TRACE_MODULE_HANDLERS	2
+#define TRACE_MODULE_BINDINGS	3
+#define TRACE_MODULE_SERIAL		4
+#define TRACE_MODULE_OTHER		5
+#define TRACE_NUM_MODULES		6
+//Names of the modules, for JS and for the decoder
+#define TRACE_MODULE_NAMES		{ "parser", "panopticon", "handlers", "bindings", "serial", "other" }
+
+//Levels. A module records the points up to its level
+#define TRACE_LEVEL_OFF			0
+#define TRACE_LEVEL_ERROR		1	//Formats starting with ERR
+#define TRACE_LEVEL_INFO		2	//DPRINT
+#define TRACE_LEVEL_CALL		3	//DENTER, DRETURN
+#define TRACE_NUM_LEVELS		4
+//Names of the levels
+#define TRACE_LEVEL_NAMES		{ "off", "error", "info", "call" }
+//Level of all modules at start
+#define TRACE_LEVEL_DEFAULT		TRACE_LEVEL_ERROR
+
+//Files that don't select a module
+#ifndef TRACE_MODULE
+	#define TRACE_MODULE		TRACE_MODULE_OTHER
+#endif
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+//First argument of a list. The format of a trace point
+#define TRACE_FIRST( ... )			TRACE_FIRST_( __VA_ARGS__, 0 )
+#define TRACE_FIRST_( first, ... )	first
+
+//Trace point. One static descriptor per call site, the record only holds its id and the arguments
+//The level is a constant of the call site. A disabled point costs a byte load and a branch
+#define TRACE_POINT( kind, ... )	\
+	do	\
+	{	\
+		if (__builtin_expect( ::Orangebot::trace_level( (kind), TRACE_FIRST( __VA_ARGS__ ) ) <= ::Orangebot::g_trace_level[ TRACE_MODULE ].load( std::memory_order_relaxed ), 0 ))	\
+		{	\
+			static ::Orangebot::Trace_point _trace_point = { (kind), TRACE_MODULE, __FILE__, __LINE__, __FUNCTION__, nullptr, { TRACE_ID_NONE } };	\
+			::Orangebot::trace_record( _trace_point, __VA_ARGS__ );	\
+		}	\
+	}	\
+	while (0)
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace Orangebot namespace FOREVER!
+namespace Orangebot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//! What a trace point marks. The decoder indents the enter and return pairs
+typedef enum _Trace_kind
+{
+	TRACE_ENTER,			//DENTER, DENTER_ARG
+	TRACE_RETURN,			//DRETURN, DRETURN_ARG
+	TRACE_PRINT,			//DPRINT, DPRINT_NOTAB
+	TRACE_NUM_KINDS
+} Trace_kind;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//! Static descriptor of a call site. Strings are resolved by the decoder from the dump
+typedef struct _Trace_point
+{
+	//Trace_kind
+	int kind;
+	//TRACE_MODULE of the file
+	int module;
+	//Where the trace point is
+	const char *file;
+	int line;
+	const char *function;
+	//printf format of the arguments. nullptr = none. Set on registration
+	const char *format;
+	//Id in the dump. TRACE_ID_NONE until the first record
+	std::atomic<uint16_t> id;
+} Trace_point;
+
+//! Fixed size binary record. Native little endian layout in the dump
+typedef struct _Trace_record
+{
+	//Id of the trace point
+	uint16_t point;
+	//Arguments stored
+	uint8_t num_args;
+	uint8_t reserved;
+	//Linux thread id
+	uint32_t tid;
+	//CLOCK_MONOTONIC [ns]. Same clock as the session log and the telemetry
+	int64_t time_ns;
+	//Raw arguments. Integers sign or zero extended, doubles by bits, strings by their first 8 chars
+	uint64_t arg[ TRACE_MAX_ARGS ];
+} Trace_record;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+//Level of each module. Read by every trace point
+extern std::atomic<uint8_t> g_trace_level[ TRACE_NUM_MODULES ];
+
+/**********************************************************************************
+**	PROTOTYPE: FUNCTIONS
+**********************************************************************************/
+
+//Set the level of a module. TRACE_NUM_MODULES = all modules. false = OK
+extern bool trace_set_level( int module, int level );
+//Level of a module. -1 = bad module
+extern int trace_get_level( int module );
+
+//Append a record to the ring of the calling thread. Lock free, registers the point on its first use
+extern void trace_write( Trace_point &point, const char *format, const uint64_t *arg, int num_args );
+//Write the registered points and the records of all rings to a file. false = OK
+extern bool trace_dump( const char *path );
+//Records lost because all rings were taken
+extern uint32_t trace_dropped( void );
+
+/**********************************************************************************
+**	TEMPLATES
+**********************************************************************************/
+
+//Integers, bool, enums. Sign extended, the decoder truncates to the conversion
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, uint64_t>::type trace_arg( T value )
+{
+	return (uint64_t)(int64_t)value;
+}
+
+//Floating point. Stored by bits as a double
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, uint64_t>::type trace_arg( T value )
+{
+	double tmp = (double)value;
+	uint64_t ret;
+	memcpy( &ret, &tmp, sizeof(ret) );
+	return ret;
+}
+
+//Strings. The pointer means nothing offline, keep the first 8 chars
+inline uint64_t trace_arg( const char *value )
+{
+	uint64_t ret = 0;
+	if (value != nullptr)
+	{
+		memcpy( &ret, value, strnlen( value, sizeof(ret) ) );
+	}
+	return ret;
+}
+
+//Writable strings. Same as above, else the pointer template would be picked
+inline uint64_t trace_arg( char *value )
+{
+	return trace_arg( (const char *)value );
+}
+
+//Other pointers. Stored by address for %p
+template <typename T>
+inline uint64_t trace_arg( T *value )
+{
+	return (uint64_t)(uintptr_t)value;
+}
+
+//Level of a trace point. Constant for a literal format
+constexpr int trace_level( int kind, const char *format )
+{
+	return ((format != nullptr) && (format[0] == 'E') && (format[1] == 'R') && (format[2] == 'R')) ? (TRACE_LEVEL_ERROR) : ((kind == TRACE_PRINT) ? (TRACE_LEVEL_INFO) : (TRACE_LEVEL_CALL));
+}
+
+//No format
+constexpr int trace_level( int kind, std::nullptr_t )
+{
+	return (kind == TRACE_PRINT) ? (TRACE_LEVEL_INFO) : (TRACE_LEVEL_CALL);
+}
+
+//Collect the arguments of a trace point and write the record
+template <typename... Args>
+inline void trace_record( Trace_point &point, const char *format, Args... args )
+{
+	//Trailing 0 keeps the array valid with no arguments
+	const uint64_t arg[] = { trace_arg( args )..., 0 };
+	trace_write( point, format, arg, (int)sizeof...(Args) );
+}
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
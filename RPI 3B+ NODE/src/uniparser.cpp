@@ -64,6 +64,8 @@
 #include <cstdio>
 #include <stdint.h>
 //#define ENABLE_DEBUG
+//Trace module of this file
+#define TRACE_MODULE	TRACE_MODULE_PARSER
 #include "debug.h"
 //Class Header
 #include "uniparser.h"
@@ -48,7 +48,7 @@
 //!redudant checks meant for debug only
 #define UNIPARSER_PENDANTIC_CHECKS	false
 //!Maximum number of commands that can be registered
-#define UNIPARSER_MAX_CMD			16
+#define UNIPARSER_MAX_CMD			24
 //!Commands can have at most two arguments
 #define UNIPARSER_MAX_ARGS			4
 //!Size of argument vector. one byte for each identifier plus bytes for the raw data
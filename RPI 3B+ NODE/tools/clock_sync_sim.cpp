@@ -0,0 +1,183 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	clock_sync_sim
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Run Clock_sync against a simulated motor board
+**	The firmware RTC drifts, the UART adds random queueing delay to both messages
+**	Midway the firmware resets and its timestamps restart from zero
+**	Prints the drift estimate and the mapping error of each phase. Exit 1 if out of bounds
+**	Build:	g++ -std=c++14 -O2 -o clock_sync_sim clock_sync_sim.cpp ../src/clock_sync.cpp
+**	Use:	./clock_sync_sim [drift ppm] [reset: boot | jump]
+**	boot = the RPI sees LOG_BOOT and calls restart() | jump = detected by the timestamp going backwards
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+//Platform configuration. TIMESTAMP_HZ
+#include "../../orangebot_config.h"
+//Class under test
+#include "../src/clock_sync.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+using namespace Orangebot;
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Time between pings [ns]. Same as time_clock_sync of orangebot.js
+#define SIM_PING_NS			100000000LL
+//Duration of each phase [ns]
+#define SIM_PHASE_NS		10000000000LL
+//Time given to the fit after the start and after the reset [ns]
+#define SIM_SETTLE_NS		1000000000LL
+//Queueing delay of a message. Mostly short, sometimes stuck behind other traffic [ns]
+#define SIM_QUEUE_NS		200000LL
+#define SIM_QUEUE_LONG_NS	5000000LL
+//Bounds of a good mapping
+#define SIM_MAX_ERROR_NS	500000LL
+#define SIM_MAX_SKEW_ERR	20.0
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//! Simulated motor board
+typedef struct _Sim_firmware
+{
+	//RPI time of the firmware boot [ns]
+	int64_t boot_ns;
+	//Drift of the RTC [ppm]. Positive = runs fast
+	double drift_ppm;
+} Sim_firmware;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+//Deterministic pseudo random delay of a message [ns]
+static int64_t queue_delay( void )
+{
+	static uint32_t seed = 12345;
+	seed = seed *1103515245 +12345;
+	//One message in eight waits behind other traffic
+	if (((seed >> 16) & 0x07) == 0)
+	{
+		return (int64_t)((seed >> 8) % SIM_QUEUE_LONG_NS);
+	}
+	return (int64_t)((seed >> 8) % SIM_QUEUE_NS);
+}
+
+//Firmware timestamp at a RPI time
+static uint32_t fw_timestamp( const Sim_firmware &fw, int64_t now_ns )
+{
+	return (uint32_t)(int64_t)floor( (double)(now_ns -fw.boot_ns) *TIMESTAMP_HZ *(1.0 +fw.drift_ppm /1000000.0) /1000000000.0 );
+}
+
+//Ping the firmware every SIM_PING_NS from start to stop. Return the worst mapping error after the settle time [ns]
+static int64_t run_phase( Clock_sync &sync, const Sim_firmware &fw, int64_t start_ns, int64_t stop_ns, int byte_ns )
+{
+	//Worst error
+	int64_t worst_ns = 0;
+	//Ping message
+	char msg[32];
+	int length;
+	//Instants of a round trip
+	int64_t decode_ns, arrival_ns;
+	uint32_t timestamp;
+	//Firmware event mapped back
+	int64_t event_ns, error_ns;
+
+	for (int64_t now_ns = start_ns;now_ns < stop_ns;now_ns += SIM_PING_NS)
+	{
+		length = sync.request( now_ns, msg, sizeof(msg) );
+		//Ping on the wire, decoded by the firmware, answered with PONG<token>:<timestamp>
+		decode_ns = now_ns +length *byte_ns +queue_delay();
+		timestamp = fw_timestamp( fw, decode_ns );
+		arrival_ns = decode_ns +queue_delay() +(int64_t)(strlen( msg ) +2 +10) *byte_ns;
+		sync.reply( (uint32_t)atol( msg +4 ), timestamp, arrival_ns );
+		//If: settled. Map a firmware event half way to the next ping
+		if ((now_ns -start_ns >= SIM_SETTLE_NS) && (sync.is_synced() == true))
+		{
+			event_ns = now_ns +SIM_PING_NS /2;
+			error_ns = llabs( sync.to_local_ns( fw_timestamp( fw, event_ns ) ) -event_ns );
+			worst_ns = (error_ns > worst_ns) ? (error_ns) : (worst_ns);
+		}
+	}
+
+	return worst_ns;
+}
+
+int main( int argc, char *argv[] )
+{
+	//Clock under test
+	Clock_sync sync;
+	//Simulated firmware. Booted a while before the RPI process
+	Sim_firmware fw = { -3000000000LL, (argc > 1) ? (atof( argv[1] )) : (200.0) };
+	//Reset detection under test
+	bool f_boot = (argc > 2) ? (strcmp( argv[2], "boot" ) == 0) : (false);
+	//UART time of one byte [ns]
+	const int byte_ns = 10 *1000000000LL /256000;
+	//Results
+	int64_t error_ns;
+	double skew_err;
+	bool f_fail = false;
+
+	sync.set_baud( 256000 );
+	//Phase 1: steady drift
+	error_ns = run_phase( sync, fw, 0, SIM_PHASE_NS, byte_ns );
+	skew_err = fabs( sync.skew_ppm() -fw.drift_ppm );
+	printf( "drift %.1f ppm | estimate %.1f ppm | worst error %lld ns\n", fw.drift_ppm, sync.skew_ppm(), (long long)error_ns );
+	f_fail |= (error_ns > SIM_MAX_ERROR_NS) || (skew_err > SIM_MAX_SKEW_ERR);
+	//Phase 2: the firmware resets. Timestamps restart from zero
+	fw.boot_ns = SIM_PHASE_NS;
+	if (f_boot == true)
+	{
+		sync.restart();
+	}
+	error_ns = run_phase( sync, fw, SIM_PHASE_NS, 2 *SIM_PHASE_NS, byte_ns );
+	printf( "after reset (%s) | estimate %.1f ppm | worst error %lld ns | samples %d\n", (f_boot == true) ? ("LOG_BOOT") : ("timestamp jump"), sync.skew_ppm(), (long long)error_ns, sync.samples() );
+	f_fail |= (error_ns > SIM_MAX_ERROR_NS);
+
+	printf( "%s\n", (f_fail == true) ? ("FAIL") : ("OK") );
+	return (f_fail == true) ? (1) : (0);
+}
@@ -0,0 +1,150 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	odometry_bench
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Host benchmark of Odometry::update at 1 kHz
+**	The simulated encoders drive the platform on a circle, the pose is checked against the exact arc
+**	Then the geometry changes mid run, the heading must not jump
+**	Prints ns per update and the CPU share of a 1 kHz stream. Exit 1 if the pose is off
+**	Build:	g++ -std=c++14 -O2 -o odometry_bench odometry_bench.cpp ../src/odometry.cpp
+**	Use:	./odometry_bench [seconds]
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+//Platform configuration. NUM_ENC, LAYOUT_ENC_*
+#include "../../orangebot_config.h"
+//Class under test
+#include "../src/odometry.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+using namespace Orangebot;
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Updates per second of the encoder stream
+#define BENCH_RATE_HZ		1000
+//Default duration of the run [s]
+#define BENCH_SECONDS		600
+//Speed of each side [counts per update]
+#define BENCH_LEFT_CNT		3
+#define BENCH_RIGHT_CNT		5
+//Bounds of a good pose [mm] and [rad]
+#define BENCH_MAX_POS_ERR	1.0
+#define BENCH_MAX_JUMP		0.001
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+//Advance the encoders by one update. Reversed encoders count down
+static void step( int *enc_pos )
+{
+	for (int t = 0;t < NUM_ENC;t++)
+	{
+		int delta = ((LAYOUT_ENC_RIGHT & (1 << t)) != 0) ? (BENCH_RIGHT_CNT) : (BENCH_LEFT_CNT);
+		enc_pos[t] += ((LAYOUT_ENC_REVERSE & (1 << t)) != 0) ? (-delta) : (delta);
+	}
+}
+
+int main( int argc, char *argv[] )
+{
+	//Odometry under test
+	Odometry odo;
+	//Absolute counts of the simulated encoders. Start near the wrap of the counters
+	int enc_pos[ NUM_ENC ];
+	//Updates of the run
+	long updates = (long)((argc > 1) ? (atol( argv[1] )) : (BENCH_SECONDS)) *BENCH_RATE_HZ;
+	//Default geometry, as set by Odometry::init
+	const double cnt_per_mm = ENC_CNT_PER_TURN /(M_PI *WHEEL_DIAMETER_UM /1000.0);
+	const double track_mm = ODOMETRY_TRACK_UM /1000.0;
+	//Exact arc
+	double left_mm, right_mm, heading, radius, err;
+	//Heading before and after the geometry change
+	double heading_old, jump;
+	bool f_fail = false;
+
+	if (updates <= 0)
+	{
+		fprintf( stderr, "ERR: bad number of seconds\n" );
+		return 1;
+	}
+	for (int t = 0;t < NUM_ENC;t++)
+	{
+		enc_pos[t] = 2147483647 -1000;
+	}
+	odo.update( enc_pos );
+
+	//! Run
+	auto start = std::chrono::steady_clock::now();
+	for (long t = 0;t < updates;t++)
+	{
+		step( enc_pos );
+		odo.update( enc_pos );
+	}
+	auto stop = std::chrono::steady_clock::now();
+	double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>( stop -start ).count() /updates;
+	printf( "%ld updates | %.1f ns/update | %.4f%% CPU at %d Hz\n", updates, ns, ns *BENCH_RATE_HZ /1e7, BENCH_RATE_HZ );
+
+	//! Pose against the exact arc
+	left_mm = (double)BENCH_LEFT_CNT *updates /cnt_per_mm;
+	right_mm = (double)BENCH_RIGHT_CNT *updates /cnt_per_mm;
+	heading = (right_mm -left_mm) /track_mm;
+	radius = track_mm *(left_mm +right_mm) /(2.0 *(right_mm -left_mm));
+	err = hypot( odo.x() -radius *sin( heading ), odo.y() -radius *(1.0 -cos( heading )) );
+	printf( "pose x %.3f y %.3f heading %.6f | exact x %.3f y %.3f heading %.6f | error %.6f mm\n", odo.x(), odo.y(), odo.heading(), radius *sin( heading ), radius *(1.0 -cos( heading )), heading, err );
+	f_fail |= (err > BENCH_MAX_POS_ERR) || (fabs( odo.heading() -heading ) > BENCH_MAX_JUMP);
+
+	//! Geometry change. One more update must turn by a single step only
+	heading_old = odo.heading();
+	odo.set_geometry( cnt_per_mm *1.1, track_mm *0.9 );
+	step( enc_pos );
+	odo.update( enc_pos );
+	jump = fabs( odo.heading() -heading_old );
+	printf( "geometry change | heading step %.6f rad\n", jump );
+	f_fail |= (jump > BENCH_MAX_JUMP);
+
+	printf( "%s\n", (f_fail == true) ? ("FAIL") : ("OK") );
+	return (f_fail == true) ? (1) : (0);
+}
@@ -0,0 +1,141 @@
+//-----------------------------------------------------------------------------------
+//	DESCRIPTION
+//-----------------------------------------------------------------------------------
+//	Load test of the robot status fan out
+//	Opens one telemetry viewer, then dozens, and prints the server CPU of each phase
+//	The status is serialized once per event whatever the number of viewers, the CPU should stay flat
+//	Run on the RPI next to a running orangebot.js. Linux only, reads /proc
+//	Use:	node tools/telemetry_load.js <server pid> [viewers] [seconds] [host]
+//	Example:	node tools/telemetry_load.js $(pgrep -f orangebot.js) 50 10
+//
+
+//-----------------------------------------------------------------------------------
+//	INCLUDE
+//-----------------------------------------------------------------------------------
+
+//file system library. Used to read the CPU time of the server
+const fs = require("fs");
+//child process library. Used to get the clock ticks of /proc
+const child_process = require("child_process");
+//Websocket client. Same library as the server
+const websocket = require("ws");
+
+//-----------------------------------------------------------------------------------
+//	CONFIGURATION
+//-----------------------------------------------------------------------------------
+
+//Binary telemetry port of orangebot.js
+const websocket_telemetry_port = 8083;
+//Process under test
+const server_pid = parseInt( process.argv[2] );
+//Viewers of the loaded phase
+const num_viewers = (process.argv.length > 3) ? (parseInt( process.argv[3] )) : (50);
+//Duration of each phase [s]
+const phase_s = (process.argv.length > 4) ? (parseInt( process.argv[4] )) : (10);
+//Server address
+const server_host = (process.argv.length > 5) ? (process.argv[5]) : ("localhost");
+//Clock ticks per second of the /proc CPU times
+var clk_tck = 100;
+
+//-----------------------------------------------------------------------------------
+//	FUNCTIONS
+//-----------------------------------------------------------------------------------
+
+//CPU time of the server, user plus system [clock ticks]
+function get_server_cpu_ticks()
+{
+	//The name may hold spaces, fields are counted after its closing parenthesis
+	var stat = fs.readFileSync( "/proc/" +server_pid +"/stat", "utf8" );
+	var fields = stat.slice( stat.lastIndexOf( ")" ) +2 ).split( " " );
+	//utime and stime are fields 14 and 15 of the file
+	return parseInt( fields[11] ) +parseInt( fields[12] );
+}
+
+//Open the viewers, wait the phase, close them. Calls done with the server CPU [%] and the frames per second of each viewer
+function run_phase( viewers, done )
+{
+	var sockets = [];
+	var frames = 0;
+	var connected = 0;
+	var cpu_start;
+	var time_start;
+
+	for (var t = 0;t < viewers;t++)
+	{
+		var socket = new websocket( "ws://" +server_host +":" +websocket_telemetry_port );
+		socket.on( "message", function() { frames++; } );
+		socket.on( "error", function(err) { console.log("ERR: viewer: ", err.message); process.exit(1); } );
+		socket.on
+		(
+			"open",
+			function()
+			{
+				connected++;
+				//If: all viewers connected. Start measuring
+				if (connected == viewers)
+				{
+					frames = 0;
+					cpu_start = get_server_cpu_ticks();
+					time_start = process.hrtime.bigint();
+					setTimeout( stop_phase, phase_s *1000 );
+				}
+			}
+		);
+		sockets.push( socket );
+	}
+
+	function stop_phase()
+	{
+		var cpu = get_server_cpu_ticks() -cpu_start;
+		var elapsed_s = Number( process.hrtime.bigint() -time_start ) /1e9;
+		sockets.forEach( function(socket) { socket.terminate(); } );
+		done( (100.0 *cpu /clk_tck) /elapsed_s, frames /viewers /elapsed_s );
+	}
+}
+
+//-----------------------------------------------------------------------------------
+//	BODY
+//-----------------------------------------------------------------------------------
+
+//If: no server to measure
+if ((isNaN( server_pid ) == true) || (fs.existsSync( "/proc/" +server_pid ) == false))
+{
+	console.log("ERR: Use: node tools/telemetry_load.js <server pid> [viewers] [seconds] [host]");
+	process.exit(1);
+}
+if ((isNaN( num_viewers ) == true) || (num_viewers < 1) || (isNaN( phase_s ) == true) || (phase_s < 1))
+{
+	console.log("ERR: bad number of viewers or seconds");
+	process.exit(1);
+}
+try
+{
+	clk_tck = parseInt( child_process.execSync( "getconf CLK_TCK" ).toString() );
+}
+catch (err)
+{
+	console.log("WARN: getconf failed, assuming " +clk_tck +" clock ticks per second");
+}
+
+run_phase
+(
+	1,
+	function( cpu_single, fps_single )
+	{
+		console.log("1 viewer   | server CPU " +cpu_single.toFixed(1) +"% | " +fps_single.toFixed(1) +" frames/s per viewer");
+		run_phase
+		(
+			num_viewers,
+			function( cpu_loaded, fps_loaded )
+			{
+				console.log(num_viewers +" viewers | server CPU " +cpu_loaded.toFixed(1) +"% | " +fps_loaded.toFixed(1) +" frames/s per viewer");
+				//If: no status event during the test, the CPU says nothing about the fan out
+				if (fps_single <= 0)
+				{
+					console.log("WARN: no status frames. Is the robot connected or a session replayed?");
+				}
+				process.exit(0);
+			}
+		);
+	}
+);
@@ -0,0 +1,353 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	trace_decode
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Decode a dump written by trace_dump into the debug.log text of ENABLE_DEBUG
+**	Records of all threads are merged by time. Each line:
+**	time [us] from the first record | thread id | module | indent | text
+**	Build:	g++ -std=c++14 -O2 -o trace_decode trace_decode.cpp
+**	Use:	./trace_decode trace.bin [thread id] [module]
+**	thread id 0 = all threads
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**	%s shows only the first 8 chars of the string
+**	* width and precision are not supported
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+//Record format
+#include "../src/trace.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+using namespace Orangebot;
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//! Trace point as read from the dump
+typedef struct _Point
+{
+	int kind;
+	int module;
+	int line;
+	std::string file;
+	std::string function;
+	std::string format;
+} Point;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+//Read a string written as length and chars. false = OK
+static bool get_string( FILE *file, std::string &str )
+{
+	uint16_t length;
+	if (fread( &length, sizeof(length), 1, file ) != 1)
+	{
+		return true;	//FAIL
+	}
+	str.resize( length );
+	return ((length > 0) && (fread( &str[0], 1, length, file ) != length));
+}
+
+//Expand the printf format with the raw arguments of a record
+static std::string format_record( const std::string &format, const Trace_record &record )
+{
+	//Output
+	std::string out;
+	//One conversion specifier
+	std::string spec;
+	//Formatted conversion
+	char buf[256];
+	//Next argument
+	int arg_index = 0;
+	//Scan position
+	size_t t = 0;
+
+	while (t < format.size())
+	{
+		//If: plain char
+		if (format[t] != '%')
+		{
+			out += format[t++];
+			continue;
+		}
+		//If: literal %
+		if ((t +1 < format.size()) && (format[t +1] == '%'))
+		{
+			out += '%';
+			t += 2;
+			continue;
+		}
+		//Flags, width, precision. Length modifiers are dropped, the argument is 64 bit
+		spec = "%";
+		t++;
+		while ((t < format.size()) && (strchr( "-+ #0123456789.", format[t] ) != nullptr))
+		{
+			spec += format[t++];
+		}
+		while ((t < format.size()) && (strchr( "hlLqjzt", format[t] ) != nullptr))
+		{
+			t++;
+		}
+		//If: format ends inside the specifier
+		if (t >= format.size())
+		{
+			break;
+		}
+		char conversion = format[t++];
+		//If: argument was not recorded
+		if (arg_index >= record.num_args)
+		{
+			out += "?";
+			continue;
+		}
+		uint64_t arg = record.arg[ arg_index++ ];
+		switch (conversion)
+		{
+			case 'd':
+			case 'i':
+			{
+				snprintf( buf, sizeof(buf), (spec +"lld").c_str(), (long long)arg );
+				break;
+			}
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+			{
+				//Sign extended on record. Small negative ints print as 32 bit like printf did
+				uint64_t value = ((int64_t)arg < 0) && ((int64_t)arg >= INT32_MIN) ? (arg & 0xffffffffULL) : (arg);
+				snprintf( buf, sizeof(buf), (spec +"ll" +conversion).c_str(), (unsigned long long)value );
+				break;
+			}
+			case 'c':
+			{
+				snprintf( buf, sizeof(buf), (spec +"c").c_str(), (int)(char)arg );
+				break;
+			}
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+			{
+				double value;
+				memcpy( &value, &arg, sizeof(value) );
+				snprintf( buf, sizeof(buf), (spec +conversion).c_str(), value );
+				break;
+			}
+			case 's':
+			{
+				char str[ sizeof(arg) +1 ] = { 0 };
+				memcpy( str, &arg, sizeof(arg) );
+				snprintf( buf, sizeof(buf), (spec +"s").c_str(), str );
+				break;
+			}
+			case 'p':
+			{
+				snprintf( buf, sizeof(buf), "0x%llx", (unsigned long long)arg );
+				break;
+			}
+			default:
+			{
+				snprintf( buf, sizeof(buf), "%%%c", conversion );
+				break;
+			}
+		}
+		out += buf;
+	}
+	//One record per line
+	while ((out.size() > 0) && (out.back() == '\n'))
+	{
+		out.pop_back();
+	}
+	return out;
+}
+
+/****************************************************************************
+**	MAIN
+****************************************************************************/
+
+int main( int argc, char *argv[] )
+{
+	//Dump file
+	FILE *file;
+	//Header
+	char magic[4];
+	uint16_t header[2];
+	//Points by id
+	std::map<uint16_t, Point> points;
+	//Records
+	std::vector<Trace_record> records;
+	//Only this thread. 0 = all
+	uint32_t tid_filter = 0;
+	//Names of the modules
+	const char *module_name[ TRACE_NUM_MODULES ] = TRACE_MODULE_NAMES;
+	//Only this module. -1 = all
+	int module_filter = -1;
+	//Indent of each thread
+	std::map<uint32_t, int> indent;
+	uint32_t num;
+
+	if ((argc < 2) || (argc > 4))
+	{
+		fprintf( stderr, "Use: %s trace.bin [thread id] [module]\n", argv[0] );
+		return 1;
+	}
+	if (argc >= 3)
+	{
+		tid_filter = (uint32_t)strtoul( argv[2], nullptr, 0 );
+	}
+	if (argc == 4)
+	{
+		for (int t = 0;t < TRACE_NUM_MODULES;t++)
+		{
+			if (strcmp( argv[3], module_name[t] ) == 0)
+			{
+				module_filter = t;
+			}
+		}
+		if (module_filter < 0)
+		{
+			fprintf( stderr, "ERR: unknown module %s\n", argv[3] );
+			return 1;
+		}
+	}
+	file = fopen( argv[1], "rb" );
+	if (file == nullptr)
+	{
+		fprintf( stderr, "ERR: can't open %s\n", argv[1] );
+		return 1;
+	}
+	//Header
+	if ((fread( magic, 1, 4, file ) != 4) || (memcmp( magic, TRACE_MAGIC, 4 ) != 0) || (fread( header, sizeof(header), 1, file ) != 1) || (header[0] != TRACE_VERSION))
+	{
+		fprintf( stderr, "ERR: %s is not a trace dump of version %d\n", argv[1], TRACE_VERSION );
+		return 1;
+	}
+	//Points
+	if (fread( &num, sizeof(num), 1, file ) != 1)
+	{
+		fprintf( stderr, "ERR: truncated dump\n" );
+		return 1;
+	}
+	for (uint32_t t = 0;t < num;t++)
+	{
+		uint16_t id;
+		uint8_t kind[2];
+		uint32_t line;
+		Point point;
+		if ((fread( &id, sizeof(id), 1, file ) != 1) || (fread( kind, sizeof(kind), 1, file ) != 1) || (fread( &line, sizeof(line), 1, file ) != 1) ||
+			(get_string( file, point.file ) == true) || (get_string( file, point.function ) == true) || (get_string( file, point.format ) == true))
+		{
+			fprintf( stderr, "ERR: truncated dump\n" );
+			return 1;
+		}
+		point.kind = kind[0];
+		point.module = (kind[1] < TRACE_NUM_MODULES) ? (kind[1]) : (TRACE_MODULE_OTHER);
+		point.line = (int)line;
+		points[id] = point;
+	}
+	//Records
+	if (fread( &num, sizeof(num), 1, file ) != 1)
+	{
+		fprintf( stderr, "ERR: truncated dump\n" );
+		return 1;
+	}
+	records.resize( num );
+	if ((num > 0) && (fread( records.data(), sizeof(Trace_record), num, file ) != num))
+	{
+		fprintf( stderr, "ERR: truncated dump\n" );
+		return 1;
+	}
+	fclose( file );
+	//Merge the threads
+	std::stable_sort( records.begin(), records.end(), []( const Trace_record &a, const Trace_record &b ) { return a.time_ns < b.time_ns; } );
+	//Print
+	for (const Trace_record &record : records)
+	{
+		if ((tid_filter != 0) && (record.tid != tid_filter))
+		{
+			continue;
+		}
+		auto point = points.find( record.point );
+		if (point == points.end())
+		{
+			printf( "%12.3f %6u ERR: unknown point %u\n", (record.time_ns -records[0].time_ns) /1000.0, record.tid, record.point );
+			continue;
+		}
+		if ((module_filter >= 0) && (point -> second.module != module_filter))
+		{
+			continue;
+		}
+		int &level = indent[ record.tid ];
+		//Same layout as debug.log
+		if (point -> second.kind == TRACE_RETURN)
+		{
+			level = (level > 0) ? (level -1) : (0);
+		}
+		std::string text = format_record( point -> second.format, record );
+		printf( "%12.3f %6u %-10s %.*s", (record.time_ns -records[0].time_ns) /1000.0, record.tid, module_name[ point -> second.module ], level, "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t" );
+		if (point -> second.kind == TRACE_ENTER)
+		{
+			printf( "-->> \"%s\" | %s\n", point -> second.function.c_str(), text.c_str() );
+			level = (level < 32) ? (level +1) : (32);
+		}
+		else if (point -> second.kind == TRACE_RETURN)
+		{
+			printf( "<<-- \"%s\" | %s\n", point -> second.function.c_str(), text.c_str() );
+		}
+		else
+		{
+			printf( "%s\n", text.c_str() );
+		}
+	}
+
+	return 0;
+}	//end main
@@ -0,0 +1,168 @@
+#ifndef ORANGEBOT_CONFIG_H
+	//header environment variable, is used to detect multiple inclusion
+	//of the same header, and can be used in the c file to detect the
+	//included library
+	#define ORANGEBOT_CONFIG_H
+
+	/****************************************************************************
+	**	DESCRIPTION
+	*****************************************************************************
+	**	Platform configuration shared by the AT4809 firmware and the RPI 3B+ NODE module
+	**	Both sides of the serial link must agree on number of motors and encoders
+	**	since they drive message formats, ISR decoding and NODE.JS status arrays
+	**	Keep this header free of includes and of target specific code
+	****************************************************************************/
+
+	/****************************************************************************
+	**	DEFINE
+	****************************************************************************/
+
+		///----------------------------------------------------------------------
+		///	PLATFORM LAYOUT
+		///----------------------------------------------------------------------
+
+	//Number of VNH7040 DC Motor drivers installed
+	#define NUM_VNH7040				4
+	//Number of quadrature encoders. Two pins each on PORTC of the AT4809
+	#define NUM_ENC					4
+
+		///----------------------------------------------------------------------
+		///	ENCODER LAYOUT
+		///----------------------------------------------------------------------
+
+	//Encoders on the right side of the platform. The others are on the left side. Same as the motor layout
+	#define LAYOUT_ENC_RIGHT		((1<<0) | (1<<2))
+	//Encoders that count down when the platform moves forward. Right side motors are mounted mirrored
+	#define LAYOUT_ENC_REVERSE		((1<<0) | (1<<2))
+	//Encoder counts per wheel turn. 300 pulses x4 quadrature decoding x5.25 reducer
+	#define ENC_CNT_PER_TURN		6300
+	//Wheel diameter [um]
+	#define WHEEL_DIAMETER_UM		127000
+
+		///----------------------------------------------------------------------
+		///	TIMESTAMP
+		///----------------------------------------------------------------------
+
+	//Firmware timestamp ticks per second. RTC counter clocked by the internal 32.768KHz oscillator
+	//Telemetry is preceded by TIME<timestamp>:<sequence>. Timestamp is 32 bit and wraps after 36 hours
+	#define TIMESTAMP_HZ			32768
+
+		///----------------------------------------------------------------------
+		///	CURRENT SENSE
+		///----------------------------------------------------------------------
+		//	CUR<cur0>:<cur1>:<cur2>:<cur3> carries the filtered ADC counts of the VNH7040 sense outputs
+		//	I_motor = V_sense /R_sense *K. V_sense = count /CURRENT_ADC_FULL_SCALE *VDD
+		//	Defaults assume 5V VDD and the sense resistor of the driver board. Calibrate on the platform
+
+	//Accumulated result of four 10 bit conversions
+	#define CURRENT_ADC_FULL_SCALE	4092
+	//ADC reference. VDD of the AT4809 [mV]
+	#define CURRENT_VREF_MV			5000
+	//Sense resistor from the VNH7040 CS pin to ground [Ohm]
+	#define CURRENT_SENSE_R_OHM		1000
+	//Output current to sense current ratio of the VNH7040
+	#define CURRENT_SENSE_K			2860
+	//Motor current of one count [uA]
+	#define CURRENT_UA_PER_CNT		((1000ULL *CURRENT_VREF_MV *CURRENT_SENSE_K) /((unsigned long long)CURRENT_ADC_FULL_SCALE *CURRENT_SENSE_R_OHM))
+
+		///----------------------------------------------------------------------
+		///	VNH7040 DIAGNOSTIC
+		///----------------------------------------------------------------------
+		//	SEL1 (PF1) high switches the MultiSense of all drivers from current to diagnostic
+		//	SEL0 is wired to INA: a driver with INA low reports the chip temperature, with INA high its VCC /4
+		//	DIAG<code0>:<code1>:<code2>:<code3> carries a DIAG_* bit field for each driver
+
+	#define DIAG_OK					0x00
+	#define DIAG_FAULT				0x01	//MultiSense saturated in current mode. The driver latched a fault
+	#define DIAG_OVERTEMP			0x02	//Chip temperature above DIAG_TCHIP_WARN_C
+	#define DIAG_VCC				0x04	//Supply outside DIAG_VCC_MIN_MV to DIAG_VCC_MAX_MV
+	#define DIAG_TCHIP				0x08	//Last sweep read the chip temperature. VCC otherwise
+	//MultiSense voltage of the chip temperature at 25C [mV] and its slope [uV/K]. It falls with temperature
+	#define DIAG_TCHIP_25C_MV		2070
+	#define DIAG_TCHIP_UV_PER_K		5500
+	//Chip temperature warning [C]. The driver shuts down on its own at about 150C
+	#define DIAG_TCHIP_WARN_C		130
+	//Supply range [mV]
+	#define DIAG_VCC_MIN_MV			7000
+	#define DIAG_VCC_MAX_MV			18000
+
+		///----------------------------------------------------------------------
+		///	FIRMWARE LOG
+		///----------------------------------------------------------------------
+		//	LOG<id>:<arg0>:<arg1> at a lower priority than the control replies
+		//	The firmware sends only the id and two S16 arguments. The RPI owns the text
+
+	#define LOG_BOOT				0	//arg0 = RSTCTRL.RSTFR, arg1 = FUSE.BODCFG
+	#define LOG_DROPPED				1	//arg0 = messages lost since the last one sent
+	#define LOG_TIMEOUT				2	//arg0 = communication timeouts since boot
+	#define LOG_PARSER_ERR			3	//arg0 = Uniparser error code
+	#define LOG_CTRL_TICK_REFUSED	4	//arg0 = period requested [us]
+	#define LOG_PWM_PARAM_REFUSED	5	//arg0 = PWM channel
+	#define LOG_ENC_RETRY			6	//arg0 = encoder update retries
+	#define LOG_MOTOR_STALL			7	//arg0 = VNH7040 channel, arg1 = filtered current [ADC counts]
+	#define LOG_CUR_LIMIT_REFUSED	8	//arg0 = current limit [mA], arg1 = stall current [mA]
+	#define LOG_BROWNOUT			9	//arg0 = brownouts since boot
+	#define LOG_MOTION_EXPIRED		10	//arg0 = validity of a motion command [ms]
+	#define LOG_CONFIG				11	//arg0 = Config_status of the load at boot, arg1 = version found in EEPROM
+	#define LOG_CFG_REFUSED			12	//arg0 = CFG_* id, arg1 = value refused
+	#define LOG_CALIB				13	//arg0 = VNH7040 channel, arg1 = static friction offset [PWM]. -1 = did not move, table unchanged
+	#define LOG_NUM_ID				14
+	//Text of each log id. Expanded only by the RPI. Always given both arguments
+	#define LOG_FORMATS	\
+	{	\
+		"boot | reset flags: 0x%02x | BOD fuse: 0x%02x",	\
+		"%d log messages dropped",	\
+		"communication timeout | since boot: %d",	\
+		"parser error: %d",	\
+		"control tick refused: %d us",	\
+		"PWM parameters refused | channel: %d",	\
+		"encoder update failed | retries: %d",	\
+		"motor stall | channel: %d | current: %d counts",	\
+		"current limit refused | limit: %d mA | stall: %d mA",	\
+		"supply low, motors stopped | since boot: %d",	\
+		"motion command expired, motors stopped | window: %d ms",	\
+		"config | status: %d | version found: %d",	\
+		"config refused | id: %d | value: %d",	\
+		"calibration | channel: %d | static friction: %d PWM"	\
+	}
+
+		///----------------------------------------------------------------------
+		///	CONFIGURATION
+		///----------------------------------------------------------------------
+		//	Parameters of the motor board kept in its EEPROM. Defaults in global.h of the firmware
+		//	CFG_SET<id>:<value> and CFG_GET<id> answer CFG<id>:<value> with the value in use
+		//	CFG_SAVE writes the parameters in EEPROM and answers CFG_SAVE<crc> once written
+
+	#define CFG_PWM_MIN				0	//Static friction offset of the default linearization tables. Setting it discards the calibration
+	#define CFG_PWM_MAX				1	//PWM limit of the HAL
+	#define CFG_PWM_ACCEL			2	//Slope moving away from zero [PWM per control tick]. Applied to all channels
+	#define CFG_PWM_DECEL			3	//Slope moving toward zero [PWM per control tick]. Applied to all channels
+	#define CFG_LAYOUT_REVERSE		4	//Bit mask of the motors driven in reverse to move forward
+	#define CFG_ENC_UPDATE_TH		5	//Encoder ISR counts that force the sync of the 32b counters
+	#define CFG_LINK_TIMEOUT		6	//Link timeout [housekeeping ticks]
+	#define CFG_MOTION_TIMEOUT		7	//Validity of a motion command [ms]
+	#define CFG_NUM_ID				8
+
+		///----------------------------------------------------------------------
+		///	SIGNATURE
+		///----------------------------------------------------------------------
+
+	//Maximum size of a signature string
+	#define MAX_SIGNATURE_LENGTH	32
+
+		///----------------------------------------------------------------------
+		///	CHECKS
+		///----------------------------------------------------------------------
+
+	//PORTC hosts at most four encoders. Speed messages exist in dual (ENC_SPD_DUAL) and quad (ENC_SPD) form
+	#if (NUM_ENC != 2) && (NUM_ENC != 4)
+		#error "NUM_ENC must be 2 or 4"
+	#endif
+	//The AT4809 has four TCB PWM generators
+	#if (NUM_VNH7040 < 1) || (NUM_VNH7040 > 4)
+		#error "NUM_VNH7040 must be between 1 and 4"
+	#endif
+
+#else
+	#warning "multiple inclusion of the header file orangebot_config.h"
+#endif